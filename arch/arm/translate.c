@@ -30,6 +30,7 @@
 #include "tb-helper.h"
 
 #include "debug.h"
+#include "tcg-op-gvec.h"
 
 #define abort() do { cpu_abort(cpu, "ABORT at %s : %d\n", __FILE__, __LINE__); } while (0)
 
@@ -202,31 +203,6 @@ static void gen_revsh(TCGv var)
     tcg_gen_ext16s_i32(var, var);
 }
 
-/* Unsigned bitfield extract.  */
-static void gen_ubfx(TCGv var, int shift, uint32_t mask)
-{
-    if (shift) {
-        tcg_gen_shri_i32(var, var, shift);
-    }
-    tcg_gen_andi_i32(var, var, mask);
-}
-
-/* Signed bitfield extract.  */
-static void gen_sbfx(TCGv var, int shift, int width)
-{
-    uint32_t signbit;
-
-    if (shift) {
-        tcg_gen_sari_i32(var, var, shift);
-    }
-    if (shift + width < 32) {
-        signbit = 1u << (width - 1);
-        tcg_gen_andi_i32(var, var, (1u << width) - 1);
-        tcg_gen_xori_i32(var, var, signbit);
-        tcg_gen_subi_i32(var, var, signbit);
-    }
-}
-
 /* Bitfield insertion.  Insert val into base.  Clobbers base and val.  */
 static void gen_bfi(TCGv dest, TCGv base, TCGv val, int shift, uint32_t mask)
 {
@@ -4714,6 +4690,69 @@ static const uint8_t neon_2rm_sizes[] = {
     [NEON_2RM_VCVT_SF] = 0x4, [NEON_2RM_VCVT_UF] = 0x4,
 };
 
+/* Expand the whole-register integer forms of a three register same length
+   instruction as generic vector operations. Return nonzero if the
+   instruction has to go through the per-pass code instead.  */
+static int gen_neon_3r_gvec(int op, int u, int size, int q, int rd, int rn, int rm)
+{
+    uint32_t oprsz = q ? 16 : 8;
+    uint32_t dofs = vfp_reg_offset(1, rd);
+    uint32_t aofs = vfp_reg_offset(1, rn);
+    uint32_t bofs = vfp_reg_offset(1, rm);
+
+    switch (op) {
+    case NEON_3R_VADD_VSUB:
+        if (u) {
+            tcg_gen_gvec_sub(size, dofs, aofs, bofs, oprsz);
+        } else {
+            tcg_gen_gvec_add(size, dofs, aofs, bofs, oprsz);
+        }
+        return 0;
+    case NEON_3R_LOGIC:
+        switch ((u << 2) | size) {
+        case 0: /* VAND */
+            tcg_gen_gvec_and(VECE_64, dofs, aofs, bofs, oprsz);
+            return 0;
+        case 1: /* VBIC */
+            tcg_gen_gvec_andc(VECE_64, dofs, aofs, bofs, oprsz);
+            return 0;
+        case 2: /* VORR */
+            tcg_gen_gvec_or(VECE_64, dofs, aofs, bofs, oprsz);
+            return 0;
+        case 3: /* VORN */
+            tcg_gen_gvec_orc(VECE_64, dofs, aofs, bofs, oprsz);
+            return 0;
+        case 4: /* VEOR */
+            tcg_gen_gvec_xor(VECE_64, dofs, aofs, bofs, oprsz);
+            return 0;
+        default: /* VBSL, VBIT, VBIF */
+            return 1;
+        }
+    case NEON_3R_VMUL:
+        if (u) {
+            /* polynomial */
+            return 1;
+        }
+        tcg_gen_gvec_mul(size, dofs, aofs, bofs, oprsz);
+        return 0;
+    case NEON_3R_VTST_VCEQ:
+        if (!u) {
+            /* VTST */
+            return 1;
+        }
+        tcg_gen_gvec_cmp(TCG_COND_EQ, size, dofs, aofs, bofs, oprsz);
+        return 0;
+    case NEON_3R_VCGT:
+        tcg_gen_gvec_cmp(u ? TCG_COND_GTU : TCG_COND_GT, size, dofs, aofs, bofs, oprsz);
+        return 0;
+    case NEON_3R_VCGE:
+        tcg_gen_gvec_cmp(u ? TCG_COND_GEU : TCG_COND_GE, size, dofs, aofs, bofs, oprsz);
+        return 0;
+    default:
+        return 1;
+    }
+}
+
 /* Translate a NEON data processing instruction.  Return nonzero if the
    instruction is invalid.
    We process data in a mixture of 32-bit and 64-bit chunks.
@@ -4757,6 +4796,9 @@ static int disas_neon_data_insn(CPUState *env, DisasContext *s, uint32_t insn)
         if (q && ((rd | rn | rm) & 1)) {
             return 1;
         }
+        if (!gen_neon_3r_gvec(op, u, size, q, rd, rn, rm)) {
+            return 0;
+        }
         if (size == 3 && op != NEON_3R_LOGIC) {
             /* 64-bit element instructions. */
             for (pass = 0; pass < (q ? 2 : 1); pass++) {
@@ -6040,6 +6082,14 @@ static int disas_neon_data_insn(CPUState *env, DisasContext *s, uint32_t insn)
                 if ((op != NEON_2RM_VMOVN && op != NEON_2RM_VQMOVN) && q && ((rm | rd) & 1)) {
                     return 1;
                 }
+                if (op == NEON_2RM_VMVN || op == NEON_2RM_VNEG) {
+                    if (op == NEON_2RM_VMVN) {
+                        tcg_gen_gvec_not(VECE_64, vfp_reg_offset(1, rd), vfp_reg_offset(1, rm), q ? 16 : 8);
+                    } else {
+                        tcg_gen_gvec_neg(size, vfp_reg_offset(1, rd), vfp_reg_offset(1, rm), q ? 16 : 8);
+                    }
+                    return 0;
+                }
                 switch (op) {
                 case NEON_2RM_VREV64:
                     for (pass = 0; pass < (q ? 2 : 1); pass++) {
@@ -6219,7 +6269,7 @@ elementwise:
                             switch (size) {
                             case 0: gen_helper_neon_clz_u8(tmp, tmp); break;
                             case 1: gen_helper_neon_clz_u16(tmp, tmp); break;
-                            case 2: gen_helper_clz(tmp, tmp); break;
+                            case 2: tcg_gen_clzi_i32(tmp, tmp, 32); break;
                             default: abort();
                             }
                             break;
@@ -6861,6 +6911,10 @@ static void disas_arm_insn(CPUState *env, DisasContext *s)
                 return;
             case 4: /* dsb */
             case 5: /* dmb */
+                ARCH(7);
+                tcg_gen_mb(TCG_MO_ALL);
+                gen_barrier(s);
+                return;
             case 6: /* isb */
                 ARCH(7);
                 gen_barrier(s);
@@ -7105,7 +7159,7 @@ static void disas_arm_insn(CPUState *env, DisasContext *s)
                 ARCH(5);
                 rd = (insn >> 12) & 0xf;
                 tmp = load_reg(s, rm);
-                gen_helper_clz(tmp, tmp);
+                tcg_gen_clzi_i32(tmp, tmp, 32);
                 store_reg(s, rd, tmp);
             } else {
                 goto illegal_op;
@@ -7899,9 +7953,9 @@ static void disas_arm_insn(CPUState *env, DisasContext *s)
                         }
                         if (i < 32) {
                             if (op1 & 0x20) {
-                                gen_ubfx(tmp, shift, (1u << i) - 1);
+                                tcg_gen_extract_i32(tmp, tmp, shift, i);
                             } else {
-                                gen_sbfx(tmp, shift, i);
+                                tcg_gen_sextract_i32(tmp, tmp, shift, i);
                             }
                         }
                         store_reg(s, rd, tmp);
@@ -8662,7 +8716,7 @@ static int disas_thumb2_insn(CPUState *env, DisasContext *s, uint16_t insn_hw1)
                     tcg_temp_free_i32(tmp2);
                     break;
                 case 0x18: /* clz */
-                    gen_helper_clz(tmp, tmp);
+                    tcg_gen_clzi_i32(tmp, tmp, 32);
                     break;
                 default:
                     goto illegal_op;
@@ -8953,6 +9007,9 @@ static int disas_thumb2_insn(CPUState *env, DisasContext *s, uint16_t insn_hw1)
                             break;
                         case 4: /* dsb */
                         case 5: /* dmb */
+                            tcg_gen_mb(TCG_MO_ALL);
+                            gen_barrier(s);
+                            break;
                         case 6: /* isb */
                             gen_barrier(s);
                             /* These execute as NOPs.  */
@@ -9045,7 +9102,7 @@ static int disas_thumb2_insn(CPUState *env, DisasContext *s, uint16_t insn_hw1)
                             goto illegal_op;
                         }
                         if (imm < 32) {
-                            gen_sbfx(tmp, shift, imm);
+                            tcg_gen_sextract_i32(tmp, tmp, shift, imm);
                         }
                         break;
                     case 6: /* Unsigned bitfield extract.  */
@@ -9054,7 +9111,7 @@ static int disas_thumb2_insn(CPUState *env, DisasContext *s, uint16_t insn_hw1)
                             goto illegal_op;
                         }
                         if (imm < 32) {
-                            gen_ubfx(tmp, shift, (1u << imm) - 1);
+                            tcg_gen_extract_i32(tmp, tmp, shift, imm);
                         }
                         break;
                     case 3: /* Bitfield insert/clear.  */
@@ -189,9 +189,6 @@ DEF_HELPER_2(fsave, void, tl, int)
 DEF_HELPER_2(frstor, void, tl, int)
 DEF_HELPER_2(fxsave, void, tl, int)
 DEF_HELPER_2(fxrstor, void, tl, int)
-DEF_HELPER_1(bsf, tl, tl)
-DEF_HELPER_1(bsr, tl, tl)
-DEF_HELPER_2(lzcnt, tl, tl, int)
 
 /* MMX/SSE */
 
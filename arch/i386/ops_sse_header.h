@@ -332,7 +332,6 @@ DEF_HELPER_3(glue(pcmpestrm, SUFFIX), void, Reg, Reg, i32)
 DEF_HELPER_3(glue(pcmpistri, SUFFIX), void, Reg, Reg, i32)
 DEF_HELPER_3(glue(pcmpistrm, SUFFIX), void, Reg, Reg, i32)
 DEF_HELPER_3(crc32, tl, i32, tl, i32)
-DEF_HELPER_2(popcnt, tl, tl, i32)
 #endif
 
 #undef SHIFT
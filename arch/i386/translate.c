@@ -6592,7 +6592,6 @@ bt_op:
     case 0x1bc: /* bsf */
     case 0x1bd: /* bsr */
     {
-        int label1;
         TCGv t0;
 
         ot = dflag + OT_WORD;
@@ -6600,27 +6599,25 @@ bt_op:
         reg = ((modrm >> 3) & 7) | rex_r;
         gen_ldst_modrm(s, modrm, ot, OR_TMP0, 0);
         gen_extu(ot, cpu_T[0]);
-        t0 = tcg_temp_local_new();
+        t0 = tcg_temp_new();
         tcg_gen_mov_tl(t0, cpu_T[0]);
         if ((b & 1) && (prefixes & PREFIX_REPZ) && (s->cpuid_ext3_features & CPUID_EXT3_ABM)) {
-            switch (ot) {
-            case OT_WORD: gen_helper_lzcnt(cpu_T[0], t0, tcg_const_i32(16)); break;
-            case OT_LONG: gen_helper_lzcnt(cpu_T[0], t0, tcg_const_i32(32)); break;
-            case OT_QUAD: gen_helper_lzcnt(cpu_T[0], t0, tcg_const_i32(64)); break;
-            }
+            /* the operand is zero extended, so the count is off by the unused high bits */
+            tcg_gen_clzi_tl(cpu_T[0], t0, TARGET_LONG_BITS);
+            tcg_gen_subi_tl(cpu_T[0], cpu_T[0], TARGET_LONG_BITS - (8 << ot));
             gen_op_mov_reg_T0(ot, reg);
         } else {
-            label1 = gen_new_label();
-            tcg_gen_movi_tl(cpu_cc_dst, 0);
-            tcg_gen_brcondi_tl(TCG_COND_EQ, t0, 0, label1);
+            /* a zero source leaves the destination unchanged */
             if (b & 1) {
-                gen_helper_bsr(cpu_T[0], t0);
+                /* bsr is clz flipped: the xors undo each other for zero */
+                tcg_gen_xori_tl(cpu_T[1], cpu_regs[reg], TARGET_LONG_BITS - 1);
+                tcg_gen_clz_tl(cpu_T[0], t0, cpu_T[1]);
+                tcg_gen_xori_tl(cpu_T[0], cpu_T[0], TARGET_LONG_BITS - 1);
             } else {
-                gen_helper_bsf(cpu_T[0], t0);
+                tcg_gen_ctz_tl(cpu_T[0], t0, cpu_regs[reg]);
             }
             gen_op_mov_reg_T0(ot, reg);
-            tcg_gen_movi_tl(cpu_cc_dst, 1);
-            gen_set_label(label1);
+            tcg_gen_setcondi_tl(TCG_COND_NE, cpu_cc_dst, t0, 0);
             tcg_gen_discard_tl(cpu_cc_src);
             s->cc_op = CC_OP_LOGICB + ot;
         }
@@ -7680,7 +7677,10 @@ gen_sti:
         }
 
         gen_ldst_modrm(s, modrm, ot, OR_TMP0, 0);
-        gen_helper_popcnt(cpu_T[0], cpu_T[0], tcg_const_i32(ot));
+        gen_extu(ot, cpu_T[0]);
+        tcg_gen_setcondi_tl(TCG_COND_EQ, cpu_cc_src, cpu_T[0], 0);
+        tcg_gen_shli_tl(cpu_cc_src, cpu_cc_src, 6);
+        tcg_gen_ctpop_tl(cpu_T[0], cpu_T[0]);
         gen_op_mov_reg_T0(ot, reg);
 
         s->cc_op = CC_OP_EFLAGS;
@@ -7789,7 +7789,10 @@ int gen_intermediate_code(CPUState *env, DisasContextBase *base)
     if (dc->tf || (dc->flags & HF_INHIBIT_IRQ_MASK)) {
         return 0;
     }
-    if ((base->pc & (TARGET_PAGE_SIZE - 1)) == 0) {
+    /* the block must not span more than two pages, the ones tb_link_page
+       registers: an instruction starting in the first page may run into
+       the second one, but none may start there */
+    if ((base->pc - (base->tb->pc & TARGET_PAGE_MASK)) >= TARGET_PAGE_SIZE) {
         return 0;
     }
     return 1;
@@ -402,18 +402,6 @@ uint64_t helper_mulldo (uint64_t arg1, uint64_t arg2)
 }
 #endif
 
-target_ulong helper_cntlzw (target_ulong t)
-{
-    return clz32(t);
-}
-
-#if defined(TARGET_PPC64)
-target_ulong helper_cntlzd (target_ulong t)
-{
-    return clz64(t);
-}
-#endif
-
 /* shift right arithmetic helper */
 target_ulong helper_sraw (target_ulong value, target_ulong shift)
 {
@@ -491,11 +479,6 @@ target_ulong helper_popcntw (target_ulong val)
     val = (val & 0x0000ffff0000ffffULL) + ((val >> 16) & 0x0000ffff0000ffffULL);
     return val;
 }
-
-target_ulong helper_popcntd (target_ulong val)
-{
-    return ctpop64((uint64_t)val);
-}
 #else
 
 target_ulong helper_popcntb (target_ulong val)
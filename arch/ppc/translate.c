@@ -573,28 +573,19 @@ static void gen_cmpli(DisasContext *s)
 /* isel (PowerPC 2.03 specification) */
 static void gen_isel(DisasContext *s)
 {
-    int l1, l2;
     uint32_t bi = rC(s->opcode);
     uint32_t mask;
-    TCGv_i32 t0;
-
-    l1 = gen_new_label();
-    l2 = gen_new_label();
+    TCGv t0, zero;
 
     mask = 1 << (3 - (bi & 0x03));
-    t0 = tcg_temp_new_i32();
-    tcg_gen_andi_i32(t0, cpu_crf[bi >> 2], mask);
-    tcg_gen_brcondi_i32(TCG_COND_EQ, t0, 0, l1);
-    if (rA(s->opcode) == 0) {
-        tcg_gen_movi_tl(cpu_gpr[rD(s->opcode)], 0);
-    } else {
-        tcg_gen_mov_tl(cpu_gpr[rD(s->opcode)], cpu_gpr[rA(s->opcode)]);
-    }
-    tcg_gen_br(l2);
-    gen_set_label(l1);
-    tcg_gen_mov_tl(cpu_gpr[rD(s->opcode)], cpu_gpr[rB(s->opcode)]);
-    gen_set_label(l2);
-    tcg_temp_free_i32(t0);
+    t0 = tcg_temp_new();
+    zero = tcg_const_tl(0);
+    tcg_gen_extu_i32_tl(t0, cpu_crf[bi >> 2]);
+    tcg_gen_andi_tl(t0, t0, mask);
+    tcg_gen_movcond_tl(TCG_COND_NE, cpu_gpr[rD(s->opcode)], t0, zero,
+                       rA(s->opcode) == 0 ? zero : cpu_gpr[rA(s->opcode)], cpu_gpr[rB(s->opcode)]);
+    tcg_temp_free(zero);
+    tcg_temp_free(t0);
 }
 
 /***                           Integer arithmetic                          ***/
@@ -1232,7 +1223,12 @@ static void gen_andis_(DisasContext *s)
 /* cntlzw */
 static void gen_cntlzw(DisasContext *s)
 {
-    gen_helper_cntlzw(cpu_gpr[rA(s->opcode)], cpu_gpr[rS(s->opcode)]);
+    TCGv_i32 t0 = tcg_temp_new_i32();
+
+    tcg_gen_trunc_tl_i32(t0, cpu_gpr[rS(s->opcode)]);
+    tcg_gen_clzi_i32(t0, t0, 32);
+    tcg_gen_extu_i32_tl(cpu_gpr[rA(s->opcode)], t0);
+    tcg_temp_free_i32(t0);
     if (unlikely(Rc(s->opcode) != 0)) {
         gen_set_Rc0(s, cpu_gpr[rA(s->opcode)]);
     }
@@ -1407,7 +1403,7 @@ static void gen_popcntw(DisasContext *s)
 
 static void gen_popcntd(DisasContext *s)
 {
-    gen_helper_popcntd(cpu_gpr[rA(s->opcode)], cpu_gpr[rS(s->opcode)]);
+    tcg_gen_ctpop_i64(cpu_gpr[rA(s->opcode)], cpu_gpr[rS(s->opcode)]);
 }
 
 /* extsw & extsw. */
@@ -1416,7 +1412,7 @@ GEN_LOGICAL1(extsw, tcg_gen_ext32s_tl, 0x1E, PPC_64B);
 /* cntlzd */
 static void gen_cntlzd(DisasContext *s)
 {
-    gen_helper_cntlzd(cpu_gpr[rA(s->opcode)], cpu_gpr[rS(s->opcode)]);
+    tcg_gen_clzi_i64(cpu_gpr[rA(s->opcode)], cpu_gpr[rS(s->opcode)], 64);
     if (unlikely(Rc(s->opcode) != 0)) {
         gen_set_Rc0(s, cpu_gpr[rA(s->opcode)]);
     }
@@ -2929,6 +2925,7 @@ static void gen_stswx(DisasContext *s)
 /* eieio */
 static void gen_eieio(DisasContext *s)
 {
+    tcg_gen_mb(TCG_MO_ST_ST);
 }
 
 /* isync */
@@ -3016,6 +3013,7 @@ static void gen_stdcx_(DisasContext *s)
 /* sync */
 static void gen_sync(DisasContext *s)
 {
+    tcg_gen_mb(TCG_MO_ALL);
 }
 
 /* wait */
@@ -5762,13 +5760,13 @@ static void gen_dlmzb(DisasContext *s)
 /* mbar replaces eieio on 440 */
 static void gen_mbar(DisasContext *s)
 {
-    /* interpreted as no-op */
+    tcg_gen_mb(TCG_MO_ST_ST);
 }
 
 /* msync replaces sync on 440 */
 static void gen_msync(DisasContext *s)
 {
-    /* interpreted as no-op */
+    tcg_gen_mb(TCG_MO_ALL);
 }
 
 /* icbt */
@@ -490,9 +490,29 @@ static void gen_arith(DisasContext *dc, uint32_t opc, int rd, int rs1, int rs2)
 
 static void gen_synch(DisasContext *dc, uint32_t opc)
 {
+    int pred, succ;
+    TCGBar bar = 0;
+
     switch (opc) {
     case OPC_RISC_FENCE:
-        /* standard fence = NOP */
+        /* device input and output are ordered like reads and writes */
+        pred = ((dc->opcode >> 26) | (dc->opcode >> 24)) & 0x3;
+        succ = ((dc->opcode >> 22) | (dc->opcode >> 20)) & 0x3;
+        if ((pred & 0x2) && (succ & 0x2)) {
+            bar |= TCG_MO_LD_LD;
+        }
+        if ((pred & 0x2) && (succ & 0x1)) {
+            bar |= TCG_MO_LD_ST;
+        }
+        if ((pred & 0x1) && (succ & 0x2)) {
+            bar |= TCG_MO_ST_LD;
+        }
+        if ((pred & 0x1) && (succ & 0x1)) {
+            bar |= TCG_MO_ST_ST;
+        }
+        if (bar != 0) {
+            tcg_gen_mb(bar);
+        }
         break;
     case OPC_RISC_FENCE_I:
         gen_helper_fence_i(cpu_env);
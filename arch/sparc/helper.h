@@ -8,9 +8,9 @@ DEF_HELPER_2(check_align, void, tl, i32)
 DEF_HELPER_0(debug, void)
 DEF_HELPER_0(save, void)
 DEF_HELPER_0(restore, void)
-DEF_HELPER_2(udiv, tl, tl, tl)
+DEF_HELPER_FLAGS_2(udiv, TCG_CALL_NO_WG, tl, tl, tl)
 DEF_HELPER_2(udiv_cc, tl, tl, tl)
-DEF_HELPER_2(sdiv, tl, tl, tl)
+DEF_HELPER_FLAGS_2(sdiv, TCG_CALL_NO_WG, tl, tl, tl)
 DEF_HELPER_2(sdiv_cc, tl, tl, tl)
 DEF_HELPER_2(stdf, void, tl, int)
 DEF_HELPER_2(lddf, void, tl, int)
@@ -20,22 +20,22 @@ DEF_HELPER_4(ld_asi, i64, tl, int, int, int)
 DEF_HELPER_4(st_asi, void, tl, i64, int, int)
 DEF_HELPER_1(ldfsr, void, i32)
 DEF_HELPER_0(check_ieee_exceptions, void)
-DEF_HELPER_0(clear_float_exceptions, void)
-DEF_HELPER_1(fabss, f32, f32)
-DEF_HELPER_1(fsqrts, f32, f32)
-DEF_HELPER_0(fsqrtd, void)
+DEF_HELPER_FLAGS_0(clear_float_exceptions, TCG_CALL_NO_RWG, void)
+DEF_HELPER_FLAGS_1(fabss, TCG_CALL_NO_RWG_SE, f32, f32)
+DEF_HELPER_FLAGS_1(fsqrts, TCG_CALL_NO_RWG, f32, f32)
+DEF_HELPER_FLAGS_0(fsqrtd, TCG_CALL_NO_RWG, void)
 DEF_HELPER_2(fcmps, void, f32, f32)
 DEF_HELPER_0(fcmpd, void)
 DEF_HELPER_2(fcmpes, void, f32, f32)
 DEF_HELPER_0(fcmped, void)
-DEF_HELPER_0(fsqrtq, void)
+DEF_HELPER_FLAGS_0(fsqrtq, TCG_CALL_NO_RWG, void)
 DEF_HELPER_0(fcmpq, void)
 DEF_HELPER_0(fcmpeq, void)
 DEF_HELPER_1(raise_exception, void, int)
 DEF_HELPER_0(shutdown, void)
 DEF_HELPER_1(ldstub, tl, i32)
 DEF_HELPER_2(swap, tl, tl, i32)
-#define F_HELPER_0_0(name) DEF_HELPER_0(f ## name, void)
+#define F_HELPER_0_0(name) DEF_HELPER_FLAGS_0(f ## name, TCG_CALL_NO_RWG, void)
 #define F_HELPER_DQ_0_0(name)                   \
     F_HELPER_0_0(name ## d);                    \
     F_HELPER_0_0(name ## q)
@@ -45,33 +45,33 @@ F_HELPER_DQ_0_0(sub);
 F_HELPER_DQ_0_0(mul);
 F_HELPER_DQ_0_0(div);
 
-DEF_HELPER_2(fadds, f32, f32, f32)
-DEF_HELPER_2(fsubs, f32, f32, f32)
-DEF_HELPER_2(fmuls, f32, f32, f32)
-DEF_HELPER_2(fdivs, f32, f32, f32)
+DEF_HELPER_FLAGS_2(fadds, TCG_CALL_NO_RWG, f32, f32, f32)
+DEF_HELPER_FLAGS_2(fsubs, TCG_CALL_NO_RWG, f32, f32, f32)
+DEF_HELPER_FLAGS_2(fmuls, TCG_CALL_NO_RWG, f32, f32, f32)
+DEF_HELPER_FLAGS_2(fdivs, TCG_CALL_NO_RWG, f32, f32, f32)
 
-DEF_HELPER_2(fsmuld, void, f32, f32)
+DEF_HELPER_FLAGS_2(fsmuld, TCG_CALL_NO_RWG, void, f32, f32)
 F_HELPER_0_0(dmulq);
 
-DEF_HELPER_1(fnegs, f32, f32)
-DEF_HELPER_1(fitod, void, s32)
-DEF_HELPER_1(fitoq, void, s32)
+DEF_HELPER_FLAGS_1(fnegs, TCG_CALL_NO_RWG_SE, f32, f32)
+DEF_HELPER_FLAGS_1(fitod, TCG_CALL_NO_RWG, void, s32)
+DEF_HELPER_FLAGS_1(fitoq, TCG_CALL_NO_RWG, void, s32)
 
-DEF_HELPER_1(fitos, f32, s32)
+DEF_HELPER_FLAGS_1(fitos, TCG_CALL_NO_RWG, f32, s32)
 
-DEF_HELPER_0(fdtos, f32)
-DEF_HELPER_1(fstod, void, f32)
-DEF_HELPER_0(fqtos, f32)
-DEF_HELPER_1(fstoq, void, f32)
+DEF_HELPER_FLAGS_0(fdtos, TCG_CALL_NO_RWG, f32)
+DEF_HELPER_FLAGS_1(fstod, TCG_CALL_NO_RWG, void, f32)
+DEF_HELPER_FLAGS_0(fqtos, TCG_CALL_NO_RWG, f32)
+DEF_HELPER_FLAGS_1(fstoq, TCG_CALL_NO_RWG, void, f32)
 F_HELPER_0_0(qtod);
 F_HELPER_0_0(dtoq);
-DEF_HELPER_1(fstoi, s32, f32)
-DEF_HELPER_0(fdtoi, s32)
-DEF_HELPER_0(fqtoi, s32)
+DEF_HELPER_FLAGS_1(fstoi, TCG_CALL_NO_RWG, s32, f32)
+DEF_HELPER_FLAGS_0(fdtoi, TCG_CALL_NO_RWG, s32)
+DEF_HELPER_FLAGS_0(fqtoi, TCG_CALL_NO_RWG, s32)
 #undef F_HELPER_0_0
 #undef F_HELPER_DQ_0_0
 #undef VIS_HELPER
 #undef VIS_CMPHELPER
 DEF_HELPER_0(compute_psr, void);
-DEF_HELPER_0(compute_C_icc, i32);
+DEF_HELPER_FLAGS_0(compute_C_icc, TCG_CALL_NO_WG_SE, i32);
 #include "def-helper.h"
@@ -34,8 +34,9 @@ int gen_new_label(void);
 
 extern TCGv_ptr cpu_env;
 extern CPUState *cpu;
-static TCGArg *event_size_arg;
-static TCGArg *event_size2_arg;
+/* indexes into gen_opparam_buf, which may move as the block grows */
+static int event_size_arg;
+static int event_size2_arg;
 
 static int exit_no_hook_label;
 static int block_header_interrupted_label;
@@ -73,7 +74,7 @@ static inline void gen_block_header(TranslationBlock *tb)
 
     if (cpu->block_begin_hook_present) {
         TCGv event_address = tcg_const_tl(tb->pc);
-        event_size_arg = gen_opparam_ptr + 1;
+        event_size_arg = gen_opparam_ptr + 1 - tcg->gen_opparam_buf;
         TCGv_i32 event_size = tcg_const_i32(0xFFFF); // bogus value that is to be fixed at later point
 
         TCGv_i32 result = tcg_temp_new_i32();
@@ -94,7 +95,7 @@ static inline void gen_block_header(TranslationBlock *tb)
     gen_set_label(execute_block_label);
 
     // it looks like we cannot re-use tcg_const in two places - that's why I create a second copy of it here
-    event_size2_arg = gen_opparam_ptr + 1;
+    event_size2_arg = gen_opparam_ptr + 1 - tcg->gen_opparam_buf;
     TCGv_i32 event_size2 = tcg_const_i32(0xFFFF); // bogus value that is to be fixed at later point
     gen_helper_update_instructions_count(event_size2);
     tcg_temp_free_i32(event_size2);
@@ -137,9 +138,9 @@ static inline void gen_block_footer(TranslationBlock *tb)
         tlib_on_block_translation(tb->pc, tb->size, tb->disas_flags);
     }
     if (cpu->block_begin_hook_present) {
-        *event_size_arg = tb->icount;
+        tcg->gen_opparam_buf[event_size_arg] = tb->icount;
     }
-    *event_size2_arg = tb->icount;
+    tcg->gen_opparam_buf[event_size2_arg] = tb->icount;
 
     int finish_label = gen_new_label();
     gen_exit_tb((uintptr_t)tb + 2, tb);
@@ -158,7 +159,34 @@ static inline void gen_block_footer(TranslationBlock *tb)
 
 static inline uint64_t get_max_instruction_count(CPUState *env, TranslationBlock *tb)
 {
-    return maximum_block_size > env->instructions_count_threshold ? env->instructions_count_threshold : maximum_block_size;
+    uint64_t max_count = maximum_block_size > env->instructions_count_threshold ? env->instructions_count_threshold : maximum_block_size;
+
+    if ((tb->cflags & CF_COUNT_MASK) != 0 && (tb->cflags & CF_COUNT_MASK) < max_count) {
+        return tb->cflags & CF_COUNT_MASK;
+    }
+    return max_count;
+}
+
+/* Leave room for the next instruction, or for the block footer if the
+   block may not grow any more. The limits are checked on every call, as
+   the op buffers never shrink and may already be larger than they allow. */
+static inline int gen_opc_reserve(TranslationBlock *tb)
+{
+    uint64_t max_ops;
+
+    if (tb->search_pc) {
+        // the block has already been translated once at this size
+        max_ops = INT32_MAX;
+    } else {
+        max_ops = code_gen_buffer_room(tb->tc_ptr) / TCG_MAX_OP_SIZE;
+        if (max_ops > maximum_block_ops) {
+            max_ops = maximum_block_ops;
+        }
+    }
+    if (gen_opc_ptr - tcg->gen_opc_buf + MAX_OP_PER_INSTR > max_ops) {
+        return -1;
+    }
+    return tcg_op_buf_reserve(MAX_OP_PER_INSTR, max_ops);
 }
 
 static void cpu_gen_code_inner(CPUState *env, TranslationBlock *tb, int search_pc)
@@ -167,7 +195,7 @@ static void cpu_gen_code_inner(CPUState *env, TranslationBlock *tb, int search_p
     CPUBreakpoint *bp;
     DisasContextBase *dc = (DisasContextBase *)&dcc;
 
-    memset((void *)tcg->gen_opc_instr_start, 0, OPC_BUF_SIZE);
+    memset((void *)tcg->gen_opc_instr_start, 0, tcg->gen_opc_buf_size);
 
     tb->icount = 0;
     tb->size = 0;
@@ -211,10 +239,12 @@ static void cpu_gen_code_inner(CPUState *env, TranslationBlock *tb, int search_p
         if (do_break) {
             break;
         }
-        if ((gen_opc_ptr - tcg->gen_opc_buf) >= OPC_MAX_SIZE) {
+        if (gen_opc_reserve(tb) != 0) {
             break;
         }
-        if (tb->icount >= get_max_instruction_count(env, tb)) {
+        // when restoring, the instruction budget may have changed since the
+        // block was translated; the size check below ends it instead
+        if (!tb->search_pc && tb->icount >= get_max_instruction_count(env, tb)) {
             break;
         }
         if (dc->is_jmp) {
@@ -243,9 +273,9 @@ void cpu_gen_code(CPUState *env, TranslationBlock *tb, int *gen_code_size_ptr)
     cpu_gen_code_inner(env, tb, 0);
 
     /* generate machine code */
-    gen_code_buf = tb->tc_ptr;
-    tb->tb_next_offset[0] = 0xffff;
-    tb->tb_next_offset[1] = 0xffff;
+    gen_code_buf = tcg_code_rw(tb->tc_ptr);
+    tb->tb_next_offset[0] = 0xffffffff;
+    tb->tb_next_offset[1] = 0xffffffff;
 
     s->tb_next_offset = tb->tb_next_offset;
     s->tb_jmp_offset = tb->tb_jmp_offset;
@@ -257,13 +287,16 @@ void cpu_gen_code(CPUState *env, TranslationBlock *tb, int *gen_code_size_ptr)
 
 /* The cpu state corresponding to 'searched_pc' is restored.
  */
-int cpu_restore_state(CPUState *env, TranslationBlock *tb, uintptr_t searched_pc)
+/* Translate 'tb' again and return the index of the first op of the guest
+   instruction whose host code contains 'searched_pc', or -1. */
+static int cpu_search_instruction_opc(CPUState *env, TranslationBlock *tb, uintptr_t searched_pc)
 {
     TCGContext *s = tcg->ctx;
-    int j, k;
+    int j;
     uintptr_t tc_ptr;
-    int instructions_executed_so_far = 0;
 
+    /* left over if the translation of a dumped block was interrupted */
+    s->dump_flags = 0;
     tcg_func_start(s);
     cpu_gen_code_inner(env, tb, 1);
 
@@ -276,7 +309,7 @@ int cpu_restore_state(CPUState *env, TranslationBlock *tb, uintptr_t searched_pc
     s->tb_next_offset = tb->tb_next_offset;
     s->tb_jmp_offset = tb->tb_jmp_offset;
     s->tb_next = NULL;
-    j = tcg_gen_code_search_pc(s, (uint8_t *)tc_ptr, searched_pc - tc_ptr);
+    j = tcg_gen_code_search_pc(s, tcg_code_rw((uint8_t *)tc_ptr), searched_pc - tc_ptr);
     if (j < 0) {
         return -1;
     }
@@ -284,6 +317,18 @@ int cpu_restore_state(CPUState *env, TranslationBlock *tb, uintptr_t searched_pc
     while (tcg->gen_opc_instr_start[j] == 0) {
         j--;
     }
+    return j;
+}
+
+int cpu_restore_state(CPUState *env, TranslationBlock *tb, uintptr_t searched_pc)
+{
+    int j, k;
+    int instructions_executed_so_far = 0;
+
+    j = cpu_search_instruction_opc(env, tb, searched_pc);
+    if (j < 0) {
+        return -1;
+    }
 
     k = j;
     while (k >= 0) {
@@ -296,6 +341,15 @@ int cpu_restore_state(CPUState *env, TranslationBlock *tb, uintptr_t searched_pc
     return instructions_executed_so_far;
 }
 
+/* Like cpu_restore_state, but only returns the guest pc of the instruction
+   and leaves the CPU state alone; tb->pc if it cannot be found. */
+target_ulong cpu_get_instruction_pc(CPUState *env, TranslationBlock *tb, uintptr_t searched_pc)
+{
+    int j = cpu_search_instruction_opc(env, tb, searched_pc);
+
+    return j < 0 ? tb->pc : tcg->gen_opc_pc[j];
+}
+
 int cpu_restore_state_and_restore_instructions_count(CPUState *env, TranslationBlock *tb, uintptr_t searched_pc)
 {
     int executed_instructions = cpu_restore_state(env, tb, searched_pc);
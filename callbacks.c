@@ -94,6 +94,10 @@ DEFAULT_VOID_HANDLER2(void tlib_on_memory_access, uint32_t operation, uint64_t a
 
 DEFAULT_INT_HANDLER1(uint32_t tlib_is_in_debug_mode, void)
 
+DEFAULT_VOID_HANDLER1(void tlib_on_host_mmio_page_written, uint64_t address)
+
+DEFAULT_VOID_HANDLER1(void tlib_on_memory_trace_ready, uint32_t count)
+
 DEFAULT_VOID_HANDLER1(void tlib_on_interrupt_begin, uint64_t exception_index)
 
 DEFAULT_VOID_HANDLER1(void tlib_on_interrupt_end, uint64_t exception_index)
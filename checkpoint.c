@@ -0,0 +1,224 @@
+/*
+ *  CPU state checkpoints.
+ *
+ *  Copyright (c) Antmicro
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stddef.h>
+#include <string.h>
+#include "cpu.h"
+#include "exec-all.h"
+#include "checkpoint.h"
+
+/* A checkpoint covers CPUState up to the "not serialized" marker of
+   CPU_COMMON. Deltas are computed in chunks of this many bytes; equal
+   chunks no longer than a run header are merged into the surrounding run. */
+#define CHECKPOINT_CHUNK 8
+
+/* fields in the serialized range that only make sense in this process */
+typedef struct CheckpointLiveFields {
+    jmp_buf jmp_env;
+    struct breakpoints_head breakpoints;
+    int id;
+} CheckpointLiveFields;
+
+static inline uint32_t checkpoint_state_size(void)
+{
+    return offsetof(CPUState, atomic_memory_state);
+}
+
+/* FNV-1a */
+static uint32_t checkpoint_checksum(const uint8_t *data, uint32_t size)
+{
+    uint32_t hash = 2166136261u;
+    uint32_t i;
+
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool checkpoint_header_is_valid(const CheckpointHeader *header)
+{
+    return header->magic == CHECKPOINT_MAGIC && header->version == CHECKPOINT_VERSION &&
+           header->state_size == checkpoint_state_size();
+}
+
+static inline bool checkpoint_chunk_differs(const uint8_t *a, const uint8_t *b, uint32_t offset, uint32_t size)
+{
+    uint32_t length = size - offset < CHECKPOINT_CHUNK ? size - offset : CHECKPOINT_CHUNK;
+
+    return memcmp(a + offset, b + offset, length) != 0;
+}
+
+/* Returns the size of the delta or -1 if it would not fit in 'capacity'. */
+static int32_t checkpoint_write_delta(uint8_t *out, uint32_t capacity, const uint8_t *state, const uint8_t *base_state,
+                                      uint32_t size)
+{
+    CheckpointRun run;
+    uint32_t offset = 0;
+    uint32_t written = 0;
+    uint32_t end, gap;
+
+    while (offset < size) {
+        if (!checkpoint_chunk_differs(state, base_state, offset, size)) {
+            offset += CHECKPOINT_CHUNK;
+            continue;
+        }
+        end = offset + CHECKPOINT_CHUNK;
+        gap = 0;
+        while (end < size && gap <= sizeof(CheckpointRun)) {
+            if (checkpoint_chunk_differs(state, base_state, end, size)) {
+                gap = 0;
+            } else {
+                gap += CHECKPOINT_CHUNK;
+            }
+            end += CHECKPOINT_CHUNK;
+        }
+        end -= gap;
+        if (end > size) {
+            end = size;
+        }
+        run.offset = offset;
+        run.length = end - offset;
+        if (written + sizeof(run) + run.length > capacity) {
+            return -1;
+        }
+        memcpy(out + written, &run, sizeof(run));
+        memcpy(out + written + sizeof(run), state + offset, run.length);
+        written += sizeof(run) + run.length;
+        offset = end;
+    }
+    return written;
+}
+
+static bool checkpoint_delta_is_valid(const uint8_t *payload, uint32_t payload_size, uint32_t size)
+{
+    CheckpointRun run;
+    uint32_t position = 0;
+
+    while (position < payload_size) {
+        if (payload_size - position < sizeof(run)) {
+            return false;
+        }
+        memcpy(&run, payload + position, sizeof(run));
+        position += sizeof(run);
+        if (run.offset > size || run.length > size - run.offset || run.length > payload_size - position) {
+            return false;
+        }
+        position += run.length;
+    }
+    return true;
+}
+
+uint32_t checkpoint_max_size(void)
+{
+    return sizeof(CheckpointHeader) + checkpoint_state_size();
+}
+
+/* Store the CPU state in 'buffer'. If 'base' is a full checkpoint of
+   this CPU, only the bytes that differ from it are stored (unless the
+   delta would be larger than the state). Returns the checkpoint size. */
+int32_t checkpoint_save(uint8_t *buffer, uint32_t buffer_size, const uint8_t *base)
+{
+    CheckpointHeader header;
+    const CheckpointHeader *base_header = (const CheckpointHeader *)base;
+    const uint8_t *state = (const uint8_t *)cpu;
+    uint32_t size = checkpoint_state_size();
+    int32_t delta_size = -1;
+
+    if (buffer_size < checkpoint_max_size()) {
+        return -1;
+    }
+    header.magic = CHECKPOINT_MAGIC;
+    header.version = CHECKPOINT_VERSION;
+    header.state_size = size;
+    header.checksum = 0;
+    header.base_checksum = 0;
+
+    if (base_header != NULL && checkpoint_header_is_valid(base_header) && !(base_header->flags & CHECKPOINT_DELTA) &&
+        base_header->payload_size == size) {
+        delta_size = checkpoint_write_delta(buffer + sizeof(header), size, state, base + sizeof(header), size);
+    }
+    if (delta_size >= 0) {
+        header.flags = CHECKPOINT_DELTA;
+        header.payload_size = delta_size;
+        header.base_checksum = base_header->checksum;
+    } else {
+        header.flags = 0;
+        header.payload_size = size;
+        header.checksum = checkpoint_checksum(state, size);
+        memcpy(buffer + sizeof(header), state, size);
+    }
+    memcpy(buffer, &header, sizeof(header));
+    return sizeof(header) + header.payload_size;
+}
+
+/* Load the CPU state from 'buffer'; a delta checkpoint needs the full
+   checkpoint it was saved against in 'base'. Unless asked to keep them,
+   the TLB and the translation cache are flushed. */
+int32_t checkpoint_restore(const uint8_t *buffer, const uint8_t *base, uint32_t flags)
+{
+    const CheckpointHeader *header = (const CheckpointHeader *)buffer;
+    const CheckpointHeader *base_header = (const CheckpointHeader *)base;
+    const uint8_t *payload = buffer + sizeof(*header);
+    uint8_t *state = (uint8_t *)cpu;
+    uint32_t size = checkpoint_state_size();
+    CheckpointLiveFields live;
+    CheckpointRun run;
+    uint32_t position;
+
+    if (!checkpoint_header_is_valid(header)) {
+        return -1;
+    }
+    if (header->flags & CHECKPOINT_DELTA) {
+        if (base_header == NULL || !checkpoint_header_is_valid(base_header) || (base_header->flags & CHECKPOINT_DELTA) ||
+            base_header->payload_size != size || base_header->checksum != header->base_checksum) {
+            return -1;
+        }
+        if (!checkpoint_delta_is_valid(payload, header->payload_size, size)) {
+            return -1;
+        }
+    } else if (header->payload_size != size) {
+        return -1;
+    }
+
+    memcpy(&live.jmp_env, &cpu->jmp_env, sizeof(jmp_buf));
+    live.breakpoints = cpu->breakpoints;
+    live.id = cpu->id;
+
+    if (header->flags & CHECKPOINT_DELTA) {
+        memcpy(state, base + sizeof(*base_header), size);
+        for (position = 0; position < header->payload_size; position += sizeof(run) + run.length) {
+            memcpy(&run, payload + position, sizeof(run));
+            memcpy(state + run.offset, payload + position + sizeof(run), run.length);
+        }
+    } else {
+        memcpy(state, payload, size);
+    }
+
+    memcpy(&cpu->jmp_env, &live.jmp_env, sizeof(jmp_buf));
+    cpu->breakpoints = live.breakpoints;
+    cpu->id = live.id;
+
+    if (!(flags & CHECKPOINT_KEEP_TLB)) {
+        tlb_flush(cpu, 1);
+    }
+    if (!(flags & CHECKPOINT_KEEP_TRANSLATIONS)) {
+        tb_flush(cpu);
+    }
+    return 0;
+}
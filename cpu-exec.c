@@ -104,7 +104,7 @@ target_ulong virt_to_phys(target_ulong virtual, uint32_t access_type, uint32_t n
         physical = (physical + virtual) & TARGET_PAGE_MASK;
     } else {
         p = (void *)(uintptr_t)masked_virtual + env->tlb_table[found_idx][page_index].addend;
-        physical = tlib_host_ptr_to_guest_offset(p);
+        physical = ram_addr_from_host(p);
         if (physical == -1) {
             tlib_printf(LOG_LEVEL_ERROR, "No host mapping for host ptr %p", p);
             return -1;
@@ -114,6 +114,82 @@ target_ulong virt_to_phys(target_ulong virtual, uint32_t access_type, uint32_t n
     return physical;
 }
 
+/* Look the page up in the TLB of the current MMU mode without refilling it. */
+static bool virt_to_phys_probe_tlb(CPUState *env, target_ulong page, uint32_t access_type, int mmu_idx, uint64_t *physical)
+{
+    CPUTLBEntry *entry;
+    target_ulong tlb_addr;
+    ram_addr_t ram_addr;
+    int page_index;
+
+    page_index = (page >> TARGET_PAGE_BITS) & (CPU_TLB_SIZE - 1);
+    entry = &env->tlb_table[mmu_idx][page_index];
+    switch (access_type) {
+    case 0:
+        tlb_addr = entry->addr_read;
+        break;
+    case 1:
+        tlb_addr = entry->addr_write;
+        break;
+    case 2:
+        tlb_addr = entry->addr_code;
+        break;
+    default:
+        return false;
+    }
+    if ((tlb_addr & (TARGET_PAGE_MASK | TLB_INVALID_MASK)) != page) {
+        return false;
+    }
+    if (tlb_addr & TLB_MMIO) {
+        *physical = (env->iotlb[mmu_idx][page_index] + page) & TARGET_PAGE_MASK;
+        return true;
+    }
+    ram_addr = ram_addr_from_host((void *)(uintptr_t)(page + entry->addend));
+    if (ram_addr == -1) {
+        return false;
+    }
+    *physical = ram_addr;
+    return true;
+}
+
+/* Translation for the host that leaves the TLB alone: a TLB miss walks
+   the guest page tables with cpu_get_phys_page_debug and the result is
+   kept in a small per-CPU cache until the next TLB flush. Returns -1 if
+   'virtual' is not mapped.
+   'access_type' selects the TLB entry that is probed; the page table walk
+   has no such parameter and is done as a data read on every target, like
+   the debugger's accesses. A page the walk cannot read is reported as
+   unmapped whatever the access type, and on targets with separate
+   instruction translation (the PowerPC IBATs) a fetch that misses the TLB
+   is translated as data. */
+uint64_t virt_to_phys_cached(CPUState *env, target_ulong virtual, uint32_t access_type)
+{
+    PhysTranslationCacheEntry *entry;
+    target_ulong page = virtual & TARGET_PAGE_MASK;
+    int mmu_idx = cpu_mmu_index(env);
+    target_phys_addr_t walked;
+    uint64_t physical;
+
+    entry = &env->phys_translation_cache[(page >> TARGET_PAGE_BITS) & (PHYS_TRANSLATION_CACHE_SIZE - 1)];
+    if (entry->generation == env->phys_translation_cache_generation && entry->vaddr == page &&
+        entry->mmu_idx == mmu_idx && entry->access_type == access_type) {
+        return entry->paddr | (virtual & ~TARGET_PAGE_MASK);
+    }
+    if (!virt_to_phys_probe_tlb(env, page, access_type, mmu_idx, &physical)) {
+        walked = cpu_get_phys_page_debug(env, page);
+        if (walked == -1) {
+            return -1;
+        }
+        physical = walked & TARGET_PAGE_MASK;
+    }
+    entry->vaddr = page;
+    entry->paddr = physical;
+    entry->mmu_idx = mmu_idx;
+    entry->access_type = access_type;
+    entry->generation = env->phys_translation_cache_generation;
+    return physical | (virtual & ~TARGET_PAGE_MASK);
+}
+
 int tb_invalidated_flag;
 
 static void TLIB_NORETURN cpu_loop_exit_without_hook(CPUState *env)
@@ -166,36 +242,33 @@ static TranslationBlock *tb_find_slow(CPUState *env, target_ulong pc, target_ulo
     h = tb_phys_hash_func(phys_pc);
     ptb1 = &tb_phys_hash[h];
 
-    if (unlikely(env->tb_cache_disabled)) {
-        goto not_found;
-    }
-
-    for (;;) {
-        tb = *ptb1;
-        if (!tb) {
-            goto not_found;
-        }
-        if (tb->pc == pc && tb->page_addr[0] == phys_page1 && tb->cs_base == cs_base && tb->flags == flags) {
-            /* check next page if needed */
-            if (tb->page_addr[1] != -1) {
-                tb_page_addr_t phys_page2;
-
+    tb = NULL;
+    if (likely(!env->tb_cache_disabled)) {
+        for (;;) {
+            tb = *ptb1;
+            if (!tb) {
+                break;
+            }
+            if (tb->pc == pc && tb->page_addr[0] == phys_page1 && tb->cs_base == cs_base && tb->flags == flags) {
+                /* check next page if needed */
+                if (tb->page_addr[1] == -1) {
+                    break;
+                }
                 virt_page2 = (pc & TARGET_PAGE_MASK) + TARGET_PAGE_SIZE;
-                phys_page2 = get_page_addr_code(env, virt_page2);
-                if (tb->page_addr[1] == phys_page2) {
-                    goto found;
+                if (tb->page_addr[1] == get_page_addr_code(env, virt_page2)) {
+                    break;
                 }
-            } else {
-                goto found;
             }
+            ptb1 = &tb->phys_hash_next;
         }
-        ptb1 = &tb->phys_hash_next;
     }
-not_found:
-    /* if no translated code available, then translate it now */
-    tb = tb_gen_code(env, pc, cs_base, flags, 0);
+    if (tb) {
+        env->statistics.tb_lookups_slow++;
+    } else {
+        /* if no translated code available, then translate it now */
+        tb = tb_gen_code(env, pc, cs_base, flags, 0);
+    }
 
-found:
     /* Move the last found TB to the head of the list */
     if (likely(*ptb1)) {
         *ptb1 = tb->phys_hash_next;
@@ -221,10 +294,41 @@ static inline TranslationBlock *tb_find_fast(CPUState *env)
     tb = env->tb_jmp_cache[tb_jmp_cache_hash_func(pc)];
     if (unlikely(!tb || tb->pc != pc || tb->cs_base != cs_base || tb->flags != flags || env->tb_cache_disabled)) {
         tb = tb_find_slow(env, pc, cs_base, flags);
+    } else {
+        env->statistics.tb_lookups_fast++;
     }
     return tb;
 }
 
+/* The instruction that hit a watchpoint is executed again in a block of
+   its own, during which watchpoints are not checked, and the block is
+   dropped afterwards.  */
+static TranslationBlock *watchpoint_step_begin(CPUState *env)
+{
+    target_ulong cs_base, pc;
+    int flags;
+
+    cpu_get_tb_cpu_state(env, &pc, &cs_base, &flags);
+    env->watchpoint_stepping = 1;
+    env->watchpoint_step_tb = tb_gen_code(env, pc, cs_base, flags, 1);
+    return env->watchpoint_step_tb;
+}
+
+static void watchpoint_step_end(CPUState *env)
+{
+    TranslationBlock *tb = env->watchpoint_step_tb;
+
+    /* NULL if the block was flushed or invalidated during the step */
+    if (tb != NULL) {
+        tb_phys_invalidate(tb, -1);
+        /* only reclaims the space if no block was generated since */
+        tb_free(tb);
+        env->watchpoint_step_tb = NULL;
+    }
+    env->watchpoint_stepping = 0;
+    env->watchpoint_hit = 0;
+}
+
 static CPUDebugExcpHandler *debug_excp_handler;
 
 CPUDebugExcpHandler *cpu_set_debug_excp_handler(CPUDebugExcpHandler *handler)
@@ -275,6 +379,10 @@ int cpu_exec(CPUState *env)
     for (;;) {
         verify_state(env);
         if (setjmp(env->jmp_env) == 0) {
+            if (unlikely(env->watchpoint_stepping)) {
+                /* the stepped instruction raised an exception */
+                watchpoint_step_end(env);
+            }
             /* if an exception is pending, we execute it here */
             if (env->exception_index >= 0) {
                 if (env->return_on_exception || env->exception_index >= EXCP_INTERRUPT) {
@@ -341,7 +449,12 @@ int cpu_exec(CPUState *env)
                 }
 #endif
 
-                tb = tb_find_fast(env);
+                if (unlikely(env->watchpoint_hit)) {
+                    tb = watchpoint_step_begin(env);
+                    next_tb = 0;
+                } else {
+                    tb = tb_find_fast(env);
+                }
                 /* Note: we do it here to avoid a gcc bug on Mac OS X when
                    doing it in tb_find_slow */
                 if (tb_invalidated_flag) {
@@ -358,7 +471,9 @@ int cpu_exec(CPUState *env)
                    there is a hook registered for the block footer. */
 
                 if (!env->chaining_disabled && !env->block_finished_hook_present && next_tb != 0 && tb->page_addr[1] == -1) {
-                    tb_add_jump((TranslationBlock *)(next_tb & ~3), next_tb & 3, tb);
+                    if (tb_add_jump((TranslationBlock *)(next_tb & ~3), next_tb & 3, tb)) {
+                        env->statistics.tb_chain_patches++;
+                    }
                 }
 
                 /* cpu_interrupt might be called while translating the
@@ -369,6 +484,7 @@ int cpu_exec(CPUState *env)
                 asm volatile ("" ::: "memory");
                 if (likely(!env->exit_request)) {
                     tc_ptr = tb->tc_ptr;
+                    env->statistics.tb_main_loop_entries++;
                     /* execute the generated code */
                     next_tb = tcg_tb_exec(env, tc_ptr);
                     if ((next_tb & 3) == 2) {
@@ -381,6 +497,10 @@ int cpu_exec(CPUState *env)
                     }
                 }
                 env->current_tb = NULL;
+                if (unlikely(env->watchpoint_stepping)) {
+                    watchpoint_step_end(env);
+                    next_tb = 0;
+                }
                 /* reset soft MMU for next block (it can currently
                    only be set by a memory fault) */
             } /* for(;;) */
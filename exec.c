@@ -23,13 +23,23 @@
 #else
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <time.h>
 #include <unistd.h>
 #endif
 #include "cpu.h"
 #include "tcg.h"
 #include "osdep.h"
+#include "memory_trace.h"
+#include "tb_profile.h"
+#include "perf_map.h"
+#include "tb_dump.h"
 
-#define SMC_BITMAP_USE_THRESHOLD 10
+/* number of TBs invalidated on a page after which its code is translated
+   one instruction per block */
+#define SMC_SINGLE_INSN_THRESHOLD 32
 
 CPUState *env;
 
@@ -45,17 +55,22 @@ static uintptr_t code_gen_buffer_size;
 static uintptr_t code_gen_buffer_max_size;
 static uint8_t *code_gen_ptr;
 
-dirty_ram_t dirty_ram = {0, 0};
+dirty_ram_t dirty_ram;
 
 CPUState *cpu;
 
 typedef struct PageDesc {
     /* list of TBs intersecting this ram page */
     TranslationBlock *first_tb;
-    /* in order to optimize self modifying code, we count the number
-       of lookups we do to a given page to use a bitmap */
-    unsigned int code_write_count;
+    /* bytes of the page covered by the TBs in 'first_tb'; built on the
+       first guest write and kept up to date as TBs are added, so that
+       writes to data sharing the page with code invalidate nothing */
     uint8_t *code_bitmap;
+    /* self modifying code statistics, see SmcPageStatistics */
+    uint64_t write_count;
+    uint64_t code_write_count;
+    uint32_t invalidate_count;
+    bool single_insn;
 } PageDesc;
 
 /* In system mode we want L1_MAP to be based on ram offsets,
@@ -113,11 +128,6 @@ CPUWriteMemoryFunc *io_mem_write[IO_MEM_NB_ENTRIES][4];
 CPUReadMemoryFunc *io_mem_read[IO_MEM_NB_ENTRIES][4];
 void *io_mem_opaque[IO_MEM_NB_ENTRIES];
 
-/* statistics */
-static int tlb_flush_count;
-static int tb_flush_count;
-static int tb_phys_invalidate_count;
-
 #ifdef _WIN32
 static void map_exec(void *addr, long size)
 {
@@ -325,6 +335,173 @@ void unmap_page(target_phys_addr_t address)
     }
 }
 
+static inline ram_addr_t ram_block_last(const ram_block_t *b)
+{
+    return b->start + (b->size - 1);
+}
+
+/* index of the first block ending at or after 'addr' */
+static int ram_blocks_find(ram_addr_t addr)
+{
+    int lo = 0, hi = dirty_ram.count, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (ram_block_last(&dirty_ram.blocks[mid]) < addr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void ram_blocks_insert(int index, const ram_block_t *block)
+{
+    if (dirty_ram.count == dirty_ram.capacity) {
+        dirty_ram.capacity = dirty_ram.capacity ? dirty_ram.capacity * 2 : 8;
+        dirty_ram.blocks = tlib_realloc(dirty_ram.blocks, dirty_ram.capacity * sizeof(ram_block_t));
+    }
+    memmove(dirty_ram.blocks + index + 1, dirty_ram.blocks + index, (dirty_ram.count - index) * sizeof(ram_block_t));
+    dirty_ram.blocks[index] = *block;
+    dirty_ram.count++;
+}
+
+static void ram_blocks_remove(int index, int count)
+{
+    memmove(dirty_ram.blocks + index, dirty_ram.blocks + index + count,
+            (dirty_ram.count - index - count) * sizeof(ram_block_t));
+    dirty_ram.count -= count;
+}
+
+uint8_t *cpu_physical_memory_dirty_lookup(ram_addr_t addr)
+{
+    int i = ram_blocks_find(addr);
+    ram_block_t *b;
+
+    if (i < dirty_ram.count) {
+        b = &dirty_ram.blocks[i];
+        if (addr >= b->start) {
+            dirty_ram.last = *b;
+            return b->phys_dirty + ((addr - b->start) >> TARGET_PAGE_BITS);
+        }
+    }
+    /* writes to pages that are not RAM are dropped, reads see them dirty */
+    dirty_ram.unmapped = 0xff;
+    return &dirty_ram.unmapped;
+}
+
+/* Set the dirty bytes of [start, start + size) to 'dirty_flags'. The
+   pages not registered yet get blocks of their own: blocks are never
+   merged, so registering adjacent ranges one by one copies nothing. */
+void ram_blocks_reserve(ram_addr_t start, ram_addr_t size, uint8_t dirty_flags)
+{
+    ram_block_t *b, block;
+    ram_addr_t last, addr, hi;
+    int i;
+
+    start &= TARGET_PAGE_MASK;
+    size = TARGET_PAGE_ALIGN(size);
+    if (size == 0) {
+        return;
+    }
+    last = start + (size - 1);
+    dirty_ram.last.size = 0;
+
+    addr = start;
+    i = ram_blocks_find(start);
+    for (;;) {
+        b = i < dirty_ram.count ? &dirty_ram.blocks[i] : NULL;
+        if (b != NULL && b->start <= addr) {
+            /* already registered */
+            hi = ram_block_last(b) < last ? ram_block_last(b) : last;
+            memset(b->phys_dirty + ((addr - b->start) >> TARGET_PAGE_BITS), dirty_flags, (hi - addr + 1) >> TARGET_PAGE_BITS);
+        } else {
+            hi = b != NULL && b->start <= last ? b->start - 1 : last;
+            block.start = addr;
+            block.size = hi - addr + 1;
+            block.phys_dirty = tlib_malloc(block.size >> TARGET_PAGE_BITS);
+            memset(block.phys_dirty, dirty_flags, block.size >> TARGET_PAGE_BITS);
+            ram_blocks_insert(i, &block);
+        }
+        if (hi == last) {
+            break;
+        }
+        addr = hi + 1;
+        i++;
+    }
+}
+
+/* Unmap the registered pages of [start, last] and drop their dirty bytes;
+   unregistered holes in the range are skipped. */
+void ram_blocks_unregister(ram_addr_t start, ram_addr_t last)
+{
+    ram_block_t *b, tail;
+    ram_addr_t lo, hi, addr, block_last;
+    int i;
+
+    start &= TARGET_PAGE_MASK;
+    if (last < start) {
+        return;
+    }
+    dirty_ram.last.size = 0;
+
+    i = ram_blocks_find(start);
+    while (i < dirty_ram.count && dirty_ram.blocks[i].start <= last) {
+        b = &dirty_ram.blocks[i];
+        block_last = ram_block_last(b);
+        lo = b->start > start ? b->start : start;
+        hi = block_last < last ? block_last : (last | ~TARGET_PAGE_MASK);
+        for (addr = lo; addr - lo <= hi - lo; addr += TARGET_PAGE_SIZE) {
+            unmap_page(addr);
+            if (addr + TARGET_PAGE_SIZE == 0) {
+                break;
+            }
+        }
+        if (lo == b->start && hi == block_last) {
+            tlib_free(b->phys_dirty);
+            ram_blocks_remove(i, 1);
+        } else if (lo == b->start) {
+            memmove(b->phys_dirty, b->phys_dirty + ((hi - lo + 1) >> TARGET_PAGE_BITS), (block_last - hi) >> TARGET_PAGE_BITS);
+            b->start = hi + 1;
+            b->size = block_last - hi;
+            i++;
+        } else if (hi == block_last) {
+            b->size = lo - b->start;
+            i++;
+        } else {
+            tail.start = hi + 1;
+            tail.size = block_last - hi;
+            tail.phys_dirty = tlib_malloc(tail.size >> TARGET_PAGE_BITS);
+            memcpy(tail.phys_dirty, b->phys_dirty + ((tail.start - b->start) >> TARGET_PAGE_BITS), tail.size >> TARGET_PAGE_BITS);
+            b->size = lo - b->start;
+            ram_blocks_insert(i + 1, &tail);
+            i += 2;
+        }
+    }
+}
+
+/* true if any page of [start, last] is registered RAM */
+bool ram_blocks_intersect(ram_addr_t start, ram_addr_t last)
+{
+    int i = ram_blocks_find(start);
+
+    return i < dirty_ram.count && dirty_ram.blocks[i].start <= last;
+}
+
+void ram_blocks_free(void)
+{
+    int i;
+
+    for (i = 0; i < dirty_ram.count; i++) {
+        tlib_free(dirty_ram.blocks[i].phys_dirty);
+    }
+    if (dirty_ram.blocks != NULL) {
+        tlib_free(dirty_ram.blocks);
+    }
+    memset(&dirty_ram, 0, sizeof(dirty_ram));
+}
+
 static void tlb_protect_code(ram_addr_t ram_addr);
 static void tlb_unprotect_code_phys(CPUState *env, ram_addr_t ram_addr, target_ulong vaddr);
 #define mmap_lock()   do { } while(0)
@@ -332,12 +509,128 @@ static void tlb_unprotect_code_phys(CPUState *env, ram_addr_t ram_addr, target_u
 
 #define DEFAULT_CODE_GEN_BUFFER_SIZE (32 * 1024 * 1024)
 
+#define CODE_GEN_HUGE_PAGE_SIZE  (2 * 1024 * 1024)
+#define CODE_GEN_PROLOGUE_SIZE   1024
+
+/* whole mapping, including the prologue when it is placed at its end */
+static uintptr_t code_gen_mapping_size;
+
+#if defined(__linux__)
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0x0004U
+#endif
+
+static void code_gen_advise_huge_pages(void *addr, uintptr_t size)
+{
+#ifdef MADV_HUGEPAGE
+    /* transparent huge pages, if the host has them enabled */
+    madvise(addr, size, MADV_HUGEPAGE);
+#endif
+}
+
+static void *code_gen_map_anonymous(void *start, uintptr_t size, int flags)
+{
+    void *buffer = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (translation_cache_options & TRANSLATION_CACHE_HUGE_PAGES) {
+        /* only succeeds if the host has huge pages reserved; without the
+           reservation a huge page fault would raise SIGBUS instead */
+        buffer = mmap(start, size, PROT_WRITE | PROT_READ | PROT_EXEC, (flags & ~MAP_NORESERVE) | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (buffer == MAP_FAILED) {
+        buffer = mmap(start, size, PROT_WRITE | PROT_READ | PROT_EXEC, flags, -1, 0);
+        if (buffer != MAP_FAILED && (translation_cache_options & TRANSLATION_CACHE_HUGE_PAGES)) {
+            code_gen_advise_huge_pages(buffer, size);
+        }
+    }
+    return buffer;
+}
+
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__NR_memfd_create)
+static bool code_gen_map_views(void *start, uintptr_t size, int flags, unsigned int memfd_flags)
+{
+    uint8_t *rx, *rw;
+    int fd;
+
+    fd = syscall(__NR_memfd_create, "tlib-code-gen", MFD_CLOEXEC | memfd_flags);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return false;
+    }
+    flags = (flags & ~(MAP_PRIVATE | MAP_ANONYMOUS)) | MAP_SHARED;
+    rx = mmap(start, size, PROT_READ | PROT_EXEC, flags, fd, 0);
+    rw = rx == MAP_FAILED ? MAP_FAILED : mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    /* the mappings keep the memory alive */
+    close(fd);
+    if (rw == MAP_FAILED) {
+        if (rx != MAP_FAILED) {
+            munmap(rx, size);
+        }
+        return false;
+    }
+    code_gen_buffer = rx;
+    tcg->code_gen_rw_offset = rw - rx;
+    return true;
+}
+#endif
+
+/* Map the same memory twice, executable at 'code_gen_buffer' and writable
+   'tcg->code_gen_rw_offset' bytes further, so that no page is ever both
+   writable and executable. */
+static bool code_gen_map_split_wx(void *start, uintptr_t size, int flags)
+{
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__NR_memfd_create)
+    if (translation_cache_options & TRANSLATION_CACHE_HUGE_PAGES) {
+        /* only succeeds if the host has huge pages reserved */
+        if (code_gen_map_views(start, size, flags, MFD_HUGETLB)) {
+            return true;
+        }
+    }
+    if (!code_gen_map_views(start, size, flags, 0)) {
+        return false;
+    }
+    if (translation_cache_options & TRANSLATION_CACHE_HUGE_PAGES) {
+        code_gen_advise_huge_pages(code_gen_buffer, size);
+        code_gen_advise_huge_pages(code_gen_buffer + tcg->code_gen_rw_offset, size);
+    }
+    return true;
+#else
+    /* the code generator of this host does not support separate views */
+    return false;
+#endif
+}
+#endif
+
+#if defined(__x86_64__)
+/* Ask for the buffer to end just below the library code, so that calls
+   from the translated code to helpers can be direct. The kernel picks
+   another place if this one is taken. */
+static void *code_gen_hint(uintptr_t size)
+{
+    uintptr_t text = (uintptr_t)code_gen_hint;
+
+    if (text < size + CODE_GEN_HUGE_PAGE_SIZE) {
+        return NULL;
+    }
+    return (void *)((text - size - CODE_GEN_HUGE_PAGE_SIZE) & ~(CODE_GEN_HUGE_PAGE_SIZE - 1));
+}
+#endif
+
 static void code_gen_alloc()
 {
     code_gen_buffer_size = translation_cache_size;
     if (code_gen_buffer_size < MIN_CODE_GEN_BUFFER_SIZE) {
         code_gen_buffer_size = MIN_CODE_GEN_BUFFER_SIZE;
     }
+    tcg->code_gen_rw_offset = 0;
     /* The code gen buffer location may have constraints depending on
        the host cpu and OS */
 #if defined(__linux__)
@@ -347,11 +640,11 @@ static void code_gen_alloc()
 
         flags = MAP_PRIVATE | MAP_ANONYMOUS;
 #if defined(__x86_64__)
-        flags |= MAP_32BIT;
-        /* Cannot map more than that */
-        if (code_gen_buffer_size > (800 * 1024 * 1024)) {
-            code_gen_buffer_size = (800 * 1024 * 1024);
-        }
+        /* Helpers and the prologue are reached with 32-bit displacements
+           when in range; the code generator and tb_add_jump handle the
+           parts of a larger buffer that are further away. */
+        start = code_gen_hint(code_gen_buffer_size);
+        flags |= MAP_NORESERVE;
 #elif defined(__arm__)
         /* Map the buffer below 32M, so we can use direct calls and branches */
         flags |= MAP_FIXED;
@@ -360,7 +653,21 @@ static void code_gen_alloc()
             code_gen_buffer_size = 16 * 1024 * 1024;
         }
 #endif
-        code_gen_buffer = mmap(start, code_gen_buffer_size, PROT_WRITE | PROT_READ | PROT_EXEC, flags, -1, 0);
+        if (translation_cache_options & TRANSLATION_CACHE_HUGE_PAGES) {
+            code_gen_buffer_size = (code_gen_buffer_size + CODE_GEN_HUGE_PAGE_SIZE - 1) & ~(CODE_GEN_HUGE_PAGE_SIZE - 1);
+        }
+        code_gen_mapping_size = code_gen_buffer_size;
+        if ((translation_cache_options & TRANSLATION_CACHE_SPLIT_WX) &&
+            code_gen_map_split_wx(start, code_gen_mapping_size, flags)) {
+            /* the prologue cannot be made executable in place */
+            code_gen_buffer_size -= CODE_GEN_PROLOGUE_SIZE;
+            tcg->code_gen_prologue = code_gen_buffer + code_gen_buffer_size;
+        } else {
+            if (translation_cache_options & TRANSLATION_CACHE_SPLIT_WX) {
+                tlib_printf(LOG_LEVEL_WARNING, "Could not map the translation cache twice, using a single mapping");
+            }
+            code_gen_buffer = code_gen_map_anonymous(start, code_gen_mapping_size, flags);
+        }
         // let's give some feedback about what size was actually used
         tlib_on_translation_cache_size_change(code_gen_buffer_size);
         if (code_gen_buffer == MAP_FAILED) {
@@ -371,24 +678,46 @@ static void code_gen_alloc()
     code_gen_buffer = tlib_malloc(code_gen_buffer_size);
     map_exec(code_gen_buffer, code_gen_buffer_size);
 #endif
-    map_exec(tcg->code_gen_prologue, 1024);
+    if (tcg->code_gen_rw_offset == 0) {
+        map_exec(tcg->code_gen_prologue, CODE_GEN_PROLOGUE_SIZE);
+    }
     code_gen_buffer_max_size = code_gen_buffer_size - (TCG_MAX_OP_SIZE * OPC_BUF_SIZE);
     code_gen_max_blocks = code_gen_buffer_size / CODE_GEN_AVG_BLOCK_SIZE;
+#if defined(__linux__)
+    /* grows with the buffer; only the descriptors in use are backed by memory */
+    tbs = mmap(NULL, code_gen_max_blocks * sizeof(TranslationBlock), PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (tbs == MAP_FAILED) {
+        tlib_abort("Could not allocate translation block descriptors\n");
+    }
+#else
     tbs = tlib_malloc(code_gen_max_blocks * sizeof(TranslationBlock));
+#endif
 }
 
 void code_gen_free(void)
 {
 #if defined(__linux__)
     int retval;
-    retval = munmap(code_gen_buffer, code_gen_buffer_size);
+    retval = munmap(code_gen_buffer, code_gen_mapping_size);
+    if (retval == 0 && tcg->code_gen_rw_offset != 0) {
+        retval = munmap(code_gen_buffer + tcg->code_gen_rw_offset, code_gen_mapping_size);
+    }
     if (retval == -1) {
         tlib_abort("Could not free dynamic translator buffer\n");
     }
+    munmap(tbs, code_gen_max_blocks * sizeof(TranslationBlock));
 #else
     tlib_free(code_gen_buffer);
-#endif
     tlib_free(tbs);
+#endif
+}
+
+/* Bytes of the translation cache left from 'tc_ptr' on. tb_alloc only
+   leaves enough for a block of OPC_BUF_SIZE ops. */
+uintptr_t code_gen_buffer_room(const uint8_t *tc_ptr)
+{
+    return code_gen_buffer + code_gen_buffer_size - tc_ptr;
 }
 
 TCGv_ptr cpu_env;
@@ -405,12 +734,15 @@ void cpu_exec_init_all()
        initialize the prologue now.  */
     tcg_prologue_init();
     cpu_env = tcg_global_reg_new_ptr(TCG_AREG0, "env");
+    tcg->ctx->env = cpu_env;
 }
 
 void cpu_exec_init(CPUState *env)
 {
     cpu = env;
     QTAILQ_INIT(&cpu->breakpoints);
+    QTAILQ_INIT(&cpu->watchpoints);
+    cpu->phys_translation_cache_generation = 1;
 }
 
 /* Allocate a new translation block. Flush the translation buffer if
@@ -425,6 +757,7 @@ static TranslationBlock *tb_alloc(target_ulong pc)
     tb = &tbs[nb_tbs++];
     tb->pc = pc;
     tb->cflags = 0;
+    tb->profile = NULL;
     return tb;
 }
 
@@ -434,6 +767,7 @@ void tb_free(TranslationBlock *tb)
        Ignore the hard cases and just back up if this TB happens to
        be the last one generated.  */
     if (nb_tbs > 0 && tb == &tbs[nb_tbs - 1]) {
+        memory_trace_publish();
         code_gen_ptr = tb->tc_ptr;
         nb_tbs--;
     }
@@ -445,7 +779,6 @@ static inline void invalidate_page_bitmap(PageDesc *p)
         tlib_free(p->code_bitmap);
         p->code_bitmap = NULL;
     }
-    p->code_write_count = 0;
 }
 
 /* Set to NULL all the 'first_tb' fields in all PageDescs. */
@@ -479,6 +812,74 @@ static void page_flush_tb(void)
     }
 }
 
+typedef struct SmcStatisticsCursor {
+    SmcPageStatistics *out;
+    uint32_t max_entries;
+    uint32_t count;
+    bool reset;
+} SmcStatisticsCursor;
+
+static void smc_statistics_walk(int level, void **lp, tb_page_addr_t index, SmcStatisticsCursor *cursor)
+{
+    SmcPageStatistics *entry;
+    PageDesc *pd;
+    int i;
+
+    if (*lp == NULL) {
+        return;
+    }
+    if (level > 0) {
+        for (i = 0; i < L2_SIZE; ++i) {
+            smc_statistics_walk(level - 1, ((void **)*lp) + i, (index << L2_BITS) | i, cursor);
+        }
+        return;
+    }
+    pd = *lp;
+    for (i = 0; i < L2_SIZE; ++i) {
+        if (cursor->reset) {
+            pd[i].write_count = 0;
+            pd[i].code_write_count = 0;
+            pd[i].invalidate_count = 0;
+            pd[i].single_insn = false;
+            continue;
+        }
+        if ((pd[i].write_count == 0 && pd[i].invalidate_count == 0) || cursor->count == cursor->max_entries) {
+            continue;
+        }
+        entry = &cursor->out[cursor->count++];
+        entry->page_address = (uint64_t)((index << L2_BITS) | i) << TARGET_PAGE_BITS;
+        entry->writes = pd[i].write_count;
+        entry->code_writes = pd[i].code_write_count;
+        entry->invalidations = pd[i].invalidate_count;
+        entry->single_insn = pd[i].single_insn;
+    }
+}
+
+/* Fill 'out' with the statistics of up to 'max_entries' pages that had
+   code invalidated or written, in address order. Returns the number of
+   entries filled. */
+uint32_t smc_get_statistics(SmcPageStatistics *out, uint32_t max_entries)
+{
+    SmcStatisticsCursor cursor = { .out = out, .max_entries = max_entries };
+    int i;
+
+    for (i = 0; i < V_L1_SIZE; i++) {
+        smc_statistics_walk(V_L1_SHIFT / L2_BITS - 1, l1_map + i, i, &cursor);
+    }
+    return cursor.count;
+}
+
+/* also returns the pages to regular translation */
+void smc_reset_statistics(void)
+{
+    SmcStatisticsCursor cursor = { .reset = true };
+    int i;
+
+    for (i = 0; i < V_L1_SIZE; i++) {
+        smc_statistics_walk(V_L1_SHIFT / L2_BITS - 1, l1_map + i, i, &cursor);
+    }
+}
+
 /* flush all the translation blocks */
 /* XXX: tb_flush is currently not thread safe */
 void tb_flush(CPUState *env1)
@@ -487,15 +888,19 @@ void tb_flush(CPUState *env1)
         cpu_abort(env1, "Internal error: code buffer overflow\n");
     }
 
+    /* the pending trace entries are resolved with the blocks */
+    memory_trace_publish();
+
     nb_tbs = 0;
     memset(cpu->tb_jmp_cache, 0, TB_JMP_CACHE_SIZE * sizeof (void *));
     memset(tb_phys_hash, 0, CODE_GEN_PHYS_HASH_SIZE * sizeof (void *));
     page_flush_tb();
+    cpu->watchpoint_step_tb = NULL;
 
     code_gen_ptr = code_gen_buffer;
     /* XXX: flush processor icache at this point if cache flush is
        expensive */
-    tb_flush_count++;
+    env1->statistics.tb_flushes++;
 }
 
 /* invalidate one TB */
@@ -590,6 +995,9 @@ void tb_phys_invalidate(TranslationBlock *tb, tb_page_addr_t page_addr)
     }
 
     tb_invalidated_flag = 1;
+    if (cpu->watchpoint_step_tb == tb) {
+        cpu->watchpoint_step_tb = NULL;
+    }
 
     /* remove the TB from the hash list */
     h = tb_jmp_cache_hash_func(tb->pc);
@@ -616,7 +1024,10 @@ void tb_phys_invalidate(TranslationBlock *tb, tb_page_addr_t page_addr)
     }
     tb->jmp_first = (TranslationBlock *)((uintptr_t)tb | 2); /* fail safe */
 
-    tb_phys_invalidate_count++;
+    cpu->statistics.tb_invalidations++;
+    if (tb->profile != NULL) {
+        tb->profile->invalidations++;
+    }
 }
 
 static inline void set_bits(uint8_t *tab, int start, int len)
@@ -646,9 +1057,29 @@ static inline void set_bits(uint8_t *tab, int start, int len)
     }
 }
 
+static void page_bitmap_add_tb(PageDesc *p, TranslationBlock *tb, int n)
+{
+    int tb_start, tb_end;
+
+    /* NOTE: this is subtle as a TB may span two physical pages */
+    if (n == 0) {
+        /* NOTE: tb_end may be after the end of the page, but
+           it is not a problem */
+        tb_start = tb->pc & ~TARGET_PAGE_MASK;
+        tb_end = tb_start + tb->size;
+        if (tb_end > TARGET_PAGE_SIZE) {
+            tb_end = TARGET_PAGE_SIZE;
+        }
+    } else {
+        tb_start = 0;
+        tb_end = ((tb->pc + tb->size) & ~TARGET_PAGE_MASK);
+    }
+    set_bits(p->code_bitmap, tb_start, tb_end - tb_start);
+}
+
 static void build_page_bitmap(PageDesc *p)
 {
-    int n, tb_start, tb_end;
+    int n;
     TranslationBlock *tb;
 
     p->code_bitmap = tlib_mallocz(TARGET_PAGE_SIZE / 8);
@@ -657,33 +1088,39 @@ static void build_page_bitmap(PageDesc *p)
     while (tb != NULL) {
         n = (uintptr_t)tb & 3;
         tb = (TranslationBlock *)((uintptr_t)tb & ~3);
-        /* NOTE: this is subtle as a TB may span two physical pages */
-        if (n == 0) {
-            /* NOTE: tb_end may be after the end of the page, but
-               it is not a problem */
-            tb_start = tb->pc & ~TARGET_PAGE_MASK;
-            tb_end = tb_start + tb->size;
-            if (tb_end > TARGET_PAGE_SIZE) {
-                tb_end = TARGET_PAGE_SIZE;
-            }
-        } else {
-            tb_start = 0;
-            tb_end = ((tb->pc + tb->size) & ~TARGET_PAGE_MASK);
-        }
-        set_bits(p->code_bitmap, tb_start, tb_end - tb_start);
+        page_bitmap_add_tb(p, tb, n);
         tb = tb->page_next[n];
     }
 }
 
+static inline uint64_t statistics_clock_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 TranslationBlock *tb_gen_code(CPUState *env, target_ulong pc, target_ulong cs_base, int flags, uint16_t cflags)
 {
     TranslationBlock *tb;
+    PageDesc *p;
     uint8_t *tc_ptr;
     tb_page_addr_t phys_pc, phys_page2;
     target_ulong virt_page2;
     int code_gen_size;
+    int dumped = 0;
+    uint64_t translation_start, translation_time;
 
     phys_pc = get_page_addr_code(env, pc);
+    if (cflags == 0) {
+        p = page_find(phys_pc >> TARGET_PAGE_BITS);
+        if (p != NULL && p->single_insn) {
+            /* a modification then invalidates a single instruction and
+               never the rest of the block being executed */
+            cflags = 1;
+        }
+    }
     tb = tb_alloc(pc);
     if (!tb) {
         /* flush must be done */
@@ -698,7 +1135,18 @@ TranslationBlock *tb_gen_code(CPUState *env, target_ulong pc, target_ulong cs_ba
     tb->cs_base = cs_base;
     tb->flags = flags;
     tb->cflags = cflags;
+    if (unlikely(tb_dump_parts != 0)) {
+        dumped = tb_dump_begin(tb);
+    }
+    translation_start = statistics_clock_ns();
     cpu_gen_code(env, tb, &code_gen_size);
+    translation_time = statistics_clock_ns() - translation_start;
+    env->statistics.translation_time_ns += translation_time;
+    env->statistics.tb_translations++;
+    env->statistics.translated_code_bytes += code_gen_size;
+    env->statistics.translated_slow_path_bytes += tcg->ctx->code_slow_path_size;
+    env->statistics.translated_reg_spills += tcg->ctx->reg_spills;
+    env->statistics.translated_reg_reloads += tcg->ctx->reg_reloads;
     code_gen_ptr = (void *)(((uintptr_t)code_gen_ptr + code_gen_size + CODE_GEN_ALIGN - 1) & ~(CODE_GEN_ALIGN - 1));
 
     /* check next page if needed */
@@ -711,6 +1159,15 @@ TranslationBlock *tb_gen_code(CPUState *env, target_ulong pc, target_ulong cs_ba
         }
     }
     tb_link_page(tb, phys_pc, phys_page2);
+    if (unlikely(tb_profiling_enabled())) {
+        tb_profile_translated(tb, phys_pc, translation_time, code_gen_size);
+    }
+    if (unlikely(perf_map_mode != PERF_MAP_DISABLED)) {
+        perf_map_record(tb, code_gen_size);
+    }
+    if (unlikely(dumped)) {
+        tb_dump_end(tb, code_gen_size);
+    }
     return tb;
 }
 
@@ -739,10 +1196,6 @@ void tb_invalidate_phys_page_range_inner(tb_page_addr_t start, tb_page_addr_t en
     if (!p) {
         return;
     }
-    if (!p->code_bitmap && ++p->code_write_count >= SMC_BITMAP_USE_THRESHOLD && is_cpu_write_access) {
-        /* build code bitmap */
-        build_page_bitmap(p);
-    }
 
     /* we remove all the TBs in the range [start, end[ */
     /* XXX: see if in some cases it could be faster to invalidate all the code */
@@ -792,6 +1245,9 @@ void tb_invalidate_phys_page_range_inner(tb_page_addr_t start, tb_page_addr_t en
                 env->current_tb = NULL;
             }
             tb_phys_invalidate(tb, -1);
+            if (++p->invalidate_count >= SMC_SINGLE_INSN_THRESHOLD) {
+                p->single_insn = true;
+            }
             if (env) {
                 env->current_tb = saved_tb;
                 if (env->interrupt_request && env->current_tb) {
@@ -837,16 +1293,21 @@ static inline void tb_invalidate_phys_page_fast(tb_page_addr_t start, int len)
     if (!p) {
         return;
     }
-    if (p->code_bitmap) {
+    p->write_count++;
+    if (p->first_tb != NULL) {
+        if (!p->code_bitmap) {
+            build_page_bitmap(p);
+        }
         offset = start & ~TARGET_PAGE_MASK;
         b = p->code_bitmap[offset >> 3] >> (offset & 7);
-        if (b & ((1 << len) - 1)) {
-            goto do_invalidate;
+        if (!(b & ((1 << len) - 1))) {
+            /* data next to code, nothing to invalidate */
+            return;
         }
-    } else {
-do_invalidate:
-        tb_invalidate_phys_page_range(start, start + len, 1);
+        p->code_write_count++;
     }
+    /* with no code left this also drops the write protection */
+    tb_invalidate_phys_page_range(start, start + len, 1);
 }
 
 /* add the tb in the target page and protect it if necessary */
@@ -860,7 +1321,9 @@ static inline void tb_alloc_page(TranslationBlock *tb, unsigned int n, tb_page_a
     tb->page_next[n] = p->first_tb;
     page_already_protected = p->first_tb != NULL;
     p->first_tb = (TranslationBlock *)((uintptr_t)tb | n);
-    invalidate_page_bitmap(p);
+    if (p->code_bitmap) {
+        page_bitmap_add_tb(p, tb, n);
+    }
 
     /* if some code is already present, then the pages are already
        protected. So we handle the case where only the first TB is
@@ -899,10 +1362,10 @@ void tb_link_page(TranslationBlock *tb, tb_page_addr_t phys_pc, tb_page_addr_t p
     tb->jmp_next[1] = NULL;
 
     /* init original jump addresses */
-    if (tb->tb_next_offset[0] != 0xffff) {
+    if (tb->tb_next_offset[0] != 0xffffffff) {
         tb_reset_jump(tb, 0);
     }
-    if (tb->tb_next_offset[1] != 0xffff) {
+    if (tb->tb_next_offset[1] != 0xffffffff) {
         tb_reset_jump(tb, 1);
     }
 
@@ -1026,6 +1489,134 @@ void cpu_breakpoint_remove_all(CPUState *env, int mask)
     }
 }
 
+static inline bool watchpoint_overlaps(CPUWatchpoint *wp, target_ulong addr, target_ulong len)
+{
+    return addr - wp->vaddr < wp->len || wp->vaddr - addr < len;
+}
+
+/* Drop the TLB entries of the watched pages, so that they are refilled
+   with or without the TLB_FORCE_SLOW bit. */
+static void watchpoint_flush_tlb(CPUState *env, CPUWatchpoint *wp)
+{
+    target_ulong page = wp->vaddr & TARGET_PAGE_MASK;
+    target_ulong last_page = (wp->vaddr + (wp->len - 1)) & TARGET_PAGE_MASK;
+
+    if ((last_page - page) >> TARGET_PAGE_BITS >= CPU_TLB_SIZE) {
+        tlb_flush(env, 1);
+        return;
+    }
+    for (;;) {
+        tlb_flush_page(env, page);
+        if (page == last_page) {
+            break;
+        }
+        page += TARGET_PAGE_SIZE;
+    }
+}
+
+/* Add a watchpoint. Only accesses to the pages it covers leave the
+   inline fast path, the exact range is checked in the softmmu helpers.  */
+int cpu_watchpoint_insert(CPUState *env, target_ulong addr, target_ulong len, int flags)
+{
+    CPUWatchpoint *wp;
+
+    if (len == 0 || addr + (len - 1) < addr || !(flags & BP_MEM_ACCESS)) {
+        return -EINVAL;
+    }
+    wp = tlib_malloc(sizeof(*wp));
+    wp->vaddr = addr;
+    wp->len = len;
+    wp->flags = flags & BP_MEM_ACCESS;
+    QTAILQ_INSERT_TAIL(&env->watchpoints, wp, entry);
+
+    watchpoint_flush_tlb(env, wp);
+    return 0;
+}
+
+/* Remove a specific watchpoint.  */
+int cpu_watchpoint_remove(CPUState *env, target_ulong addr, target_ulong len, int flags)
+{
+    CPUWatchpoint *wp;
+
+    QTAILQ_FOREACH(wp, &env->watchpoints, entry) {
+        if (wp->vaddr == addr && wp->len == len && wp->flags == (flags & BP_MEM_ACCESS)) {
+            QTAILQ_REMOVE(&env->watchpoints, wp, entry);
+            watchpoint_flush_tlb(env, wp);
+            tlib_free(wp);
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
+void cpu_watchpoint_remove_all(CPUState *env)
+{
+    CPUWatchpoint *wp, *next;
+
+    QTAILQ_FOREACH_SAFE(wp, &env->watchpoints, entry, next) {
+        QTAILQ_REMOVE(&env->watchpoints, wp, entry);
+        watchpoint_flush_tlb(env, wp);
+        tlib_free(wp);
+    }
+}
+
+/* BP_MEM_* flags of the watchpoints covering any part of the page */
+static int watchpoint_page_flags(CPUState *env, target_ulong page)
+{
+    CPUWatchpoint *wp;
+    int flags = 0;
+
+    QTAILQ_FOREACH(wp, &env->watchpoints, entry) {
+        if (watchpoint_overlaps(wp, page, TARGET_PAGE_SIZE)) {
+            flags |= wp->flags;
+        }
+    }
+    return flags;
+}
+
+/* Called by the softmmu helpers before an access. On a hit the CPU state
+   is restored to the accessing instruction and the execution stops with
+   EXCP_WATCHPOINT; when it resumes, that instruction is executed once
+   without checking watchpoints.  */
+void cpu_check_watchpoint(CPUState *env, target_ulong addr, int len, int flags, uintptr_t retaddr)
+{
+    CPUWatchpoint *wp;
+    TranslationBlock *tb;
+    int counted, executed_instructions = 0;
+
+    if (env->watchpoint_stepping) {
+        return;
+    }
+    QTAILQ_FOREACH(wp, &env->watchpoints, entry) {
+        if (!(wp->flags & flags) || !watchpoint_overlaps(wp, addr, len)) {
+            continue;
+        }
+        env->watchpoint_hit = 1;
+        env->watchpoint_hit_address = addr;
+        env->watchpoint_hit_flags = flags;
+
+        /* accesses done by C helpers are not in the generated code, the
+           state is then what the helper was called with */
+        tb = tb_find_pc(retaddr);
+        if (tb != NULL) {
+            counted = tb->instructions_count_dirty;
+            executed_instructions = cpu_restore_state_and_restore_instructions_count(env, tb, retaddr);
+            if (counted && executed_instructions > 0) {
+                /* the accessing instruction did not complete */
+                executed_instructions--;
+                env->instructions_count_value--;
+                env->instructions_count_total_value--;
+            }
+        }
+        if (env->block_finished_hook_present) {
+            tlib_on_block_finished(CPU_PC(env), executed_instructions);
+        }
+        env->exception_index = EXCP_WATCHPOINT;
+        env->current_tb = NULL;
+        longjmp(env->jmp_env, 1);
+    }
+}
+
 /* mask must never be zero, except for A20 change call */
 static void handle_interrupt(CPUState *env, int mask)
 {
@@ -1096,6 +1687,14 @@ static CPUTLBEntry s_cputlb_empty_entry = {
     .addr_read = -1, .addr_write = -1, .addr_code  = -1, .addend     = -1,
 };
 
+static inline void phys_translation_cache_flush(CPUState *env)
+{
+    if (unlikely(++env->phys_translation_cache_generation == 0)) {
+        memset(env->phys_translation_cache, 0, sizeof(env->phys_translation_cache));
+        env->phys_translation_cache_generation = 1;
+    }
+}
+
 /* NOTE: if flush_global is true, also flush global entries (not
    implemented yet) */
 void tlb_flush(CPUState *env, int flush_global)
@@ -1114,10 +1713,11 @@ void tlb_flush(CPUState *env, int flush_global)
     }
 
     memset(env->tb_jmp_cache, 0, TB_JMP_CACHE_SIZE * sizeof (void *));
+    phys_translation_cache_flush(env);
 
     env->tlb_flush_addr = -1;
     env->tlb_flush_mask = 0;
-    tlb_flush_count++;
+    env->statistics.tlb_flushes++;
 }
 
 static inline void tlb_flush_entry(CPUTLBEntry *tlb_entry, target_ulong addr)
@@ -1139,6 +1739,7 @@ void tlb_flush_page(CPUState *env, target_ulong addr)
         tlb_flush(env, 1);
         return;
     }
+    env->statistics.tlb_page_flushes++;
     /* must reset current TB so that interrupts cannot modify the
        links while we are modifying them */
     env->current_tb = NULL;
@@ -1150,10 +1751,85 @@ void tlb_flush_page(CPUState *env, target_ulong addr)
     }
 
     tlb_flush_jmp_cache(env, addr);
+    phys_translation_cache_flush(env);
 }
 
-/* update the TLBs so that writes to code in the virtual page 'addr'
-   can be detected */
+/* true if [start1, last1] and [start2, last2] share an address */
+static inline bool ram_ranges_overlap(ram_addr_t start1, ram_addr_t last1, ram_addr_t start2, ram_addr_t last2)
+{
+    return start1 <= last2 && start2 <= last1;
+}
+
+/* Dirty page log: RAM regions whose written pages are recorded in a
+   bitmap, one bit per page, until the host collects them. */
+typedef struct DirtyLogRegion {
+    ram_addr_t start;
+    ram_addr_t size;
+    uint64_t *bitmap;
+} DirtyLogRegion;
+
+static DirtyLogRegion dirty_log_regions[MAX_DIRTY_LOG_REGIONS];
+static int dirty_log_regions_count;
+
+static inline DirtyLogRegion *dirty_log_region_find(ram_addr_t addr)
+{
+    int i;
+
+    for (i = 0; i < dirty_log_regions_count; i++) {
+        if (addr - dirty_log_regions[i].start < dirty_log_regions[i].size) {
+            return &dirty_log_regions[i];
+        }
+    }
+    return NULL;
+}
+
+static inline bool dirty_log_regions_overlap(ram_addr_t start, ram_addr_t last)
+{
+    int i;
+
+    for (i = 0; i < dirty_log_regions_count; i++) {
+        if (ram_ranges_overlap(start, last, dirty_log_regions[i].start,
+                               dirty_log_regions[i].start + (dirty_log_regions[i].size - 1))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* true if 'addr' is logged and was not written since the last collection */
+static inline bool dirty_log_page_is_clean(ram_addr_t addr)
+{
+    DirtyLogRegion *r;
+    ram_addr_t page;
+
+    if (likely(dirty_log_regions_count == 0)) {
+        return false;
+    }
+    r = dirty_log_region_find(addr);
+    if (r == NULL) {
+        return false;
+    }
+    page = (addr - r->start) >> TARGET_PAGE_BITS;
+    return !(r->bitmap[page / 64] & (1ull << (page % 64)));
+}
+
+static inline void dirty_log_mark(ram_addr_t addr)
+{
+    DirtyLogRegion *r;
+    ram_addr_t page;
+
+    if (likely(dirty_log_regions_count == 0)) {
+        return;
+    }
+    r = dirty_log_region_find(addr);
+    if (r != NULL) {
+        page = (addr - r->start) >> TARGET_PAGE_BITS;
+        r->bitmap[page / 64] |= 1ull << (page % 64);
+    }
+}
+
+/* update the TLBs so that writes to code in the virtual page 'addr'
+   can be detected */
 static void tlb_protect_code(ram_addr_t ram_addr)
 {
     cpu_physical_memory_reset_dirty(ram_addr, ram_addr + TARGET_PAGE_SIZE, CODE_DIRTY_FLAG);
@@ -1166,13 +1842,24 @@ static void tlb_unprotect_code_phys(CPUState *env, ram_addr_t ram_addr, target_u
     cpu_physical_memory_set_dirty_flags(ram_addr, CODE_DIRTY_FLAG);
 }
 
-static inline void tlb_reset_dirty_range(CPUTLBEntry *tlb_entry, uintptr_t start, uintptr_t length)
+static inline void tlb_reset_dirty_range(CPUTLBEntry *tlb_entry, uintptr_t start, uintptr_t length, int dirty_flags)
 {
     uintptr_t addr;
-    if ((tlb_entry->addr_write & ~TARGET_PAGE_MASK) == IO_MEM_RAM) {
+    target_ulong tlb_flags = tlb_entry->addr_write & ~(TARGET_PAGE_MASK | TLB_FORCE_SLOW);
+
+    if (dirty_flags & HOST_MMIO_DIRTY_FLAG) {
+        /* the softmmu helpers write TLB_NOTDIRTY pages directly, only
+           TLB_MMIO makes the store reach notdirty_mem_write */
+        if (tlb_flags == IO_MEM_RAM || tlb_flags == TLB_NOTDIRTY) {
+            addr = (tlb_entry->addr_write & TARGET_PAGE_MASK) + tlb_entry->addend;
+            if ((addr - start) < length) {
+                tlb_entry->addr_write = (tlb_entry->addr_write & (TARGET_PAGE_MASK | TLB_FORCE_SLOW)) | TLB_MMIO;
+            }
+        }
+    } else if (tlb_flags == IO_MEM_RAM) {
         addr = (tlb_entry->addr_write & TARGET_PAGE_MASK) + tlb_entry->addend;
         if ((addr - start) < length) {
-            tlb_entry->addr_write = (tlb_entry->addr_write & TARGET_PAGE_MASK) | TLB_NOTDIRTY;
+            tlb_entry->addr_write = (tlb_entry->addr_write & (TARGET_PAGE_MASK | TLB_FORCE_SLOW)) | TLB_NOTDIRTY;
         }
     }
 }
@@ -1204,15 +1891,47 @@ void cpu_physical_memory_reset_dirty(ram_addr_t start, ram_addr_t end, int dirty
     int mmu_idx;
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
         for (i = 0; i < CPU_TLB_SIZE; i++) {
-            tlb_reset_dirty_range(&cpu->tlb_table[mmu_idx][i], start1, length);
+            tlb_reset_dirty_range(&cpu->tlb_table[mmu_idx][i], start1, length, dirty_flags);
         }
     }
 }
 
-static inline void tlb_set_dirty1(CPUTLBEntry *tlb_entry, target_ulong vaddr)
+/* Make every store to RAM in [start, end) take the slow path again. The
+   entries are matched by ram address through the iotlb, so unlike
+   cpu_physical_memory_reset_dirty the range may span several ram blocks. */
+static void tlb_trap_writes_range(CPUState *env, ram_addr_t start, ram_addr_t end)
 {
-    if (tlb_entry->addr_write == (vaddr | TLB_NOTDIRTY)) {
-        tlb_entry->addr_write = vaddr;
+    CPUTLBEntry *tlb;
+    target_phys_addr_t *iotlb;
+    target_phys_addr_t ram_addr;
+    target_ulong tlb_flags;
+    int mmu_idx, i;
+
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        tlb = env->tlb_table[mmu_idx];
+        iotlb = env->iotlb[mmu_idx];
+        for (i = 0; i < CPU_TLB_SIZE; i++) {
+            tlb_flags = tlb[i].addr_write & ~(TARGET_PAGE_MASK | TLB_FORCE_SLOW);
+            if (tlb_flags != IO_MEM_RAM && tlb_flags != TLB_NOTDIRTY) {
+                continue;
+            }
+            ram_addr = iotlb[i] + (tlb[i].addr_write & TARGET_PAGE_MASK);
+            if ((ram_addr & ~TARGET_PAGE_MASK) == IO_MEM_NOTDIRTY && (ram_addr & TARGET_PAGE_MASK) - start < end - start) {
+                tlb[i].addr_write = (tlb[i].addr_write & (TARGET_PAGE_MASK | TLB_FORCE_SLOW)) | TLB_MMIO;
+            }
+        }
+    }
+}
+
+static inline void tlb_set_dirty1(CPUTLBEntry *tlb_entry, target_phys_addr_t iotlb, target_ulong vaddr)
+{
+    target_ulong addr_write = tlb_entry->addr_write & ~TLB_FORCE_SLOW;
+
+    if (addr_write == (vaddr | TLB_NOTDIRTY)) {
+        tlb_entry->addr_write &= ~TLB_NOTDIRTY;
+    } else if (addr_write == (vaddr | TLB_MMIO) && (iotlb & ~TARGET_PAGE_MASK) == IO_MEM_NOTDIRTY) {
+        /* write-tracked page that is now marked as written */
+        tlb_entry->addr_write &= ~TLB_MMIO;
     }
 }
 
@@ -1226,7 +1945,7 @@ static inline void tlb_set_dirty(CPUState *env, target_ulong vaddr)
     vaddr &= TARGET_PAGE_MASK;
     i = (vaddr >> TARGET_PAGE_BITS) & (CPU_TLB_SIZE - 1);
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
-        tlb_set_dirty1(&env->tlb_table[mmu_idx][i], vaddr);
+        tlb_set_dirty1(&env->tlb_table[mmu_idx][i], env->iotlb[mmu_idx][i], vaddr);
     }
 }
 
@@ -1265,7 +1984,9 @@ void tlb_set_page(CPUState *env, target_ulong vaddr, target_phys_addr_t paddr, i
     uintptr_t addend;
     CPUTLBEntry *te;
     target_phys_addr_t iotlb;
+    int slow_flags = 0;
 
+    env->statistics.tlb_fills++;
     address = vaddr;
 
     if(size < TARGET_PAGE_SIZE)
@@ -1342,6 +2063,11 @@ void tlb_set_page(CPUState *env, target_ulong vaddr, target_phys_addr_t paddr, i
         if ((pd & ~TARGET_PAGE_MASK) == IO_MEM_ROM || (pd & IO_MEM_ROMD)) {
             /* Write access calls the I/O callback.  */
             te->addr_write = address | TLB_MMIO;
+        } else if ((pd & ~TARGET_PAGE_MASK) == IO_MEM_RAM &&
+                   (!cpu_physical_memory_get_dirty(pd, HOST_MMIO_DIRTY_FLAG) || dirty_log_page_is_clean(pd))) {
+            /* Clean host-backed MMIO or dirty-logged page: the iotlb entry
+               points to notdirty_mem_write, which marks the page as written. */
+            te->addr_write = address | TLB_MMIO;
         } else if ((pd & ~TARGET_PAGE_MASK) == IO_MEM_RAM && !cpu_physical_memory_is_dirty(pd)) {
             te->addr_write = address | TLB_NOTDIRTY;
         } else {
@@ -1350,6 +2076,17 @@ void tlb_set_page(CPUState *env, target_ulong vaddr, target_phys_addr_t paddr, i
     } else {
         te->addr_write = -1;
     }
+    if (unlikely(memory_trace_enabled()) && memory_trace_page_is_traced(paddr & TARGET_PAGE_MASK)) {
+        slow_flags = BP_MEM_ACCESS;
+    } else if (unlikely(!QTAILQ_EMPTY(&env->watchpoints))) {
+        slow_flags = watchpoint_page_flags(env, vaddr & TARGET_PAGE_MASK);
+    }
+    if ((slow_flags & BP_MEM_READ) && te->addr_read != -1) {
+        te->addr_read |= TLB_FORCE_SLOW;
+    }
+    if ((slow_flags & BP_MEM_WRITE) && te->addr_write != -1) {
+        te->addr_write |= TLB_FORCE_SLOW;
+    }
 }
 
 /* register physical memory.
@@ -1414,16 +2151,446 @@ ram_addr_t cpu_get_physical_page_desc(target_phys_addr_t addr)
     return p->phys_offset;
 }
 
+typedef struct HostMmioRegion {
+    target_phys_addr_t start;
+    ram_addr_t size;
+    uint8_t *host_ptr;
+    /* report written pages with a callback at the end of each quantum
+       instead of waiting for the host to poll them */
+    bool notify;
+} HostMmioRegion;
+
+static HostMmioRegion host_mmio_regions[MAX_HOST_MMIO_REGIONS];
+static int host_mmio_regions_count;
+
+typedef struct FileRamRegion {
+    target_phys_addr_t start;
+    ram_addr_t size;
+    uint8_t *host_ptr;
+    /* 'size' rounded up to the host page size */
+    size_t mapped_size;
+} FileRamRegion;
+
+static FileRamRegion file_ram_regions[MAX_FILE_RAM_REGIONS];
+static int file_ram_regions_count;
+
+static inline FileRamRegion *file_ram_region_find(ram_addr_t addr)
+{
+    int i;
+
+    for (i = 0; i < file_ram_regions_count; i++) {
+        if (addr - file_ram_regions[i].start < file_ram_regions[i].size) {
+            return &file_ram_regions[i];
+        }
+    }
+    return NULL;
+}
+
+static inline HostMmioRegion *host_mmio_region_find(ram_addr_t addr)
+{
+    int i;
+
+    for (i = 0; i < host_mmio_regions_count; i++) {
+        if (addr - host_mmio_regions[i].start < host_mmio_regions[i].size) {
+            return &host_mmio_regions[i];
+        }
+    }
+    return NULL;
+}
+
+static inline bool host_mmio_regions_overlap(ram_addr_t start, ram_addr_t last)
+{
+    int i;
+
+    for (i = 0; i < host_mmio_regions_count; i++) {
+        if (ram_ranges_overlap(start, last, host_mmio_regions[i].start,
+                               host_mmio_regions[i].start + (host_mmio_regions[i].size - 1))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline bool file_ram_regions_overlap(ram_addr_t start, ram_addr_t last)
+{
+    int i;
+
+    for (i = 0; i < file_ram_regions_count; i++) {
+        if (ram_ranges_overlap(start, last, file_ram_regions[i].start,
+                               file_ram_regions[i].start + (file_ram_regions[i].size - 1))) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void *get_ram_ptr(ram_addr_t addr)
 {
+    HostMmioRegion *r;
+    FileRamRegion *f;
+
+    if (unlikely(host_mmio_regions_count != 0)) {
+        r = host_mmio_region_find(addr);
+        if (r != NULL) {
+            return r->host_ptr + (addr - r->start);
+        }
+    }
+    if (unlikely(file_ram_regions_count != 0)) {
+        f = file_ram_region_find(addr);
+        if (f != NULL) {
+            return f->host_ptr + (addr - f->start);
+        }
+    }
     return tlib_guest_offset_to_host_ptr(addr);
 }
 
 ram_addr_t ram_addr_from_host(void *ptr)
 {
+    int i;
+    HostMmioRegion *r;
+    FileRamRegion *f;
+
+    for (i = 0; i < host_mmio_regions_count; i++) {
+        r = &host_mmio_regions[i];
+        if ((uint8_t *)ptr >= r->host_ptr && (uint8_t *)ptr - r->host_ptr < r->size) {
+            return r->start + ((uint8_t *)ptr - r->host_ptr);
+        }
+    }
+    for (i = 0; i < file_ram_regions_count; i++) {
+        f = &file_ram_regions[i];
+        if ((uint8_t *)ptr >= f->host_ptr && (uint8_t *)ptr - f->host_ptr < f->size) {
+            return f->start + ((uint8_t *)ptr - f->host_ptr);
+        }
+    }
     return tlib_host_ptr_to_guest_offset(ptr);
 }
 
+/* Register host memory as a RAM-like device window. Reads and writes
+   go straight to 'host_ptr' through the TLB; only the first write to a
+   clean page leaves the fast path, to mark the page as dirty. The caller
+   is responsible for reserving the dirty bytes and mapping the range. */
+int host_mmio_region_add(target_phys_addr_t start, ram_addr_t size, void *host_ptr, bool notify)
+{
+    HostMmioRegion *r;
+
+    if (host_mmio_regions_count == MAX_HOST_MMIO_REGIONS || host_ptr == NULL || size == 0) {
+        return -1;
+    }
+    if ((start | size) & ~TARGET_PAGE_MASK) {
+        return -1;
+    }
+    if (host_mmio_regions_overlap(start, start + (size - 1)) || file_ram_regions_overlap(start, start + (size - 1))) {
+        return -1;
+    }
+    r = &host_mmio_regions[host_mmio_regions_count++];
+    r->start = start;
+    r->size = size;
+    r->host_ptr = host_ptr;
+    r->notify = notify;
+    return 0;
+}
+
+void host_mmio_region_remove(target_phys_addr_t start)
+{
+    HostMmioRegion *r;
+
+    r = host_mmio_region_find(start);
+    if (r == NULL || r->start != start) {
+        return;
+    }
+    ram_blocks_unregister(r->start, r->start + (r->size - 1));
+    *r = host_mmio_regions[--host_mmio_regions_count];
+    /* TLB entries still hold addends into the removed host buffer */
+    tlb_flush(cpu, 1);
+}
+
+/* Get and clear the pages written since the previous call. Returns the
+   number of dirty pages; bit N of 'bitmap' stands for the N-th page of
+   the region. */
+uint32_t host_mmio_region_get_dirty(target_phys_addr_t start, uint64_t *bitmap, uint32_t bitmap_words)
+{
+    HostMmioRegion *r;
+    ram_addr_t i, pages;
+    uint32_t count = 0;
+
+    r = host_mmio_region_find(start);
+    if (r == NULL || r->start != start) {
+        return 0;
+    }
+    pages = r->size >> TARGET_PAGE_BITS;
+    if (pages > (ram_addr_t)bitmap_words * 64) {
+        pages = (ram_addr_t)bitmap_words * 64;
+    }
+    memset(bitmap, 0, bitmap_words * sizeof(uint64_t));
+    for (i = 0; i < pages; i++) {
+        if (cpu_physical_memory_get_dirty(r->start + (i << TARGET_PAGE_BITS), HOST_MMIO_DIRTY_FLAG)) {
+            bitmap[i / 64] |= 1ull << (i % 64);
+            count++;
+        }
+    }
+    if (count != 0) {
+        /* rearm the write tracking on the pages we've just reported */
+        cpu_physical_memory_reset_dirty(r->start, r->start + (pages << TARGET_PAGE_BITS), HOST_MMIO_DIRTY_FLAG);
+    }
+    return count;
+}
+
+/* Called at the end of a quantum: each page written during it is
+   reported once, no matter how many stores hit it. */
+void host_mmio_regions_notify(void)
+{
+    int i;
+    HostMmioRegion *r;
+    ram_addr_t addr;
+    bool any_dirty;
+
+    for (i = 0; i < host_mmio_regions_count; i++) {
+        r = &host_mmio_regions[i];
+        if (!r->notify) {
+            continue;
+        }
+        any_dirty = false;
+        for (addr = r->start; addr - r->start < r->size; addr += TARGET_PAGE_SIZE) {
+            if (cpu_physical_memory_get_dirty(addr, HOST_MMIO_DIRTY_FLAG)) {
+                tlib_on_host_mmio_page_written(addr);
+                any_dirty = true;
+            }
+        }
+        if (any_dirty) {
+            cpu_physical_memory_reset_dirty(r->start, r->start + r->size, HOST_MMIO_DIRTY_FLAG);
+        }
+    }
+}
+
+#ifndef _WIN32
+/* Back [start, start + size) with the file at 'path', starting at
+   'file_offset' (a multiple of the host page size). Nothing is read
+   up front: the host kernel faults pages in on the first access, which
+   is the first TLB fill that touches them. With FILE_RAM_SHARED guest
+   writes go to the file, otherwise they stay private to this process;
+   clean pages are shared through the host page cache in both cases.
+   The part of the range past the end of the file reads as zeros. The
+   caller is responsible for reserving the dirty bytes and mapping the
+   range. */
+int file_ram_region_add(target_phys_addr_t start, ram_addr_t size, const char *path, uint64_t file_offset, uint32_t flags)
+{
+    FileRamRegion *r;
+    struct stat st;
+    size_t mapped_size, file_size;
+    uint8_t *host_ptr;
+    int fd, advice;
+    bool shared = (flags & FILE_RAM_SHARED) != 0;
+
+    if (file_ram_regions_count == MAX_FILE_RAM_REGIONS || path == NULL || size == 0) {
+        return -1;
+    }
+    if (((start | size) & ~TARGET_PAGE_MASK) || (file_offset & (tlib_real_host_page_size - 1))) {
+        return -1;
+    }
+    if (file_ram_regions_overlap(start, start + (size - 1)) || host_mmio_regions_overlap(start, start + (size - 1))) {
+        return -1;
+    }
+    fd = open(path, shared ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || file_offset > (uint64_t)st.st_size) {
+        close(fd);
+        return -1;
+    }
+    mapped_size = (size + tlib_real_host_page_size - 1) & ~(tlib_real_host_page_size - 1);
+    file_size = (uint64_t)st.st_size - file_offset < mapped_size ? st.st_size - file_offset : mapped_size;
+    file_size = (file_size + tlib_real_host_page_size - 1) & ~(tlib_real_host_page_size - 1);
+
+    /* reserve the whole range as zeros, then place the file over its start;
+       accesses past the end of the file would raise SIGBUS otherwise */
+    host_ptr = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (host_ptr == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    if (file_size != 0 && mmap(host_ptr, file_size, PROT_READ | PROT_WRITE, (shared ? MAP_SHARED : MAP_PRIVATE) | MAP_FIXED,
+                               fd, file_offset) == MAP_FAILED) {
+        munmap(host_ptr, mapped_size);
+        close(fd);
+        return -1;
+    }
+    /* the mapping keeps its own reference to the file */
+    close(fd);
+
+    advice = MADV_NORMAL;
+    if (flags & FILE_RAM_SEQUENTIAL) {
+        advice = MADV_SEQUENTIAL;
+    } else if (flags & FILE_RAM_RANDOM) {
+        advice = MADV_RANDOM;
+    }
+    if (advice != MADV_NORMAL) {
+        madvise(host_ptr, mapped_size, advice);
+    }
+    if (flags & FILE_RAM_WILLNEED) {
+        /* start reading in the background */
+        madvise(host_ptr, file_size, MADV_WILLNEED);
+    }
+
+    r = &file_ram_regions[file_ram_regions_count++];
+    r->start = start;
+    r->size = size;
+    r->host_ptr = host_ptr;
+    r->mapped_size = mapped_size;
+    return 0;
+}
+
+void file_ram_region_remove(target_phys_addr_t start)
+{
+    FileRamRegion *r;
+    uint8_t *host_ptr;
+    size_t mapped_size;
+
+    r = file_ram_region_find(start);
+    if (r == NULL || r->start != start) {
+        return;
+    }
+    ram_blocks_unregister(r->start, r->start + (r->size - 1));
+    host_ptr = r->host_ptr;
+    mapped_size = r->mapped_size;
+    *r = file_ram_regions[--file_ram_regions_count];
+    /* TLB entries and translated code still refer to the mapping */
+    tlb_flush(cpu, 1);
+    tb_flush(cpu);
+    munmap(host_ptr, mapped_size);
+}
+
+void file_ram_regions_free(void)
+{
+    int i;
+
+    for (i = 0; i < file_ram_regions_count; i++) {
+        munmap(file_ram_regions[i].host_ptr, file_ram_regions[i].mapped_size);
+    }
+    file_ram_regions_count = 0;
+}
+#else
+int file_ram_region_add(target_phys_addr_t start, ram_addr_t size, const char *path, uint64_t file_offset, uint32_t flags)
+{
+    return -1;
+}
+
+void file_ram_region_remove(target_phys_addr_t start)
+{
+}
+
+void file_ram_regions_free(void)
+{
+}
+#endif
+
+void host_mmio_regions_free(void)
+{
+    /* the host buffers belong to the caller */
+    host_mmio_regions_count = 0;
+}
+
+/* Drop the host MMIO and file RAM regions overlapping [start, last], as
+   a whole: their buffers must not be reached through pages mapped again
+   later. */
+void ram_regions_remove_range(ram_addr_t start, ram_addr_t last)
+{
+    int i;
+
+    if (last < start) {
+        return;
+    }
+    /* removing swaps the last region in, which was already checked */
+    for (i = host_mmio_regions_count - 1; i >= 0; i--) {
+        if (ram_ranges_overlap(start, last, host_mmio_regions[i].start,
+                               host_mmio_regions[i].start + (host_mmio_regions[i].size - 1))) {
+            host_mmio_region_remove(host_mmio_regions[i].start);
+        }
+    }
+    for (i = file_ram_regions_count - 1; i >= 0; i--) {
+        if (ram_ranges_overlap(start, last, file_ram_regions[i].start,
+                               file_ram_regions[i].start + (file_ram_regions[i].size - 1))) {
+            file_ram_region_remove(file_ram_regions[i].start);
+        }
+    }
+}
+
+/* Start logging writes to [start, start + size). All pages start clean. */
+int dirty_log_region_add(ram_addr_t start, ram_addr_t size)
+{
+    DirtyLogRegion *r;
+    ram_addr_t pages;
+
+    if (dirty_log_regions_count == MAX_DIRTY_LOG_REGIONS || size == 0) {
+        return -1;
+    }
+    if ((start | size) & ~TARGET_PAGE_MASK) {
+        return -1;
+    }
+    if (dirty_log_regions_overlap(start, start + (size - 1))) {
+        return -1;
+    }
+    pages = size >> TARGET_PAGE_BITS;
+    r = &dirty_log_regions[dirty_log_regions_count++];
+    r->start = start;
+    r->size = size;
+    r->bitmap = tlib_mallocz(((pages + 63) / 64) * sizeof(uint64_t));
+    tlb_trap_writes_range(cpu, start, start + size);
+    return 0;
+}
+
+void dirty_log_region_remove(ram_addr_t start)
+{
+    DirtyLogRegion *r;
+
+    r = dirty_log_region_find(start);
+    if (r == NULL || r->start != start) {
+        return;
+    }
+    tlib_free(r->bitmap);
+    *r = dirty_log_regions[--dirty_log_regions_count];
+    /* stale write traps are dropped lazily by notdirty_mem_write */
+}
+
+void dirty_log_regions_free(void)
+{
+    while (dirty_log_regions_count != 0) {
+        dirty_log_region_remove(dirty_log_regions[0].start);
+    }
+}
+
+/* Get and clear the pages written since the previous call. Returns the
+   number of dirty pages; bit N of 'bitmap' stands for the N-th page of
+   the region. */
+uint32_t dirty_log_region_get_dirty(ram_addr_t start, uint64_t *bitmap, uint32_t bitmap_words)
+{
+    DirtyLogRegion *r;
+    uint32_t words, i;
+    uint32_t count = 0;
+
+    r = dirty_log_region_find(start);
+    if (r == NULL || r->start != start) {
+        return 0;
+    }
+    words = ((r->size >> TARGET_PAGE_BITS) + 63) / 64;
+    if (words > bitmap_words) {
+        words = bitmap_words;
+    }
+    memset(bitmap, 0, bitmap_words * sizeof(uint64_t));
+    for (i = 0; i < words; i++) {
+        if (r->bitmap[i] != 0) {
+            bitmap[i] = r->bitmap[i];
+            count += __builtin_popcountll(r->bitmap[i]);
+            r->bitmap[i] = 0;
+        }
+    }
+    if (count != 0) {
+        /* rearm the write tracking on the pages we've just reported */
+        tlb_trap_writes_range(cpu, r->start, r->start + r->size);
+    }
+    return count;
+}
+
 void notdirty_mem_writeb(void *opaque, target_phys_addr_t ram_addr, uint32_t val)
 {
     int dirty_flags;
@@ -1433,6 +2600,7 @@ void notdirty_mem_writeb(void *opaque, target_phys_addr_t ram_addr, uint32_t val
         dirty_flags = cpu_physical_memory_get_dirty_flags(ram_addr);
     }
     stb_p(get_ram_ptr(ram_addr), val);
+    dirty_log_mark(ram_addr);
     dirty_flags |= (0xff & ~CODE_DIRTY_FLAG);
     cpu_physical_memory_set_dirty_flags(ram_addr, dirty_flags);
     /* we remove the notdirty callback only if the code has been
@@ -1451,6 +2619,7 @@ void notdirty_mem_writew(void *opaque, target_phys_addr_t ram_addr, uint32_t val
         dirty_flags = cpu_physical_memory_get_dirty_flags(ram_addr);
     }
     stw_p(get_ram_ptr(ram_addr), val);
+    dirty_log_mark(ram_addr);
     dirty_flags |= (0xff & ~CODE_DIRTY_FLAG);
     cpu_physical_memory_set_dirty_flags(ram_addr, dirty_flags);
     /* we remove the notdirty callback only if the code has been
@@ -1469,6 +2638,7 @@ void notdirty_mem_writel(void *opaque, target_phys_addr_t ram_addr, uint32_t val
         dirty_flags = cpu_physical_memory_get_dirty_flags(ram_addr);
     }
     stl_p(get_ram_ptr(ram_addr), val);
+    dirty_log_mark(ram_addr);
     dirty_flags |= (0xff & ~CODE_DIRTY_FLAG);
     cpu_physical_memory_set_dirty_flags(ram_addr, dirty_flags);
     /* we remove the notdirty callback only if the code has been
@@ -1478,13 +2648,38 @@ void notdirty_mem_writel(void *opaque, target_phys_addr_t ram_addr, uint32_t val
     }
 }
 
-/* physical memory access (slow version, mainly for debug) */
-void cpu_physical_memory_rw(target_phys_addr_t addr, uint8_t *buf, int len, int is_write)
+void notdirty_mem_writeq(void *opaque, target_phys_addr_t ram_addr, uint64_t val)
 {
-    int l;
-    uint8_t *ptr;
-    uint32_t val;
+    int dirty_flags;
+    dirty_flags = cpu_physical_memory_get_dirty_flags(ram_addr);
+    if (!(dirty_flags & CODE_DIRTY_FLAG)) {
+        tb_invalidate_phys_page_fast(ram_addr, 8);
+        dirty_flags = cpu_physical_memory_get_dirty_flags(ram_addr);
+    }
+    stq_p(get_ram_ptr(ram_addr), val);
+    dirty_log_mark(ram_addr);
+    dirty_flags |= (0xff & ~CODE_DIRTY_FLAG);
+    cpu_physical_memory_set_dirty_flags(ram_addr, dirty_flags);
+    /* we remove the notdirty callback only if the code has been
+       flushed */
+    if (dirty_flags == 0xff) {
+        tlb_set_dirty(cpu, cpu->mem_io_vaddr);
+    }
+}
+
+/* Map guest physical memory for direct host access. On return '*plen' holds
+   the number of bytes, starting at 'addr', backed by contiguous host memory
+   (never more than requested). Returns NULL if 'addr' is not RAM (or ROM when
+   reading). Writes through the returned pointer must be followed by
+   cpu_physical_memory_unmap so that translated code gets invalidated. */
+void *cpu_physical_memory_map(target_phys_addr_t addr, target_phys_addr_t *plen, int is_write)
+{
+    target_phys_addr_t len = *plen;
+    target_phys_addr_t done = 0;
+    target_phys_addr_t l;
     target_phys_addr_t page;
+    uint8_t *ret = NULL;
+    uint8_t *ptr;
     ram_addr_t pd;
     PhysPageDesc *p;
 
@@ -1503,67 +2698,135 @@ void cpu_physical_memory_rw(target_phys_addr_t addr, uint8_t *buf, int len, int
 
         if (is_write) {
             if ((pd & ~TARGET_PAGE_MASK) != IO_MEM_RAM) {
-                target_phys_addr_t addr1 = addr;
-                if (p) {
-                    addr1 = (addr & ~TARGET_PAGE_MASK) + p->region_offset;
-                }
-                if (l >= 4 && ((addr1 & 3) == 0)) {
-                    /* 32 bit write access */
-                    val = ldl_p(buf);
-                    tlib_write_double_word(addr1, val);
-                    l = 4;
-                } else if (l >= 2 && ((addr1 & 1) == 0)) {
-                    /* 16 bit write access */
-                    val = lduw_p(buf);
-                    tlib_write_word(addr1, val);
-                    l = 2;
-                } else {
-                    /* 8 bit write access */
-                    val = ldub_p(buf);
-                    tlib_write_byte(addr1, val);
-                    l = 1;
-                }
-            } else {
-                uintptr_t addr1;
-                addr1 = (pd & TARGET_PAGE_MASK) + (addr & ~TARGET_PAGE_MASK);
-                /* RAM case */
-                ptr = get_ram_ptr(addr1);
-                memcpy(ptr, buf, l);
-                if (!cpu_physical_memory_is_dirty(addr1)) {
-                    /* invalidate code */
-                    tb_invalidate_phys_page_range(addr1, addr1 + l, 0);
-                    /* set dirty bit */
-                    cpu_physical_memory_set_dirty_flags(
-                        addr1, (0xff & ~CODE_DIRTY_FLAG));
-                }
+                break;
             }
         } else {
             if ((pd & ~TARGET_PAGE_MASK) > IO_MEM_ROM && !(pd & IO_MEM_ROMD)) {
-                target_phys_addr_t addr1 = addr;
-                /* I/O case */
-                if (p) {
-                    addr1 = (addr & ~TARGET_PAGE_MASK) + p->region_offset;
-                }
-                if (l >= 4 && ((addr1 & 3) == 0)) {
-                    /* 32 bit read access */
-                    val = tlib_read_double_word(addr1);
-                    stl_p(buf, val);
-                    l = 4;
-                } else if (l >= 2 && ((addr1 & 1) == 0)) {
-                    /* 16 bit read access */
-                    val = tlib_read_word(addr1);
-                    stw_p(buf, val);
-                    l = 2;
-                } else {
-                    /* 8 bit read access */
-                    val = tlib_read_byte(addr1);
-                    stb_p(buf, val);
-                    l = 1;
-                }
+                break;
+            }
+        }
+
+        ptr = get_ram_ptr((pd & TARGET_PAGE_MASK) + (addr & ~TARGET_PAGE_MASK));
+        if (ptr == NULL || (ret != NULL && ptr != ret + done)) {
+            break;
+        }
+        if (ret == NULL) {
+            ret = ptr;
+        }
+        done += l;
+        len -= l;
+        addr += l;
+    }
+    *plen = done;
+    return ret;
+}
+
+/* Finish a direct access started with cpu_physical_memory_map. After a write
+   this invalidates the translated code and sets the dirty flags of the pages
+   in [addr, addr + len). */
+void cpu_physical_memory_unmap(target_phys_addr_t addr, target_phys_addr_t len, int is_write)
+{
+    target_phys_addr_t l;
+    target_phys_addr_t page;
+    ram_addr_t addr1;
+    PhysPageDesc *p;
+
+    if (!is_write) {
+        return;
+    }
+    while (len > 0) {
+        page = addr & TARGET_PAGE_MASK;
+        l = (page + TARGET_PAGE_SIZE) - addr;
+        if (l > len) {
+            l = len;
+        }
+        p = phys_page_find(page >> TARGET_PAGE_BITS);
+        if (p && (p->phys_offset & ~TARGET_PAGE_MASK) == IO_MEM_RAM) {
+            addr1 = (p->phys_offset & TARGET_PAGE_MASK) + (addr & ~TARGET_PAGE_MASK);
+            dirty_log_mark(addr1);
+            if (!cpu_physical_memory_is_dirty(addr1)) {
+                /* invalidate code */
+                tb_invalidate_phys_page_range(addr1, addr1 + l, 0);
+                /* set dirty bit */
+                cpu_physical_memory_set_dirty_flags(addr1, (0xff & ~CODE_DIRTY_FLAG));
+            }
+        }
+        len -= l;
+        addr += l;
+    }
+}
+
+/* physical memory access (slow version, mainly for debug) */
+void cpu_physical_memory_rw(target_phys_addr_t addr, uint8_t *buf, int len, int is_write)
+{
+    int l;
+    uint8_t *ptr;
+    uint32_t val;
+    target_phys_addr_t plen;
+    target_phys_addr_t addr1;
+    PhysPageDesc *p;
+
+    while (len > 0) {
+        /* RAM case: copy the whole contiguous span at once */
+        plen = len;
+        ptr = cpu_physical_memory_map(addr, &plen, is_write);
+        if (ptr != NULL) {
+            l = plen;
+            if (is_write) {
+                memcpy(ptr, buf, l);
+                cpu_physical_memory_unmap(addr, l, 1);
+            } else {
+                memcpy(buf, ptr, l);
+            }
+            len -= l;
+            buf += l;
+            addr += l;
+            continue;
+        }
+
+        /* I/O case */
+        l = ((addr & TARGET_PAGE_MASK) + TARGET_PAGE_SIZE) - addr;
+        if (l > len) {
+            l = len;
+        }
+        p = phys_page_find(addr >> TARGET_PAGE_BITS);
+        addr1 = addr;
+        if (p) {
+            addr1 = (addr & ~TARGET_PAGE_MASK) + p->region_offset;
+        }
+        if (is_write) {
+            if (l >= 4 && ((addr1 & 3) == 0)) {
+                /* 32 bit write access */
+                val = ldl_p(buf);
+                tlib_write_double_word(addr1, val);
+                l = 4;
+            } else if (l >= 2 && ((addr1 & 1) == 0)) {
+                /* 16 bit write access */
+                val = lduw_p(buf);
+                tlib_write_word(addr1, val);
+                l = 2;
+            } else {
+                /* 8 bit write access */
+                val = ldub_p(buf);
+                tlib_write_byte(addr1, val);
+                l = 1;
+            }
+        } else {
+            if (l >= 4 && ((addr1 & 3) == 0)) {
+                /* 32 bit read access */
+                val = tlib_read_double_word(addr1);
+                stl_p(buf, val);
+                l = 4;
+            } else if (l >= 2 && ((addr1 & 1) == 0)) {
+                /* 16 bit read access */
+                val = tlib_read_word(addr1);
+                stw_p(buf, val);
+                l = 2;
             } else {
-                /* RAM case */
-                ptr = get_ram_ptr(pd & TARGET_PAGE_MASK);
-                memcpy(buf, ptr + (addr & ~TARGET_PAGE_MASK), l);
+                /* 8 bit read access */
+                val = tlib_read_byte(addr1);
+                stb_p(buf, val);
+                l = 1;
             }
         }
         len -= l;
@@ -1572,6 +2835,33 @@ void cpu_physical_memory_rw(target_phys_addr_t addr, uint8_t *buf, int len, int
     }
 }
 
+/* Scatter-gather variant of cpu_physical_memory_rw. Returns the number of
+   bytes transferred. */
+uint64_t cpu_physical_memory_rw_sg(const PhysMemorySgEntry *entries, uint32_t count, int is_write)
+{
+    uint64_t total = 0;
+    uint64_t length;
+    uint64_t chunk;
+    target_phys_addr_t addr;
+    uint8_t *buf;
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        addr = entries[i].address;
+        buf = (uint8_t *)(uintptr_t)entries[i].buffer;
+        length = entries[i].length;
+        while (length > 0) {
+            chunk = length > INT32_MAX ? (INT32_MAX & TARGET_PAGE_MASK) : length;
+            cpu_physical_memory_rw(addr, buf, chunk, is_write);
+            length -= chunk;
+            buf += chunk;
+            addr += chunk;
+            total += chunk;
+        }
+    }
+    return total;
+}
+
 /* used for ROM loading : can write in RAM and ROM */
 void cpu_physical_memory_write_rom(target_phys_addr_t addr, const uint8_t *buf, int len)
 {
@@ -1602,6 +2892,7 @@ void cpu_physical_memory_write_rom(target_phys_addr_t addr, const uint8_t *buf,
             /* ROM/RAM case */
             ptr = get_ram_ptr(addr1);
             memcpy(ptr, buf, l);
+            dirty_log_mark(addr1);
         }
         len -= l;
         buf += l;
@@ -1723,6 +3014,7 @@ void stl_phys_notdirty(target_phys_addr_t addr, uint32_t val)
         uintptr_t addr1 = (pd & TARGET_PAGE_MASK) + (addr & ~TARGET_PAGE_MASK);
         ptr = get_ram_ptr(addr1);
         stl_p(ptr, val);
+        dirty_log_mark(addr1);
     }
 }
 
@@ -1760,6 +3052,7 @@ void stq_phys_notdirty(target_phys_addr_t addr, uint64_t val)
     } else {
         ptr = get_ram_ptr(pd & TARGET_PAGE_MASK) + (addr & ~TARGET_PAGE_MASK);
         stq_p(ptr, val);
+        dirty_log_mark((pd & TARGET_PAGE_MASK) + (addr & ~TARGET_PAGE_MASK));
     }
 }
 
@@ -1793,6 +3086,7 @@ void stl_phys(target_phys_addr_t addr, uint32_t val)
         /* RAM case */
         ptr = get_ram_ptr(addr1);
         stl_p(ptr, val);
+        dirty_log_mark(addr1);
         if (!cpu_physical_memory_is_dirty(addr1)) {
             /* invalidate code */
             tb_invalidate_phys_page_range(addr1, addr1 + 4, 0);
@@ -1839,6 +3133,7 @@ void stw_phys(target_phys_addr_t addr, uint32_t val)
         /* RAM case */
         ptr = get_ram_ptr(addr1);
         stw_p(ptr, val);
+        dirty_log_mark(addr1);
         if (!cpu_physical_memory_is_dirty(addr1)) {
             /* invalidate code */
             tb_invalidate_phys_page_range(addr1, addr1 + 2, 0);
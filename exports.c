@@ -23,6 +23,11 @@
 #include "tcg.h"
 #include "tcg-additional.h"
 #include "exec-all.h"
+#include "checkpoint.h"
+#include "memory_trace.h"
+#include "tb_profile.h"
+#include "perf_map.h"
+#include "tb_dump.h"
 
 static tcg_t stcg;
 
@@ -89,6 +94,21 @@ uint32_t tlib_get_maximum_block_size()
     return maximum_block_size;
 }
 
+uint32_t maximum_block_ops;
+
+// Limits a translation block to 'count' TCG ops, which bounds the size of the
+// intermediate code buffers. Blocks up to OPC_BUF_SIZE ops are always allowed.
+uint32_t tlib_set_maximum_block_ops(uint32_t count)
+{
+    maximum_block_ops = count > OPC_BUF_SIZE ? count : OPC_BUF_SIZE;
+    return maximum_block_ops;
+}
+
+uint32_t tlib_get_maximum_block_ops()
+{
+    return maximum_block_ops;
+}
+
 void tlib_set_cycles_per_instruction(uint32_t count)
 {
     env->cycles_per_instruction = count;
@@ -114,6 +134,7 @@ int32_t tlib_init(char *cpu_name)
         return -1;
     }
     tlib_set_maximum_block_size(10000);
+    tlib_set_maximum_block_ops(16 * OPC_BUF_SIZE);
     env->atomic_memory_state = NULL;
     return 0;
 }
@@ -125,19 +146,21 @@ void tlib_atomic_memory_state_init(int id, uintptr_t atomic_memory_state_ptr)
     register_in_atomic_memory_state(cpu->atomic_memory_state, id);
 }
 
-static void free_phys_dirty()
-{
-    if (dirty_ram.phys_dirty) {
-        tlib_free(dirty_ram.phys_dirty);
-    }
-}
-
 void tlib_dispose()
 {
     tlib_arch_dispose();
     code_gen_free();
     free_all_page_descriptors();
-    free_phys_dirty();
+    ram_blocks_free();
+    dirty_log_regions_free();
+    file_ram_regions_free();
+    host_mmio_regions_free();
+    memory_trace_disable();
+    tb_profile_free();
+    perf_map_close();
+    perf_map_clear_symbols();
+    tb_dump_close();
+    cpu_watchpoint_remove_all(cpu);
     tlib_free(cpu);
     tcg_dispose();
 }
@@ -199,7 +222,12 @@ int32_t tlib_execute(int32_t max_insns)
     // as this is might be accessed after calling `tlib_execute`
     // to read the progress
     cpu->instructions_count_value = local_counter;
-    
+
+    host_mmio_regions_notify();
+    memory_trace_notify();
+    perf_map_flush();
+    tb_dump_flush();
+
     return result;
 }
 
@@ -250,54 +278,123 @@ void tlib_map_range(uint64_t start_addr, uint64_t length)
 {
     ram_addr_t phys_offset = start_addr;
     ram_addr_t size = length;
-    //remember that phys_dirty covers the whole memory range from 0 to the end
-    //of the registered memory. Most offsets are probably unused. When a new
-    //region is registered before any already registered memory, the array
-    //does not need to be expanded.
-    uint8_t *phys_dirty;
-    size_t array_start_addr, array_size, new_size;
-    array_start_addr = start_addr >> TARGET_PAGE_BITS;
-    array_size = size >> TARGET_PAGE_BITS;
-    new_size = array_start_addr + array_size;
-    if (new_size > dirty_ram.current_size) {
-        phys_dirty = tlib_malloc(new_size);
-        memcpy(phys_dirty, dirty_ram.phys_dirty, dirty_ram.current_size);
-        if (dirty_ram.phys_dirty != NULL) {
-            tlib_free(dirty_ram.phys_dirty);
-        }
-        dirty_ram.phys_dirty = phys_dirty;
-        dirty_ram.current_size = new_size;
-    }
-    memset(dirty_ram.phys_dirty + array_start_addr, 0xff, array_size);
+    ram_blocks_reserve(start_addr, length, 0xff);
     cpu_register_physical_memory(start_addr, size, phys_offset | IO_MEM_RAM);
 }
 
-void tlib_unmap_range(uint64_t start, uint64_t end)
+// Maps the host buffer at `host_ptr` as device memory the guest accesses at RAM speed.
+// Writes are tracked per page: with `notify_on_write` set, `tlib_on_host_mmio_page_written`
+// is called once for each page written during a `tlib_execute` call; otherwise the host
+// polls the pages with `tlib_get_host_mmio_dirty_pages`.
+int32_t tlib_map_host_mmio_range(uint64_t start_addr, uint64_t length, uintptr_t host_ptr, uint32_t notify_on_write)
 {
-    uint64_t new_start;
+    if (host_mmio_region_add(start_addr, length, (void *)host_ptr, !!notify_on_write) != 0) {
+        return -1;
+    }
+    // pages start clean: code was never translated from them and they were not written yet
+    ram_blocks_reserve(start_addr, length, 0xff & ~HOST_MMIO_DIRTY_FLAG);
+    cpu_register_physical_memory(start_addr, length, start_addr | IO_MEM_RAM);
+    return 0;
+}
 
-    while (start <= end) {
-        unmap_page(start);
-        new_start = start + TARGET_PAGE_SIZE;
-        if (new_start < start) {
-            return;
-        }
-        start = new_start;
+void tlib_unmap_host_mmio_range(uint64_t start_addr)
+{
+    host_mmio_region_remove(start_addr);
+}
+
+// Maps guest RAM backed by the file at `path_ptr` (a NUL-terminated path), from `file_offset`
+// on, instead of memory provided through `tlib_guest_offset_to_host_ptr`. Pages are read
+// lazily on first access. `flags` are the FILE_RAM_* values: SHARED (1) writes guest stores
+// back to the file, otherwise the mapping is copy-on-write; SEQUENTIAL (2), RANDOM (4) and
+// WILLNEED (8) are passed to the host kernel as access hints. Returns -1 on failure.
+int32_t tlib_map_file_range(uint64_t start_addr, uint64_t length, uintptr_t path_ptr, uint64_t file_offset, uint32_t flags)
+{
+    if (file_ram_region_add(start_addr, length, (const char *)path_ptr, file_offset, flags) != 0) {
+        return -1;
     }
+    ram_blocks_reserve(start_addr, length, 0xff);
+    cpu_register_physical_memory(start_addr, length, start_addr | IO_MEM_RAM);
+    return 0;
+}
+
+void tlib_unmap_file_range(uint64_t start_addr)
+{
+    file_ram_region_remove(start_addr);
+}
+
+// Fills `bitmap_ptr` (an array of `bitmap_words` 64-bit words) with the pages written since
+// the previous call and returns their count. Bit N stands for the N-th page of the region.
+uint32_t tlib_get_host_mmio_dirty_pages(uint64_t start_addr, uintptr_t bitmap_ptr, uint32_t bitmap_words)
+{
+    return host_mmio_region_get_dirty(start_addr, (uint64_t *)bitmap_ptr, bitmap_words);
+}
+
+// Starts recording which pages of [start_addr, start_addr + length) get written, by the CPU
+// or through the memory access exports. Returns -1 if the range overlaps a tracked one.
+int32_t tlib_enable_dirty_page_tracking(uint64_t start_addr, uint64_t length)
+{
+    return dirty_log_region_add(start_addr, length);
+}
+
+void tlib_disable_dirty_page_tracking(uint64_t start_addr)
+{
+    dirty_log_region_remove(start_addr);
+}
+
+// Fills `bitmap_ptr` (an array of `bitmap_words` 64-bit words) with the pages written since
+// the previous call, clears them and returns their count. Bit N stands for the N-th page
+// of the tracked range.
+uint32_t tlib_get_dirty_pages(uint64_t start_addr, uintptr_t bitmap_ptr, uint32_t bitmap_words)
+{
+    return dirty_log_region_get_dirty(start_addr, (uint64_t *)bitmap_ptr, bitmap_words);
+}
+
+// Host MMIO and file ranges overlapping [start, end] are unmapped as a whole.
+void tlib_unmap_range(uint64_t start, uint64_t end)
+{
+    ram_regions_remove_range(start, end);
+    ram_blocks_unregister(start, end);
 }
 
 uint32_t tlib_is_range_mapped(uint64_t start, uint64_t end)
 {
-    PhysPageDesc *pd;
+    if (start >= end) {
+        return 0;
+    }
+    return ram_blocks_intersect(start, end - 1);
+}
 
-    while (start < end) {
-        pd = phys_page_find((target_phys_addr_t)start >> TARGET_PAGE_BITS);
-        if (pd != NULL && pd->phys_offset != IO_MEM_UNASSIGNED) {
-            return 1; // at least one page of this region is mapped
-        }
-        start += TARGET_PAGE_SIZE;
+// Returns a host pointer to guest physical memory at `address` and stores in `*length` how
+// many bytes, up to the requested `*length`, are backed by contiguous host memory.
+// Returns 0 if `address` is not RAM. The pointer stays valid until the memory map changes;
+// after writing through it the host must call `tlib_physical_memory_unmap`.
+uintptr_t tlib_physical_memory_map(uint64_t address, uintptr_t length_ptr, uint32_t is_write)
+{
+    uint64_t *length = (uint64_t *)length_ptr;
+    target_phys_addr_t plen = *length;
+    void *ptr;
+
+    if (plen != *length) {
+        plen = TARGET_PHYS_ADDR_MAX & TARGET_PAGE_MASK;
     }
-    return 0;
+    ptr = cpu_physical_memory_map(address, &plen, is_write);
+    *length = plen;
+    return (uintptr_t)ptr;
+}
+
+// Invalidates translated code and marks pages dirty after the host wrote to a range
+// obtained from `tlib_physical_memory_map`.
+void tlib_physical_memory_unmap(uint64_t address, uint64_t length, uint32_t is_write)
+{
+    cpu_physical_memory_unmap(address, length, is_write);
+}
+
+// `entries_ptr` points to `count` { uint64 address, uint64 buffer, uint64 length } entries.
+// RAM spans are copied directly, I/O goes through the regular access callbacks.
+// Returns the number of bytes transferred.
+uint64_t tlib_physical_memory_rw_sg(uintptr_t entries_ptr, uint32_t count, uint32_t is_write)
+{
+    return cpu_physical_memory_rw_sg((PhysMemorySgEntry *)entries_ptr, count, is_write);
 }
 
 void tlib_invalidate_translation_blocks(uintptr_t start, uintptr_t end)
@@ -314,6 +411,55 @@ uint64_t tlib_translate_to_physical_address(uint64_t address, uint32_t access_ty
     return ret;
 }
 
+// Translates 'count' virtual addresses (uint64 each) for the given access type, writing the
+// physical addresses, or -1 for unmapped ones, to 'results_ptr'. Unlike
+// `tlib_translate_to_physical_address` it never refills the TLB, TLB misses walk the guest
+// page tables as a data read, whatever the access type, and the results are cached until the
+// next TLB flush. Returns the number of addresses translated.
+uint32_t tlib_translate_to_physical_addresses(uintptr_t addresses_ptr, uintptr_t results_ptr, uint32_t count,
+                                              uint32_t access_type)
+{
+    uint64_t *addresses = (uint64_t *)addresses_ptr;
+    uint64_t *results = (uint64_t *)results_ptr;
+    uint32_t translated = 0;
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        results[i] = virt_to_phys_cached(cpu, addresses[i], access_type);
+        if (results[i] != (uint64_t)-1) {
+            translated++;
+        }
+    }
+    return translated;
+}
+
+// Same as above for each page of [address, address + length): the first entry holds the
+// translation of 'address', the following ones of the starts of the next pages. At most
+// 'max_entries' entries are written. Returns the number of pages translated.
+uint32_t tlib_translate_range_to_physical(uint64_t address, uint64_t length, uintptr_t results_ptr, uint32_t max_entries,
+                                          uint32_t access_type)
+{
+    uint64_t *results = (uint64_t *)results_ptr;
+    uint64_t last = address + length - 1;
+    uint32_t translated = 0;
+    uint32_t i;
+
+    if (length == 0) {
+        return 0;
+    }
+    for (i = 0; i < max_entries; i++) {
+        results[i] = virt_to_phys_cached(cpu, address, access_type);
+        if (results[i] != (uint64_t)-1) {
+            translated++;
+        }
+        address = (address & TARGET_PAGE_MASK) + TARGET_PAGE_SIZE;
+        if (address - 1 >= last) {
+            break;
+        }
+    }
+    return translated;
+}
+
 void tlib_set_irq(int32_t interrupt, int32_t state)
 {
     if (state) {
@@ -338,13 +484,52 @@ void tlib_remove_breakpoint(uint64_t address)
     cpu_breakpoint_remove(cpu, address, BP_GDB);
 }
 
+// Stops the execution before a guest access overlapping [address, address + length);
+// `flags` selects reads (1) and/or writes (2). `tlib_execute` then returns EXCP_WATCHPOINT
+// with the CPU state at the accessing instruction, which is completed when execution resumes.
+int32_t tlib_add_watchpoint(uint64_t address, uint64_t length, uint32_t flags)
+{
+    return cpu_watchpoint_insert(cpu, address, length, flags) == 0 ? 0 : -1;
+}
+
+int32_t tlib_remove_watchpoint(uint64_t address, uint64_t length, uint32_t flags)
+{
+    return cpu_watchpoint_remove(cpu, address, length, flags) == 0 ? 0 : -1;
+}
+
+void tlib_remove_all_watchpoints()
+{
+    cpu_watchpoint_remove_all(cpu);
+}
+
+// Address and type (1 - read, 2 - write) of the access that stopped the execution with EXCP_WATCHPOINT.
+uint64_t tlib_get_watchpoint_hit_address()
+{
+    return cpu->watchpoint_hit_address;
+}
+
+uint32_t tlib_get_watchpoint_hit_flags()
+{
+    return cpu->watchpoint_hit_flags;
+}
+
 uintptr_t translation_cache_size;
+uint32_t translation_cache_options;
 
 void tlib_set_translation_cache_size(uintptr_t size)
 {
     translation_cache_size = size;
 }
 
+// Must be called before `tlib_init`. TRANSLATION_CACHE_HUGE_PAGES (1) backs the cache with huge
+// pages, falling back to transparent huge pages when none are reserved on the host.
+// TRANSLATION_CACHE_SPLIT_WX (2) maps it twice, writable and executable at different addresses,
+// for hosts that forbid writable and executable mappings (x86 Linux hosts only).
+void tlib_set_translation_cache_options(uint32_t options)
+{
+    translation_cache_options = options;
+}
+
 void tlib_invalidate_translation_cache()
 {
     if (cpu) {
@@ -385,6 +570,27 @@ int32_t tlib_get_state_size()
     return (ssize_t)(&((CPUState *)0)->current_tb);
 }
 
+uint32_t tlib_get_checkpoint_max_size()
+{
+    return checkpoint_max_size();
+}
+
+// Saves the serializable CPU state to `buffer` and returns the number of bytes used or -1.
+// If `base` points to a full checkpoint saved earlier, only the difference is stored and
+// the same `base` must be passed to `tlib_restore_checkpoint`.
+int32_t tlib_save_checkpoint(uintptr_t buffer, uint32_t buffer_size, uintptr_t base)
+{
+    return checkpoint_save((uint8_t *)buffer, buffer_size, (const uint8_t *)base);
+}
+
+// `flags` is a combination of CHECKPOINT_KEEP_TRANSLATIONS (1) and CHECKPOINT_KEEP_TLB (2).
+// Translations can be kept if guest code was not modified behind tlib's back since the
+// checkpoint was taken, the TLB only if the MMU configuration did not change either.
+int32_t tlib_restore_checkpoint(uintptr_t buffer, uintptr_t base, uint32_t flags)
+{
+    return checkpoint_restore((const uint8_t *)buffer, (const uint8_t *)base, flags);
+}
+
 void tlib_set_chaining_enabled(uint32_t val)
 {
     cpu->chaining_disabled = !val;
@@ -493,6 +699,119 @@ void tlib_on_memory_access_event_enabled(int32_t value)
     cpu->tlib_is_on_memory_access_enabled = !!value;
 }
 
+// Starts recording guest data accesses in a ring buffer of `capacity` entries (a power of two).
+// The host is notified with `tlib_on_memory_trace_ready` when the buffer fills up and at the
+// end of `tlib_execute`, and collects the entries with `tlib_read_memory_trace`.
+int32_t tlib_enable_memory_trace(uint32_t capacity)
+{
+    return memory_trace_enable(capacity);
+}
+
+void tlib_disable_memory_trace()
+{
+    memory_trace_disable();
+}
+
+// Limits the trace to accesses touching the given physical range; can be called several times.
+int32_t tlib_add_memory_trace_filter(uint64_t start_addr, uint64_t length)
+{
+    return memory_trace_add_filter(start_addr, length);
+}
+
+void tlib_clear_memory_trace_filters()
+{
+    memory_trace_clear_filters();
+}
+
+// Moves up to `max_entries` of the oldest trace entries to `buffer` and returns their count.
+uint32_t tlib_read_memory_trace(uintptr_t buffer, uint32_t max_entries)
+{
+    return memory_trace_read((MemoryTraceEntry *)buffer, max_entries);
+}
+
+// Returns the number of accesses lost because the buffer was full.
+uint64_t tlib_get_memory_trace_dropped()
+{
+    return memory_trace.dropped;
+}
+
+// Fills 'buffer' with up to 'max_entries' SmcPageStatistics entries, one per page that had
+// translated code invalidated or written. Returns the number of entries filled.
+uint32_t tlib_get_smc_statistics(uintptr_t buffer, uint32_t max_entries)
+{
+    return smc_get_statistics((SmcPageStatistics *)buffer, max_entries);
+}
+
+// Clears the statistics; pages translated one instruction per block go back to regular blocks.
+void tlib_reset_smc_statistics()
+{
+    smc_reset_statistics();
+}
+
+// Copies the performance counters (CpuStatistics in cpu-defs.h) to 'buffer', at most 'size' bytes.
+// Returns the number of bytes copied; counters added later are appended, so older hosts still work.
+uint32_t tlib_get_statistics(uintptr_t buffer, uint32_t size)
+{
+    if (size > sizeof(CpuStatistics)) {
+        size = sizeof(CpuStatistics);
+    }
+    memcpy((void *)buffer, &cpu->statistics, size);
+    return size;
+}
+
+void tlib_reset_statistics()
+{
+    memset(&cpu->statistics, 0, sizeof(CpuStatistics));
+}
+
+// Profiling counts, per guest block, executions, translations, translation time and invalidations.
+// Changing the setting flushes the translation cache.
+void tlib_set_tb_profiling(uint32_t enabled)
+{
+    tb_profile_set_enabled(!!enabled);
+}
+
+// Writes the top 'max_entries' blocks (all if 0) as text, sorted by 'sort_key' (TB_PROFILE_SORT_*).
+// Returns the number of blocks written or -1 if the file cannot be created.
+int32_t tlib_dump_tb_profile(uintptr_t path_ptr, uint32_t max_entries, uint32_t sort_key)
+{
+    return tb_profile_dump((const char *)path_ptr, max_entries, sort_key);
+}
+
+void tlib_reset_tb_profile()
+{
+    tb_profile_reset();
+}
+
+// Describes the translated code to host profilers: PERF_MAP_SYMBOLS (1) writes /tmp/perf-<pid>.map,
+// PERF_MAP_JITDUMP (2) writes jit-<pid>.dump with the code of each block to 'directory_ptr' (/tmp if 0),
+// to be merged with `perf inject --jit`. PERF_MAP_DISABLED (0) closes the file. Linux hosts only.
+int32_t tlib_enable_perf_map(uint32_t mode, uintptr_t directory_ptr)
+{
+    return perf_map_enable(mode, (const char *)directory_ptr);
+}
+
+// Names the guest code in [start, start + size) in the records of blocks translated afterwards.
+// Returns -1 if the range overlaps a symbol added before.
+int32_t tlib_perf_map_add_symbol(uint64_t start, uint64_t size, uintptr_t name_ptr)
+{
+    return perf_map_add_symbol(start, size, (const char *)name_ptr);
+}
+
+void tlib_perf_map_clear_symbols()
+{
+    perf_map_clear_symbols();
+}
+
+// Writes the blocks translated from guest pc in ['start', 'end') to the file at 'path_ptr': the 'parts' are
+// TB_DUMP_IR (1) for the ops as generated, TB_DUMP_IR_OPT (2) after the optimizer, TB_DUMP_LIVENESS (4)
+// with the liveness annotations and TB_DUMP_HOST_CODE (8) for the host code bytes. 0 closes the file.
+// Changing the setting flushes the translation cache. Returns -1 if the file cannot be created.
+int32_t tlib_set_tb_dump(uint32_t parts, uint64_t start, uint64_t end, uintptr_t path_ptr)
+{
+    return tb_dump_enable(parts, start, end, (const char *)path_ptr);
+}
+
 void tlib_clean_wfi_proc_state(void)
 {
     // Invalidates "Wait for interrupt" state, and makes the core ready to resume execution
@@ -5,6 +5,8 @@
 
 uint32_t tlib_set_maximum_block_size(uint32_t size);
 uint32_t tlib_get_maximum_block_size(void);
+uint32_t tlib_set_maximum_block_ops(uint32_t count);
+uint32_t tlib_get_maximum_block_ops(void);
 
 void tlib_set_cycles_per_instruction(uint32_t size);
 uint32_t tlib_get_cycles_per_instruction(void);
@@ -31,26 +33,75 @@ void tlib_map_range(uint64_t start_addr, uint64_t length);
 void tlib_unmap_range(uint64_t start, uint64_t end);
 uint32_t tlib_is_range_mapped(uint64_t start, uint64_t end);
 
+int32_t tlib_map_host_mmio_range(uint64_t start_addr, uint64_t length, uintptr_t host_ptr, uint32_t notify_on_write);
+void tlib_unmap_host_mmio_range(uint64_t start_addr);
+int32_t tlib_map_file_range(uint64_t start_addr, uint64_t length, uintptr_t path_ptr, uint64_t file_offset, uint32_t flags);
+void tlib_unmap_file_range(uint64_t start_addr);
+uint32_t tlib_get_host_mmio_dirty_pages(uint64_t start_addr, uintptr_t bitmap_ptr, uint32_t bitmap_words);
+
+int32_t tlib_enable_dirty_page_tracking(uint64_t start_addr, uint64_t length);
+void tlib_disable_dirty_page_tracking(uint64_t start_addr);
+uint32_t tlib_get_dirty_pages(uint64_t start_addr, uintptr_t bitmap_ptr, uint32_t bitmap_words);
+
+int32_t tlib_enable_memory_trace(uint32_t capacity);
+void tlib_disable_memory_trace(void);
+int32_t tlib_add_memory_trace_filter(uint64_t start_addr, uint64_t length);
+void tlib_clear_memory_trace_filters(void);
+uint32_t tlib_read_memory_trace(uintptr_t buffer, uint32_t max_entries);
+uint64_t tlib_get_memory_trace_dropped(void);
+
+uintptr_t tlib_physical_memory_map(uint64_t address, uintptr_t length_ptr, uint32_t is_write);
+void tlib_physical_memory_unmap(uint64_t address, uint64_t length, uint32_t is_write);
+uint64_t tlib_physical_memory_rw_sg(uintptr_t entries_ptr, uint32_t count, uint32_t is_write);
+
 void tlib_invalidate_translation_blocks(uintptr_t start, uintptr_t end);
+uint32_t tlib_get_smc_statistics(uintptr_t buffer, uint32_t max_entries);
+void tlib_reset_smc_statistics(void);
+uint32_t tlib_get_statistics(uintptr_t buffer, uint32_t size);
+void tlib_reset_statistics(void);
+
+void tlib_set_tb_profiling(uint32_t enabled);
+int32_t tlib_dump_tb_profile(uintptr_t path_ptr, uint32_t max_entries, uint32_t sort_key);
+void tlib_reset_tb_profile(void);
+
+int32_t tlib_enable_perf_map(uint32_t mode, uintptr_t directory_ptr);
+int32_t tlib_perf_map_add_symbol(uint64_t start, uint64_t size, uintptr_t name_ptr);
+void tlib_perf_map_clear_symbols(void);
+
+int32_t tlib_set_tb_dump(uint32_t parts, uint64_t start, uint64_t end, uintptr_t path_ptr);
 
 uint64_t tlib_translate_to_physical_address(uint64_t address, uint32_t access_type, uint32_t nofault);
+uint32_t tlib_translate_to_physical_addresses(uintptr_t addresses_ptr, uintptr_t results_ptr, uint32_t count,
+                                              uint32_t access_type);
+uint32_t tlib_translate_range_to_physical(uint64_t address, uint64_t length, uintptr_t results_ptr, uint32_t max_entries,
+                                          uint32_t access_type);
 
 void tlib_set_irq(int32_t interrupt, int32_t state);
 int32_t tlib_is_irq_set(void);
 
 void tlib_add_breakpoint(uint64_t address);
 void tlib_remove_breakpoint(uint64_t address);
+int32_t tlib_add_watchpoint(uint64_t address, uint64_t length, uint32_t flags);
+int32_t tlib_remove_watchpoint(uint64_t address, uint64_t length, uint32_t flags);
+void tlib_remove_all_watchpoints(void);
+uint64_t tlib_get_watchpoint_hit_address(void);
+uint32_t tlib_get_watchpoint_hit_flags(void);
 void tlib_set_block_begin_hook_present(uint32_t val);
 
 uint64_t tlib_get_total_executed_instructions(void);
 
 void tlib_set_translation_cache_size(uintptr_t size);
+void tlib_set_translation_cache_options(uint32_t options);
 void tlib_invalidate_translation_cache(void);
 
 int tlib_restore_context(void);
 void *tlib_export_state(void);
 int32_t tlib_get_state_size(void);
 
+uint32_t tlib_get_checkpoint_max_size(void);
+int32_t tlib_save_checkpoint(uintptr_t buffer, uint32_t buffer_size, uintptr_t base);
+int32_t tlib_restore_checkpoint(uintptr_t buffer, uintptr_t base, uint32_t flags);
+
 void tlib_set_chaining_enabled(uint32_t val);
 uint32_t tlib_get_chaining_enabled(void);
 
@@ -3,12 +3,16 @@
 #include "callbacks.h"
 #include "debug.h"
 #include "atomic.h"
+#include "tb_profile.h"
 
 // verify if there are instructions left to execute, update instructions count
 // and trim the block and exit to the main loop if necessary
 void HELPER(prepare_block_for_execution)(void *tb)
 {
     cpu->current_tb = (TranslationBlock *)tb;
+    if (unlikely(cpu->current_tb->profile != NULL)) {
+        cpu->current_tb->profile->executions++;
+    }
 
     uint64_t instructions_left = cpu->instructions_count_threshold - cpu->instructions_count_value;
     uint64_t current_block_size = cpu->current_tb->icount;
@@ -84,6 +84,8 @@ void tlib_on_interrupt_begin(uint64_t exception_index);
 void tlib_on_interrupt_end(uint64_t exception_index);
 void tlib_on_memory_access(uint32_t operation, uint64_t addr);
 void tlib_on_memory_access_event_enabled(int32_t value);
+void tlib_on_host_mmio_page_written(uint64_t address);
+void tlib_on_memory_trace_ready(uint32_t count);
 
 uint32_t tlib_is_in_debug_mode(void);
 
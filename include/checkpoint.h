@@ -0,0 +1,60 @@
+/*
+ *  CPU state checkpoints.
+ *
+ *  Copyright (c) Antmicro
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#if !defined (__CHECKPOINT_H__)
+#define __CHECKPOINT_H__
+
+#include <stdint.h>
+
+#define CHECKPOINT_MAGIC   0x50434c54 /* "TLCP" */
+#define CHECKPOINT_VERSION 1
+
+/* header flags */
+#define CHECKPOINT_DELTA   (1 << 0)
+
+/* restore flags */
+/* keep translated code; the host guarantees that guest code did not
+   change since the checkpoint or that it was written through tlib */
+#define CHECKPOINT_KEEP_TRANSLATIONS (1 << 0)
+/* keep the TLB; only valid if the MMU configuration is the same */
+#define CHECKPOINT_KEEP_TLB          (1 << 1)
+
+typedef struct CheckpointHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t state_size;
+    /* bytes following the header */
+    uint32_t payload_size;
+    /* full only: checksum of the state, identifies the checkpoint as a base */
+    uint32_t checksum;
+    /* delta only: checksum of the base checkpoint */
+    uint32_t base_checksum;
+} CheckpointHeader;
+
+/* a delta payload is a sequence of runs, each followed by 'length' bytes */
+typedef struct CheckpointRun {
+    uint32_t offset;
+    uint32_t length;
+} CheckpointRun;
+
+uint32_t checkpoint_max_size(void);
+int32_t checkpoint_save(uint8_t *buffer, uint32_t buffer_size, const uint8_t *base);
+int32_t checkpoint_restore(const uint8_t *buffer, const uint8_t *base, uint32_t flags);
+
+#endif // __CHECKPOINT_H__
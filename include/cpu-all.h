@@ -588,7 +588,10 @@ static inline void cpu_interrupt(CPUState *s, int mask)
 
 void cpu_reset_interrupt(CPUState *env, int mask);
 
-/* Breakpoint flags */
+/* Breakpoint/watchpoint flags */
+#define BP_MEM_READ   0x01
+#define BP_MEM_WRITE  0x02
+#define BP_MEM_ACCESS (BP_MEM_READ | BP_MEM_WRITE)
 #define BP_GDB 0x10
 #define BP_CPU 0x20
 
@@ -597,6 +600,11 @@ int cpu_breakpoint_remove(CPUState *env, target_ulong pc, int flags);
 void cpu_breakpoint_remove_by_ref(CPUState *env, CPUBreakpoint *breakpoint);
 void cpu_breakpoint_remove_all(CPUState *env, int mask);
 
+int cpu_watchpoint_insert(CPUState *env, target_ulong addr, target_ulong len, int flags);
+int cpu_watchpoint_remove(CPUState *env, target_ulong addr, target_ulong len, int flags);
+void cpu_watchpoint_remove_all(CPUState *env);
+void cpu_check_watchpoint(CPUState *env, target_ulong addr, int len, int flags, uintptr_t retaddr);
+
 int cpu_init(const char *cpu_model);
 void cpu_reset(CPUState *s);
 int cpu_exec(CPUState *env);
@@ -610,12 +618,40 @@ target_phys_addr_t cpu_get_phys_page_debug(CPUState *env, target_ulong addr);
 
 extern uintptr_t translation_cache_size;
 
-typedef struct dirty_ram_t {
+/* translation cache options, set before the initialization */
+#define TRANSLATION_CACHE_HUGE_PAGES (1 << 0) /* back the buffer with huge pages */
+#define TRANSLATION_CACHE_SPLIT_WX   (1 << 1) /* separate writable and executable views */
+
+extern uint32_t translation_cache_options;
+
+/* a contiguous range of registered RAM with one dirty byte per page */
+typedef struct ram_block_t {
+    ram_addr_t start;
+    ram_addr_t size;
     uint8_t *phys_dirty;
-    size_t current_size;
+} ram_block_t;
+
+/* Dirty bytes are kept per registered block instead of in one array
+   indexed from address zero, so RAM mapped high in a 64-bit physical
+   address space costs only as much as its size. */
+typedef struct dirty_ram_t {
+    /* sorted by address; blocks never overlap nor touch */
+    ram_block_t *blocks;
+    int count;
+    int capacity;
+    /* copy of the block found by the last lookup */
+    ram_block_t last;
+    /* returned for pages outside registered RAM */
+    uint8_t unmapped;
 } dirty_ram_t;
 extern dirty_ram_t dirty_ram;
 
+void ram_blocks_reserve(ram_addr_t start, ram_addr_t size, uint8_t dirty_flags);
+void ram_blocks_unregister(ram_addr_t start, ram_addr_t last);
+bool ram_blocks_intersect(ram_addr_t start, ram_addr_t last);
+void ram_blocks_free(void);
+uint8_t *cpu_physical_memory_dirty_lookup(ram_addr_t addr);
+
 /* physical memory access */
 
 /* MMIO pages are identified by a combination of an IO device index and
@@ -635,47 +671,92 @@ extern dirty_ram_t dirty_ram;
 #define TLB_NOTDIRTY      (1 << 4)
 /* Set if TLB entry is an IO callback.  */
 #define TLB_MMIO          (1 << 5)
+/* Set on pages whose accesses must be seen by the softmmu helpers (memory
+   trace, watchpoints); it only makes the inline TLB check fail, the
+   helpers ignore it.  */
+#define TLB_FORCE_SLOW    (1 << 6)
 
+/* Cleared on pages of host-backed MMIO regions until the guest writes them */
+#define HOST_MMIO_DIRTY_FLAG 0x01
 #define CODE_DIRTY_FLAG   0x02
 
+static inline uint8_t *cpu_physical_memory_dirty_byte(ram_addr_t addr)
+{
+    if (addr - dirty_ram.last.start < dirty_ram.last.size) {
+        return dirty_ram.last.phys_dirty + ((addr - dirty_ram.last.start) >> TARGET_PAGE_BITS);
+    }
+    return cpu_physical_memory_dirty_lookup(addr);
+}
+
 /* read dirty bit (return 0 or 1) */
 static inline int cpu_physical_memory_is_dirty(ram_addr_t addr)
 {
-    return dirty_ram.phys_dirty[addr >> TARGET_PAGE_BITS] == 0xff;
+    return *cpu_physical_memory_dirty_byte(addr) == 0xff;
 }
 
 static inline int cpu_physical_memory_get_dirty_flags(ram_addr_t addr)
 {
-    return dirty_ram.phys_dirty[addr >> TARGET_PAGE_BITS];
+    return *cpu_physical_memory_dirty_byte(addr);
 }
 
 static inline int cpu_physical_memory_get_dirty(ram_addr_t addr, int dirty_flags)
 {
-    return dirty_ram.phys_dirty[addr >> TARGET_PAGE_BITS] & dirty_flags;
+    return *cpu_physical_memory_dirty_byte(addr) & dirty_flags;
 }
 
 static inline void cpu_physical_memory_set_dirty(ram_addr_t addr)
 {
-    dirty_ram.phys_dirty[addr >> TARGET_PAGE_BITS] = 0xff;
+    *cpu_physical_memory_dirty_byte(addr) = 0xff;
 }
 
 static inline int cpu_physical_memory_set_dirty_flags(ram_addr_t addr, int dirty_flags)
 {
-    return dirty_ram.phys_dirty[addr >> TARGET_PAGE_BITS] |= dirty_flags;
+    return *cpu_physical_memory_dirty_byte(addr) |= dirty_flags;
 }
 
 static inline void cpu_physical_memory_mask_dirty_range(ram_addr_t start, int length, int dirty_flags)
 {
     int i, mask, len;
-    uint8_t *p;
 
     len = length >> TARGET_PAGE_BITS;
     mask = ~dirty_flags;
-    p = dirty_ram.phys_dirty + (start >> TARGET_PAGE_BITS);
     for (i = 0; i < len; i++) {
-        p[i] &= mask;
+        *cpu_physical_memory_dirty_byte(start + ((ram_addr_t)i << TARGET_PAGE_BITS)) &= mask;
     }
 }
 
 void cpu_physical_memory_reset_dirty(ram_addr_t start, ram_addr_t end, int dirty_flags);
+
+/* host-backed MMIO: device memory accessed by the guest like RAM */
+#define MAX_HOST_MMIO_REGIONS 32
+
+int host_mmio_region_add(target_phys_addr_t start, ram_addr_t size, void *host_ptr, bool notify);
+void host_mmio_region_remove(target_phys_addr_t start);
+uint32_t host_mmio_region_get_dirty(target_phys_addr_t start, uint64_t *bitmap, uint32_t bitmap_words);
+void host_mmio_regions_notify(void);
+void host_mmio_regions_free(void);
+
+/* guest RAM backed by a memory-mapped file */
+#define MAX_FILE_RAM_REGIONS 32
+
+/* file_ram_region_add flags */
+#define FILE_RAM_SHARED     (1 << 0) /* write guest stores back to the file */
+#define FILE_RAM_SEQUENTIAL (1 << 1) /* madvise hints */
+#define FILE_RAM_RANDOM     (1 << 2)
+#define FILE_RAM_WILLNEED   (1 << 3)
+
+int file_ram_region_add(target_phys_addr_t start, ram_addr_t size, const char *path, uint64_t file_offset, uint32_t flags);
+void file_ram_region_remove(target_phys_addr_t start);
+void file_ram_regions_free(void);
+
+/* drops the host MMIO and file RAM regions overlapping [start, last] */
+void ram_regions_remove_range(ram_addr_t start, ram_addr_t last);
+
+/* dirty page log collected by the host, e.g. for incremental snapshots */
+#define MAX_DIRTY_LOG_REGIONS 32
+
+int dirty_log_region_add(ram_addr_t start, ram_addr_t size);
+void dirty_log_region_remove(ram_addr_t start);
+void dirty_log_regions_free(void);
+uint32_t dirty_log_region_get_dirty(ram_addr_t start, uint64_t *bitmap, uint32_t bitmap_words);
 #endif /* CPU_ALL_H */
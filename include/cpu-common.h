@@ -44,6 +44,18 @@ void *get_ram_ptr(ram_addr_t addr);
 ram_addr_t ram_addr_from_host(void *ptr);
 
 void cpu_physical_memory_rw(target_phys_addr_t addr, uint8_t *buf, int len, int is_write);
+void *cpu_physical_memory_map(target_phys_addr_t addr, target_phys_addr_t *plen, int is_write);
+void cpu_physical_memory_unmap(target_phys_addr_t addr, target_phys_addr_t len, int is_write);
+
+/* Entry of a scatter-gather list passed by the host; the layout is part of the
+   external interface. */
+typedef struct PhysMemorySgEntry {
+    uint64_t address;
+    uint64_t buffer;
+    uint64_t length;
+} PhysMemorySgEntry;
+
+uint64_t cpu_physical_memory_rw_sg(const PhysMemorySgEntry *entries, uint32_t count, int is_write);
 static inline void cpu_physical_memory_read(target_phys_addr_t addr, void *buf, int len)
 {
     cpu_physical_memory_rw(addr, buf, len, 0);
@@ -96,6 +108,7 @@ typedef struct PhysPageDesc {
 } PhysPageDesc;
 
 target_ulong virt_to_phys(target_ulong virtual, uint32_t access_type, uint32_t nofault);
+uint64_t virt_to_phys_cached(CPUState *env, target_ulong virtual, uint32_t access_type);
 
 void tlib_arch_dispose(void);
 void translate_init(void);
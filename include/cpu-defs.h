@@ -146,6 +146,64 @@ typedef struct CPUBreakpoint {
     QTAILQ_ENTRY(CPUBreakpoint) entry;
 } CPUBreakpoint;
 
+typedef struct CPUWatchpoint {
+    target_ulong vaddr;
+    target_ulong len;
+    int flags; /* BP_* */
+    QTAILQ_ENTRY(CPUWatchpoint) entry;
+} CPUWatchpoint;
+
+#define PHYS_TRANSLATION_CACHE_SIZE 64
+
+/* host-requested translation done without going through the TLB */
+typedef struct PhysTranslationCacheEntry {
+    target_ulong vaddr;
+    uint64_t paddr;
+    /* the entry is valid if equal to phys_translation_cache_generation */
+    uint32_t generation;
+    uint16_t mmu_idx;
+    uint16_t access_type;
+} PhysTranslationCacheEntry;
+
+/* Performance counters, read by the host with tlib_get_statistics; the
+   layout is part of the interface, new counters go at the end. */
+typedef struct CpuStatistics {
+    /* blocks found in tb_jmp_cache */
+    uint64_t tb_lookups_fast;
+    /* blocks found in the physical hash table after a tb_jmp_cache miss */
+    uint64_t tb_lookups_slow;
+    /* blocks translated */
+    uint64_t tb_translations;
+    /* time spent translating, in nanoseconds */
+    uint64_t translation_time_ns;
+    /* bytes of host code generated */
+    uint64_t translated_code_bytes;
+    /* blocks entered from the main loop rather than through a chained jump */
+    uint64_t tb_main_loop_entries;
+    /* direct jumps patched between blocks */
+    uint64_t tb_chain_patches;
+    uint64_t tb_flushes;
+    uint64_t tb_invalidations;
+    /* TLB entries filled by the targets' tlb_fill */
+    uint64_t tlb_fills;
+    uint64_t tlb_flushes;
+    uint64_t tlb_page_flushes;
+    /* data accesses made through the softmmu helpers rather than the
+       inline TLB path of the generated code */
+    uint64_t memory_helper_calls;
+    /* accesses forwarded to the host through tlib_read_* and tlib_write_* */
+    uint64_t mmio_reads;
+    uint64_t mmio_writes;
+    /* part of translated_code_bytes placed after the block bodies, the
+       TLB miss paths of the memory accesses */
+    uint64_t translated_slow_path_bytes;
+    /* stores of temps and globals to memory emitted by the register
+       allocator, spills and write-backs alike */
+    uint64_t translated_reg_spills;
+    /* loads of temps and globals into registers */
+    uint64_t translated_reg_reloads;
+} CpuStatistics;
+
 #define CPU_TEMP_BUF_NLONGS 128
 #define CPU_COMMON                                                            \
     /* --------------------------------------- */                             \
@@ -205,6 +263,23 @@ typedef struct CPUBreakpoint {
     long temp_buf[CPU_TEMP_BUF_NLONGS];                                       \
     /* when set any exception will force `cpu_exec` to finish immediately */  \
     int32_t return_on_exception;                                              \
+    QTAILQ_HEAD(watchpoints_head, CPUWatchpoint) watchpoints;                 \
+    /* set when a watchpoint stopped the execution; the instruction */        \
+    /* that hit it is stepped over when the execution resumes */              \
+    int watchpoint_hit;                                                       \
+    target_ulong watchpoint_hit_address;                                      \
+    int watchpoint_hit_flags;                                                 \
+    /* set while that instruction is stepped over */                          \
+    int watchpoint_stepping;                                                  \
+    /* one-instruction block used for that step, cleared if the block is */   \
+    /* flushed or invalidated before the step ends */                         \
+    struct TranslationBlock *watchpoint_step_tb;                              \
+    /* side cache of tlib_translate_to_physical_addresses, dropped */         \
+    /* together with the TLB by bumping the generation */                     \
+    PhysTranslationCacheEntry                                                 \
+        phys_translation_cache[PHYS_TRANSLATION_CACHE_SIZE];                  \
+    uint32_t phys_translation_cache_generation;                               \
+    CpuStatistics statistics;                                                 \
                                                                               \
 
 #endif
@@ -7,6 +7,10 @@
    (i32, i64 and ptr).  Additional aliases are provided for convenience and
    to match the types used by the C helper implementation.
 
+   The flags of DEF_HELPER_FLAGS_N tell TCG which of the helper's side
+   effects it can ignore (see TCG_CALL_NO_* in tcg.h). Helpers that may
+   raise an exception must not be declared more than TCG_CALL_NO_WG.
+
    The target helper.h should be included in all files that use/define
    helper functions.  THis will ensure that function prototypes are
    consistent.  In addition it should be included an extra two times for
@@ -26,6 +26,7 @@
 #include <limits.h>
 #include "compiler.h"
 #include "cpu.h"
+#include "tcg.h"
 
 extern CPUState *env;
 
@@ -56,6 +57,7 @@ void restore_state_to_opc(CPUState *env, struct TranslationBlock *tb, int pc_pos
 void cpu_gen_code(CPUState *env, struct TranslationBlock *tb, int *gen_code_size_ptr);
 int cpu_restore_state(CPUState *env, struct TranslationBlock *tb, uintptr_t searched_pc);
 int cpu_restore_state_and_restore_instructions_count(CPUState *env, struct TranslationBlock *tb, uintptr_t searched_pc);
+target_ulong cpu_get_instruction_pc(CPUState *env, struct TranslationBlock *tb, uintptr_t searched_pc);
 TranslationBlock *tb_gen_code(CPUState *env, target_ulong pc, target_ulong cs_base, int flags, uint16_t cflags);
 void cpu_exec_init(CPUState *env);
 void cpu_exec_init_all();
@@ -79,6 +81,8 @@ void tlb_set_page(CPUState *env, target_ulong vaddr, target_phys_addr_t paddr, i
 #define CODE_GEN_AVG_BLOCK_SIZE  128
 
 extern uint32_t maximum_block_size;
+/* in TCG ops, see tlib_set_maximum_block_ops */
+extern uint32_t maximum_block_ops;
 
 struct TranslationBlock {
     target_ulong pc;      /* simulated PC corresponding to this block (EIP + CS base) */
@@ -100,8 +104,8 @@ struct TranslationBlock {
 
     /* the following data are used to directly call another TB from
        the code of this one. */
-    uint16_t tb_next_offset[2]; /* offset of original jump target */
-    uint16_t tb_jmp_offset[2];  /* offset of jump instruction */
+    uint32_t tb_next_offset[2]; /* offset of original jump target */
+    uint32_t tb_jmp_offset[2];  /* offset of jump instruction */
     /* list of TBs jumping to this one. This is a circular list using
        the two least significant bits of the pointers to tell what is
        the next pointer: 0 = jmp_next[0], 1 = jmp_next[1], 2 =
@@ -118,6 +122,8 @@ struct TranslationBlock {
     // signals that the `icount` of this tb has been added to global instructions counters
     // in case of exiting this tb before the end (e.g., in case of an exception, watchpoint etc.) the value of counters must be rebuilt
     uint32_t instructions_count_dirty;
+    /* set if translated while profiling; see tb_profile.c */
+    struct TbProfile *profile;
 #if DEBUG
     uint32_t lock_active;
     char *lock_file;
@@ -155,7 +161,7 @@ extern TranslationBlock *tb_phys_hash[CODE_GEN_PHYS_HASH_SIZE];
 static inline void tb_set_jmp_target1(uintptr_t jmp_addr, uintptr_t addr)
 {
     /* patch the branch destination */
-    *(uint32_t *)jmp_addr = addr - (jmp_addr + 4);
+    *(uint32_t *)tcg_code_rw((uint8_t *)jmp_addr) = addr - (jmp_addr + 4);
     /* no need to flush icache explicitly */
 }
 #elif defined(__arm__)
@@ -193,17 +199,36 @@ static inline void tb_set_jmp_target(TranslationBlock *tb, int n, uintptr_t addr
     tb_set_jmp_target1((uintptr_t)(tb->tc_ptr + offset), addr);
 }
 
-static inline void tb_add_jump(TranslationBlock *tb, int n, TranslationBlock *tb_next)
+#if defined(__x86_64__)
+/* the translation cache can be larger than the range of a direct jump */
+static inline bool tb_jmp_target_in_range(TranslationBlock *tb, int n, uintptr_t addr)
 {
-    /* NOTE: this test is only needed for thread safety */
-    if (!tb->jmp_next[n]) {
+    intptr_t disp = addr - ((uintptr_t)tb->tc_ptr + tb->tb_jmp_offset[n] + 4);
+
+    return disp == (int32_t)disp;
+}
+#else
+static inline bool tb_jmp_target_in_range(TranslationBlock *tb, int n, uintptr_t addr)
+{
+    return true;
+}
+#endif
+
+/* returns true if the jump was patched */
+static inline bool tb_add_jump(TranslationBlock *tb, int n, TranslationBlock *tb_next)
+{
+    /* NOTE: this test is only needed for thread safety; blocks too far
+       apart are not chained and return to the main loop instead */
+    if (!tb->jmp_next[n] && tb_jmp_target_in_range(tb, n, (uintptr_t)tb_next->tc_ptr)) {
         /* patch the native jump address */
         tb_set_jmp_target(tb, n, (uintptr_t)tb_next->tc_ptr);
 
         /* add in TB jmp circular list */
         tb->jmp_next[n] = tb_next->jmp_first;
         tb_next->jmp_first = (TranslationBlock *)((uintptr_t)(tb) | (n));
+        return true;
     }
+    return false;
 }
 
 TranslationBlock *tb_find_pc(uintptr_t pc_ptr);
@@ -269,7 +294,25 @@ PhysPageDesc *phys_page_find(target_phys_addr_t index);
 
 void tb_invalidate_phys_page_range_inner(tb_page_addr_t start, tb_page_addr_t end, int is_cpu_write_access, int broadcast);
 
+/* per page self modifying code statistics */
+typedef struct SmcPageStatistics {
+    uint64_t page_address;
+    /* guest writes trapped while the page held translated code */
+    uint64_t writes;
+    /* of which hit translated code */
+    uint64_t code_writes;
+    /* translation blocks invalidated, by guest writes or by the host */
+    uint32_t invalidations;
+    /* set once 'invalidations' reaches the threshold; code on the page
+       is then translated one instruction per block */
+    uint32_t single_insn;
+} SmcPageStatistics;
+
+uint32_t smc_get_statistics(SmcPageStatistics *out, uint32_t max_entries);
+void smc_reset_statistics(void);
+
 extern void unmap_page(target_phys_addr_t address);
 void free_all_page_descriptors(void);
 void code_gen_free(void);
+uintptr_t code_gen_buffer_room(const uint8_t *tc_ptr);
 #endif
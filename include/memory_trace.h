@@ -0,0 +1,78 @@
+/*
+ *  Memory access trace.
+ *
+ *  Copyright (c) Antmicro
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#if !defined (__MEMORY_TRACE_H__)
+#define __MEMORY_TRACE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MAX_MEMORY_TRACE_FILTERS 8
+
+typedef struct MemoryTraceEntry {
+    uint64_t vaddr;
+    uint64_t paddr;
+    /* address of the instruction doing the access; for accesses made by
+       helpers outside the generated code, of the block that called them */
+    uint64_t pc;
+    /* operation as passed to tlib_on_memory_access */
+    uint32_t type;
+    /* access size in bytes */
+    uint32_t width;
+} MemoryTraceEntry;
+
+typedef struct MemoryTraceFilter {
+    uint64_t start;
+    uint64_t size;
+} MemoryTraceFilter;
+
+/* Single producer (the CPU thread), single consumer ring buffer. 'head',
+   'pending' and 'tail' run freely and are taken modulo 'capacity', a power
+   of two. The entries in [head, pending) are not visible to the consumer
+   yet: their pc is still the host return address kept in 'retaddrs'. */
+typedef struct MemoryTrace {
+    MemoryTraceEntry *entries;
+    uintptr_t *retaddrs;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t pending;
+    uint32_t tail;
+    uint64_t dropped;
+    /* physical ranges to trace; everything is traced if there are none */
+    MemoryTraceFilter filters[MAX_MEMORY_TRACE_FILTERS];
+    int filters_count;
+} MemoryTrace;
+
+extern MemoryTrace memory_trace;
+
+static inline bool memory_trace_enabled(void)
+{
+    return memory_trace.entries != NULL;
+}
+
+int32_t memory_trace_enable(uint32_t capacity);
+void memory_trace_disable(void);
+int32_t memory_trace_add_filter(uint64_t start, uint64_t size);
+void memory_trace_clear_filters(void);
+bool memory_trace_page_is_traced(uint64_t page_paddr);
+void memory_trace_record(uint32_t type, uint32_t width, uint64_t vaddr, uint64_t paddr, void *retaddr);
+void memory_trace_publish(void);
+uint32_t memory_trace_read(MemoryTraceEntry *out, uint32_t max_entries);
+void memory_trace_notify(void);
+
+#endif // __MEMORY_TRACE_H__
@@ -0,0 +1,42 @@
+/*
+ *  Perf map and jitdump output for the translated code.
+ *
+ *  Copyright (c) Antmicro
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#if !defined (__PERF_MAP_H__)
+#define __PERF_MAP_H__
+
+#include <stdint.h>
+
+/* perf_map_enable modes */
+#define PERF_MAP_DISABLED 0
+/* /tmp/perf-<pid>.map, names only */
+#define PERF_MAP_SYMBOLS  1
+/* <directory>/jit-<pid>.dump, with the code of every block */
+#define PERF_MAP_JITDUMP  2
+
+struct TranslationBlock;
+
+extern int perf_map_mode;
+
+int32_t perf_map_enable(uint32_t mode, const char *directory);
+void perf_map_close(void);
+void perf_map_record(struct TranslationBlock *tb, int host_size);
+void perf_map_flush(void);
+int32_t perf_map_add_symbol(uint64_t start, uint64_t size, const char *name);
+void perf_map_clear_symbols(void);
+
+#endif // __PERF_MAP_H__
@@ -24,6 +24,7 @@
 #include "infrastructure.h"
 #include <stdint.h>
 #include "atomic.h"
+#include "memory_trace.h"
 
 extern void *global_retaddr;
 
@@ -71,6 +72,7 @@ uint32_t local_ntohl(uint32_t n);
 void notdirty_mem_writeb(void *opaque, target_phys_addr_t ram_addr, uint32_t val);
 void notdirty_mem_writew(void *opaque, target_phys_addr_t ram_addr, uint32_t val);
 void notdirty_mem_writel(void *opaque, target_phys_addr_t ram_addr, uint32_t val);
+void notdirty_mem_writeq(void *opaque, target_phys_addr_t ram_addr, uint64_t val);
 
 static DATA_TYPE glue(glue(slow_ld, SUFFIX), MMUSUFFIX)(target_ulong addr, int mmu_idx, void *retaddr);
 static inline DATA_TYPE glue(glue(glue(slow_ld, SUFFIX), _err), MMUSUFFIX)(target_ulong addr, int mmu_idx, void *retaddr, int *err);
@@ -80,6 +82,7 @@ static inline DATA_TYPE glue(io_read, SUFFIX)(target_phys_addr_t physaddr, targe
     physaddr = (physaddr & TARGET_PAGE_MASK) + addr;
     cpu->mem_io_pc = (uintptr_t)retaddr;
     cpu->mem_io_vaddr = addr;
+    cpu->statistics.mmio_reads++;
 #if SHIFT == 0
     res = tlib_read_byte(physaddr);
 #elif SHIFT == 1
@@ -94,6 +97,22 @@ static inline DATA_TYPE glue(io_read, SUFFIX)(target_phys_addr_t physaddr, targe
     return res;
 }
 
+/* report an access that hit the TLB; the entry for 'addr' is still valid */
+static inline void glue(glue(notify_access, SUFFIX), MMUSUFFIX)(uint32_t operation, target_ulong addr, int mmu_idx,
+                                                                 void *retaddr)
+{
+    if (unlikely(cpu->tlib_is_on_memory_access_enabled != 0)) {
+        tlib_on_memory_access(operation, addr);
+    }
+#ifndef SOFTMMU_CODE_ACCESS
+    if (unlikely(memory_trace_enabled())) {
+        memory_trace_record(operation, DATA_SIZE, addr,
+                            (cpu->iotlb[mmu_idx][(addr >> TARGET_PAGE_BITS) & (CPU_TLB_SIZE - 1)] & TARGET_PAGE_MASK) + addr,
+                            retaddr);
+    }
+#endif
+}
+
 /* handle all cases except unaligned access which span two pages */
 DATA_TYPE REGPARM glue(glue(glue(__ld, SUFFIX), _err), MMUSUFFIX)(target_ulong addr, int mmu_idx, int *err)
 {
@@ -104,6 +123,12 @@ DATA_TYPE REGPARM glue(glue(glue(__ld, SUFFIX), _err), MMUSUFFIX)(target_ulong a
     void *retaddr;
     uintptr_t addend;
 
+#ifndef SOFTMMU_CODE_ACCESS
+    cpu->statistics.memory_helper_calls++;
+    if (unlikely(!QTAILQ_EMPTY(&cpu->watchpoints))) {
+        cpu_check_watchpoint(cpu, addr, DATA_SIZE, BP_MEM_READ, (uintptr_t)GETPC());
+    }
+#endif
     acquire_global_memory_lock(cpu);
     register_address_access(cpu, addr);
 
@@ -124,7 +149,7 @@ DATA_TYPE REGPARM glue(glue(glue(__ld, SUFFIX), _err), MMUSUFFIX)(target_ulong a
     }
 
 redo:
-    tlb_addr = cpu->tlb_table[mmu_idx][index].ADDR_READ & ~TLB_ONE_SHOT;
+    tlb_addr = cpu->tlb_table[mmu_idx][index].ADDR_READ & ~(TLB_ONE_SHOT | TLB_FORCE_SLOW);
 
     if ((addr & TARGET_PAGE_MASK) == (tlb_addr & (TARGET_PAGE_MASK | TLB_INVALID_MASK))) {
         if ((tlb_addr & ~TARGET_PAGE_MASK) == TLB_MMIO) {
@@ -136,10 +161,7 @@ redo:
             global_retaddr = retaddr;
             ioaddr = cpu->iotlb[mmu_idx][index];
             res = glue(io_read, SUFFIX)(ioaddr, addr, retaddr);
-            if(unlikely(cpu->tlib_is_on_memory_access_enabled != 0))
-            {
-                tlib_on_memory_access(MEMORY_IO_READ, addr);
-            }
+            glue(glue(notify_access, SUFFIX), MMUSUFFIX)(MEMORY_IO_READ, addr, mmu_idx, retaddr);
         } else if (((addr & ~TARGET_PAGE_MASK) + DATA_SIZE - 1) >= TARGET_PAGE_SIZE) {
             /* slow unaligned access (it spans two pages or IO) */
 do_unaligned_access:
@@ -150,10 +172,7 @@ do_unaligned_access:
             }
 #endif
             res = glue(glue(glue(slow_ld, SUFFIX), _err), MMUSUFFIX)(addr, mmu_idx, retaddr, err);
-            if(unlikely(cpu->tlib_is_on_memory_access_enabled != 0))
-            {
-                tlib_on_memory_access(MEMORY_READ, addr);
-            }
+            glue(glue(notify_access, SUFFIX), MMUSUFFIX)(MEMORY_READ, addr, mmu_idx, retaddr);
         } else {
             /* unaligned/aligned access in the same page */
 #ifdef ALIGNED_ONLY
@@ -162,12 +181,10 @@ do_unaligned_access:
                 do_unaligned_access(addr, READ_ACCESS_TYPE, mmu_idx, retaddr);
             }
 #endif
+            retaddr = GETPC();
             addend = cpu->tlb_table[mmu_idx][index].addend;
             res = glue(glue(ld, USUFFIX), _raw)((uint8_t *)(uintptr_t)(addr + addend));
-            if(unlikely(cpu->tlib_is_on_memory_access_enabled != 0))
-            {
-                tlib_on_memory_access(MEMORY_READ, addr);
-            }
+            glue(glue(notify_access, SUFFIX), MMUSUFFIX)(MEMORY_READ, addr, mmu_idx, retaddr);
         }
     } else {
         /* the page is not in the TLB : fill it */
@@ -220,7 +237,7 @@ static DATA_TYPE glue(glue(glue(slow_ld, SUFFIX), _err), MMUSUFFIX)(target_ulong
     }
 
 redo:
-    tlb_addr = cpu->tlb_table[mmu_idx][index].ADDR_READ & ~TLB_ONE_SHOT;
+    tlb_addr = cpu->tlb_table[mmu_idx][index].ADDR_READ & ~(TLB_ONE_SHOT | TLB_FORCE_SLOW);
 
     if ((addr & TARGET_PAGE_MASK) == (tlb_addr & (TARGET_PAGE_MASK | TLB_INVALID_MASK))) {
         if ((tlb_addr & ~TARGET_PAGE_MASK) == TLB_MMIO) {
@@ -274,22 +291,17 @@ static void glue(glue(slow_st, SUFFIX), MMUSUFFIX)(target_ulong addr, DATA_TYPE
 
 static inline void glue(io_write, SUFFIX)(target_phys_addr_t physaddr, DATA_TYPE val, target_ulong addr, void *retaddr)
 {
-#if SHIFT <= 2
     int index;
     index = (physaddr >> IO_MEM_SHIFT) & (IO_MEM_NB_ENTRIES - 1);
-#endif
     physaddr = (physaddr & TARGET_PAGE_MASK) + addr;
     cpu->mem_io_vaddr = addr;
     cpu->mem_io_pc = (uintptr_t)retaddr;
-    /* TODO: added stuff */
-#if SHIFT <= 2
     if (index == IO_MEM_NOTDIRTY >> IO_MEM_SHIFT) {
         /* opaque is not used here, so we pass NULL */
         glue(notdirty_mem_write, SUFFIX)(NULL, physaddr, val);
         return;
     }
-    /* TODO: added stuff ends */
-#endif
+    cpu->statistics.mmio_writes++;
 #if SHIFT == 0
     tlib_write_byte(physaddr, val);
 #elif SHIFT == 1
@@ -311,6 +323,10 @@ void REGPARM glue(glue(__st, SUFFIX), MMUSUFFIX)(target_ulong addr, DATA_TYPE va
     int index;
     uintptr_t addend;
 
+    cpu->statistics.memory_helper_calls++;
+    if (unlikely(!QTAILQ_EMPTY(&cpu->watchpoints))) {
+        cpu_check_watchpoint(cpu, addr, DATA_SIZE, BP_MEM_WRITE, (uintptr_t)GETPC());
+    }
     acquire_global_memory_lock(cpu);
     register_address_access(cpu, addr);
 
@@ -329,7 +345,7 @@ void REGPARM glue(glue(__st, SUFFIX), MMUSUFFIX)(target_ulong addr, DATA_TYPE va
     }
 
 redo:
-    tlb_addr = cpu->tlb_table[mmu_idx][index].addr_write & ~TLB_ONE_SHOT;
+    tlb_addr = cpu->tlb_table[mmu_idx][index].addr_write & ~(TLB_ONE_SHOT | TLB_FORCE_SLOW);
 
     if ((addr & TARGET_PAGE_MASK) == (tlb_addr & (TARGET_PAGE_MASK | TLB_INVALID_MASK))) {
         if ((tlb_addr & ~TARGET_PAGE_MASK) == TLB_MMIO) {
@@ -341,10 +357,7 @@ redo:
             global_retaddr = retaddr;
             ioaddr = cpu->iotlb[mmu_idx][index];
             glue(io_write, SUFFIX)(ioaddr, val, addr, retaddr);
-            if(unlikely(cpu->tlib_is_on_memory_access_enabled != 0))
-            {
-                tlib_on_memory_access(MEMORY_IO_WRITE, addr);
-            }
+            glue(glue(notify_access, SUFFIX), MMUSUFFIX)(MEMORY_IO_WRITE, addr, mmu_idx, retaddr);
         } else if (((addr & ~TARGET_PAGE_MASK) + DATA_SIZE - 1) >= TARGET_PAGE_SIZE) {
 do_unaligned_access:
             retaddr = GETPC();
@@ -354,10 +367,7 @@ do_unaligned_access:
             }
 #endif
             glue(glue(slow_st, SUFFIX), MMUSUFFIX)(addr, val, mmu_idx, retaddr);
-            if(unlikely(cpu->tlib_is_on_memory_access_enabled != 0))
-            {
-                tlib_on_memory_access(MEMORY_WRITE, addr);
-            }
+            glue(glue(notify_access, SUFFIX), MMUSUFFIX)(MEMORY_WRITE, addr, mmu_idx, retaddr);
         } else {
             /* aligned/unaligned access in the same page */
 #ifdef ALIGNED_ONLY
@@ -366,12 +376,10 @@ do_unaligned_access:
                 do_unaligned_access(addr, 1, mmu_idx, retaddr);
             }
 #endif
+            retaddr = GETPC();
             addend = cpu->tlb_table[mmu_idx][index].addend;
             glue(glue(st, SUFFIX), _raw)((uint8_t *)(uintptr_t)(addr + addend), val);
-            if(unlikely(cpu->tlib_is_on_memory_access_enabled != 0))
-            {
-                tlib_on_memory_access(MEMORY_WRITE, addr);
-            }
+            glue(glue(notify_access, SUFFIX), MMUSUFFIX)(MEMORY_WRITE, addr, mmu_idx, retaddr);
         }
     } else {
         /* the page is not in the TLB : fill it */
@@ -411,7 +419,7 @@ static void glue(glue(slow_st, SUFFIX), MMUSUFFIX)(target_ulong addr, DATA_TYPE
     }
 
 redo:
-    tlb_addr = cpu->tlb_table[mmu_idx][index].addr_write & ~TLB_ONE_SHOT;
+    tlb_addr = cpu->tlb_table[mmu_idx][index].addr_write & ~(TLB_ONE_SHOT | TLB_FORCE_SLOW);
 
     if ((addr & TARGET_PAGE_MASK) == (tlb_addr & (TARGET_PAGE_MASK | TLB_INVALID_MASK))) {
         if ((tlb_addr & ~TARGET_PAGE_MASK) == TLB_MMIO) {
@@ -0,0 +1,43 @@
+/*
+ *  Dump of the TCG ops and the host code of translated blocks.
+ *
+ *  Copyright (c) Antmicro
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#if !defined (__TB_DUMP_H__)
+#define __TB_DUMP_H__
+
+#include <stdint.h>
+
+/* parts of a block written by tb_dump_enable, the TCG ones have the
+   values of the TCG_DUMP_* flags */
+#define TB_DUMP_IR        (1 << 0) /* the ops as generated by the front end */
+#define TB_DUMP_IR_OPT    (1 << 1) /* the ops after the optimizer */
+#define TB_DUMP_LIVENESS  (1 << 2) /* the ops with the dead arguments, the
+                                      preferred output registers and the
+                                      temps live at branches and labels */
+#define TB_DUMP_HOST_CODE (1 << 3) /* the bytes of the host code */
+
+struct TranslationBlock;
+
+extern uint32_t tb_dump_parts;
+
+int32_t tb_dump_enable(uint32_t parts, uint64_t start, uint64_t end, const char *path);
+void tb_dump_close(void);
+int tb_dump_begin(struct TranslationBlock *tb);
+void tb_dump_end(struct TranslationBlock *tb, int host_size);
+void tb_dump_flush(void);
+
+#endif // __TB_DUMP_H__
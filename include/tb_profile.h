@@ -0,0 +1,75 @@
+/*
+ *  Translation block profiling.
+ *
+ *  Copyright (c) Antmicro
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#if !defined (__TB_PROFILE_H__)
+#define __TB_PROFILE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TB_PROFILE_HASH_BITS 12
+#define TB_PROFILE_HASH_SIZE (1 << TB_PROFILE_HASH_BITS)
+
+/* sort keys of tb_profile_dump, in descending order */
+#define TB_PROFILE_SORT_EXECUTIONS       0
+#define TB_PROFILE_SORT_TRANSLATION_TIME 1
+#define TB_PROFILE_SORT_TRANSLATIONS     2
+#define TB_PROFILE_SORT_INVALIDATIONS    3
+#define TB_PROFILE_SORT_HOST_SIZE        4
+
+/* Profile of the code at a guest address. It outlives the translation
+   blocks generated for it, so that retranslations add up. */
+typedef struct TbProfile {
+    uint64_t pc;
+    uint64_t phys_pc;
+    /* physical address of the second page, -1 if the block fits in one */
+    uint64_t phys_page2;
+    uint64_t executions;
+    uint64_t translation_time_ns;
+    uint32_t translations;
+    uint32_t invalidations;
+    /* of the latest translation */
+    uint32_t icount;
+    uint32_t guest_size;
+    uint32_t host_size;
+    uint32_t disas_flags;
+    struct TbProfile *next;
+} TbProfile;
+
+typedef struct TbProfiler {
+    bool enabled;
+    TbProfile *table[TB_PROFILE_HASH_SIZE];
+    uint32_t count;
+} TbProfiler;
+
+extern TbProfiler tb_profiler;
+
+struct TranslationBlock;
+
+static inline bool tb_profiling_enabled(void)
+{
+    return tb_profiler.enabled;
+}
+
+void tb_profile_set_enabled(bool enabled);
+void tb_profile_translated(struct TranslationBlock *tb, uint64_t phys_pc, uint64_t time_ns, int host_size);
+void tb_profile_reset(void);
+void tb_profile_free(void);
+int32_t tb_profile_dump(const char *path, uint32_t max_entries, uint32_t sort_key);
+
+#endif // __TB_PROFILE_H__
@@ -0,0 +1,193 @@
+/*
+ *  Memory access trace.
+ *
+ *  Copyright (c) Antmicro
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cpu.h"
+#include "exec-all.h"
+#include "memory_trace.h"
+
+/* Accesses to traced pages miss the inline TLB check of the generated
+   code (the TLB entries carry TLB_FORCE_SLOW) and are recorded by the softmmu
+   helpers; pages outside the filters keep the fast path. The host drains
+   the buffer when it is full and at the end of each tlib_execute call.
+   Finding the accessing instruction means translating its block again, so
+   it is only done for the whole batch, before the host is notified. */
+MemoryTrace memory_trace;
+
+static bool memory_trace_filter_match(uint64_t start, uint64_t last)
+{
+    MemoryTraceFilter *f;
+    int i;
+
+    if (memory_trace.filters_count == 0) {
+        return true;
+    }
+    for (i = 0; i < memory_trace.filters_count; i++) {
+        f = &memory_trace.filters[i];
+        if (start - f->start < f->size || f->start - start <= last - start) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline uint32_t memory_trace_count(void)
+{
+    return memory_trace.pending - __atomic_load_n(&memory_trace.tail, __ATOMIC_ACQUIRE);
+}
+
+int32_t memory_trace_enable(uint32_t capacity)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return -1;
+    }
+    memory_trace_disable();
+    memory_trace.entries = tlib_malloc(capacity * sizeof(MemoryTraceEntry));
+    memory_trace.retaddrs = tlib_malloc(capacity * sizeof(uintptr_t));
+    memory_trace.capacity = capacity;
+    memory_trace.head = 0;
+    memory_trace.pending = 0;
+    memory_trace.tail = 0;
+    memory_trace.dropped = 0;
+    tlb_flush(cpu, 1);
+    return 0;
+}
+
+void memory_trace_disable(void)
+{
+    if (memory_trace.entries == NULL) {
+        return;
+    }
+    tlib_free(memory_trace.entries);
+    tlib_free(memory_trace.retaddrs);
+    memory_trace.entries = NULL;
+    memory_trace.retaddrs = NULL;
+    memory_trace.capacity = 0;
+    tlb_flush(cpu, 1);
+}
+
+int32_t memory_trace_add_filter(uint64_t start, uint64_t size)
+{
+    if (memory_trace.filters_count == MAX_MEMORY_TRACE_FILTERS || size == 0) {
+        return -1;
+    }
+    memory_trace.filters[memory_trace.filters_count].start = start;
+    memory_trace.filters[memory_trace.filters_count].size = size;
+    memory_trace.filters_count++;
+    tlb_flush(cpu, 1);
+    return 0;
+}
+
+void memory_trace_clear_filters(void)
+{
+    memory_trace.filters_count = 0;
+    tlb_flush(cpu, 1);
+}
+
+bool memory_trace_page_is_traced(uint64_t page_paddr)
+{
+    return memory_trace_filter_match(page_paddr, page_paddr + (TARGET_PAGE_SIZE - 1));
+}
+
+void memory_trace_record(uint32_t type, uint32_t width, uint64_t vaddr, uint64_t paddr, void *retaddr)
+{
+    MemoryTraceEntry *entry;
+    uint32_t index;
+
+    if (!memory_trace_filter_match(paddr, paddr + (width - 1))) {
+        return;
+    }
+    if (memory_trace_count() == memory_trace.capacity) {
+        memory_trace_publish();
+        tlib_on_memory_trace_ready(memory_trace.capacity);
+        /* the host may also have disabled tracing */
+        if (memory_trace.entries == NULL) {
+            return;
+        }
+        if (memory_trace_count() == memory_trace.capacity) {
+            memory_trace.dropped++;
+            return;
+        }
+    }
+    index = memory_trace.pending & (memory_trace.capacity - 1);
+    entry = &memory_trace.entries[index];
+    entry->vaddr = vaddr;
+    entry->paddr = paddr;
+    entry->type = type;
+    entry->width = width;
+    /* kept if the access was not made from the generated code */
+    entry->pc = cpu->current_tb != NULL ? cpu->current_tb->pc : 0;
+    memory_trace.retaddrs[index] = (uintptr_t)retaddr;
+    memory_trace.pending++;
+}
+
+/* Fill in the pc of the entries recorded since the last call and make them
+   visible to memory_trace_read. Must also be called before the blocks they
+   were recorded in are thrown away. */
+void memory_trace_publish(void)
+{
+    MemoryTraceEntry *entry;
+    TranslationBlock *tb;
+    uint32_t i, index;
+
+    if (memory_trace.entries == NULL) {
+        return;
+    }
+    for (i = memory_trace.head; i != memory_trace.pending; i++) {
+        index = i & (memory_trace.capacity - 1);
+        entry = &memory_trace.entries[index];
+        tb = tb_find_pc(memory_trace.retaddrs[index]);
+        if (tb != NULL) {
+            entry->pc = cpu_get_instruction_pc(cpu, tb, memory_trace.retaddrs[index]);
+        }
+    }
+    __atomic_store_n(&memory_trace.head, memory_trace.pending, __ATOMIC_RELEASE);
+}
+
+/* Copy out up to 'max_entries' of the oldest entries and free their
+   slots. Can be called from any thread. */
+uint32_t memory_trace_read(MemoryTraceEntry *out, uint32_t max_entries)
+{
+    uint32_t head, tail, count, i;
+
+    if (memory_trace.entries == NULL) {
+        return 0;
+    }
+    head = __atomic_load_n(&memory_trace.head, __ATOMIC_ACQUIRE);
+    tail = memory_trace.tail;
+    count = head - tail < max_entries ? head - tail : max_entries;
+    for (i = 0; i < count; i++) {
+        out[i] = memory_trace.entries[(tail + i) & (memory_trace.capacity - 1)];
+    }
+    __atomic_store_n(&memory_trace.tail, tail + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+/* called at the end of tlib_execute */
+void memory_trace_notify(void)
+{
+    uint32_t count;
+
+    if (memory_trace.entries == NULL) {
+        return;
+    }
+    memory_trace_publish();
+    count = memory_trace_count();
+    if (count != 0) {
+        tlib_on_memory_trace_ready(count);
+    }
+}
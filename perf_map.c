@@ -0,0 +1,321 @@
+/*
+ *  Perf map and jitdump output for the translated code.
+ *
+ *  Copyright (c) Antmicro
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "cpu.h"
+#include "exec-all.h"
+#include "tcg.h"
+#include "perf_map.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+/* Every translated block gets a record named after its guest pc and the
+   host-registered symbol containing it. Records are never withdrawn: the
+   code of an invalidated block is described again by the record of the
+   block that reuses its space, which perf picks by time (jitdump) or by
+   order (perf map). */
+int perf_map_mode;
+
+static FILE *perf_map_file;
+#if defined(__linux__)
+static void *perf_map_marker;
+static long perf_map_page_size;
+#endif
+static uint64_t perf_map_code_index;
+
+typedef struct PerfMapSymbol {
+    uint64_t start;
+    uint64_t size;
+    char *name;
+} PerfMapSymbol;
+
+/* sorted by start */
+static PerfMapSymbol *perf_map_symbols;
+static uint32_t perf_map_symbols_count;
+static uint32_t perf_map_symbols_capacity;
+
+/* jitdump format, see tools/perf/Documentation/jitdump-specification.txt */
+#define JITDUMP_MAGIC         0x4A695444
+#define JITDUMP_VERSION       1
+#define JITDUMP_CODE_LOAD     0
+#define JITDUMP_CODE_CLOSE    3
+
+typedef struct JitdumpHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t total_size;
+    uint32_t elf_mach;
+    uint32_t pad1;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+} JitdumpHeader;
+
+typedef struct JitdumpRecordHeader {
+    uint32_t id;
+    uint32_t total_size;
+    uint64_t timestamp;
+} JitdumpRecordHeader;
+
+typedef struct JitdumpCodeLoad {
+    JitdumpRecordHeader header;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t vma;
+    uint64_t code_addr;
+    uint64_t code_size;
+    uint64_t code_index;
+} JitdumpCodeLoad;
+
+#if defined(__x86_64__)
+#define JITDUMP_ELF_MACH 62
+#elif defined(__i386__)
+#define JITDUMP_ELF_MACH 3
+#elif defined(__aarch64__)
+#define JITDUMP_ELF_MACH 183
+#elif defined(__arm__)
+#define JITDUMP_ELF_MACH 40
+#else
+#define JITDUMP_ELF_MACH 0
+#endif
+
+/* perf record -k mono */
+static uint64_t perf_map_timestamp(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static const PerfMapSymbol *perf_map_find_symbol(uint64_t pc)
+{
+    uint32_t low = 0, high = perf_map_symbols_count;
+    uint32_t middle;
+
+    /* find the last symbol starting at or before 'pc' */
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (perf_map_symbols[middle].start <= pc) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == 0 || pc - perf_map_symbols[low - 1].start >= perf_map_symbols[low - 1].size) {
+        return NULL;
+    }
+    return &perf_map_symbols[low - 1];
+}
+
+static void perf_map_name(char *name, size_t size, uint64_t pc)
+{
+    const PerfMapSymbol *symbol = perf_map_find_symbol(pc);
+
+    if (symbol != NULL) {
+        snprintf(name, size, "guest:%s+0x%" PRIx64 " [0x%" PRIx64 "]", symbol->name, pc - symbol->start, pc);
+    } else {
+        snprintf(name, size, "guest:0x%" PRIx64, pc);
+    }
+}
+
+#if defined(__linux__)
+static int32_t perf_map_open_jitdump(const char *directory)
+{
+    JitdumpHeader header;
+    char path[4096];
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/jit-%d.dump", directory != NULL ? directory : "/tmp", getpid());
+    fd = open(path, O_CREAT | O_TRUNC | O_RDWR, 0666);
+    if (fd < 0) {
+        return -1;
+    }
+    /* perf finds the file through this executable mapping of it */
+    perf_map_page_size = sysconf(_SC_PAGESIZE);
+    perf_map_marker = mmap(NULL, perf_map_page_size, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+    if (perf_map_marker == MAP_FAILED) {
+        perf_map_marker = NULL;
+        close(fd);
+        return -1;
+    }
+    perf_map_file = fdopen(fd, "wb");
+    if (perf_map_file == NULL) {
+        munmap(perf_map_marker, perf_map_page_size);
+        perf_map_marker = NULL;
+        close(fd);
+        return -1;
+    }
+    memset(&header, 0, sizeof(header));
+    header.magic = JITDUMP_MAGIC;
+    header.version = JITDUMP_VERSION;
+    header.total_size = sizeof(header);
+    header.elf_mach = JITDUMP_ELF_MACH;
+    header.pid = getpid();
+    header.timestamp = perf_map_timestamp();
+    fwrite(&header, sizeof(header), 1, perf_map_file);
+    return 0;
+}
+#endif
+
+/* Translated blocks are dropped so that every block in use gets a record. */
+int32_t perf_map_enable(uint32_t mode, const char *directory)
+{
+#if defined(__linux__)
+    char path[64];
+
+    perf_map_close();
+    switch (mode) {
+    case PERF_MAP_DISABLED:
+        return 0;
+    case PERF_MAP_SYMBOLS:
+        /* perf only looks for it in /tmp */
+        snprintf(path, sizeof(path), "/tmp/perf-%d.map", getpid());
+        perf_map_file = fopen(path, "w");
+        if (perf_map_file == NULL) {
+            return -1;
+        }
+        break;
+    case PERF_MAP_JITDUMP:
+        if (perf_map_open_jitdump(directory) != 0) {
+            return -1;
+        }
+        break;
+    default:
+        return -1;
+    }
+    perf_map_mode = mode;
+    perf_map_code_index = 0;
+    tb_flush(cpu);
+    return 0;
+#else
+    return mode == PERF_MAP_DISABLED ? 0 : -1;
+#endif
+}
+
+void perf_map_close(void)
+{
+    JitdumpRecordHeader close_record;
+
+    if (perf_map_file == NULL) {
+        return;
+    }
+    if (perf_map_mode == PERF_MAP_JITDUMP) {
+        close_record.id = JITDUMP_CODE_CLOSE;
+        close_record.total_size = sizeof(close_record);
+        close_record.timestamp = perf_map_timestamp();
+        fwrite(&close_record, sizeof(close_record), 1, perf_map_file);
+    }
+    fclose(perf_map_file);
+    perf_map_file = NULL;
+#if defined(__linux__)
+    if (perf_map_marker != NULL) {
+        munmap(perf_map_marker, perf_map_page_size);
+        perf_map_marker = NULL;
+    }
+#endif
+    perf_map_mode = PERF_MAP_DISABLED;
+}
+
+void perf_map_record(TranslationBlock *tb, int host_size)
+{
+    char name[256];
+#if defined(__linux__)
+    JitdumpCodeLoad record;
+    size_t name_size;
+#endif
+
+    perf_map_name(name, sizeof(name), tb->pc);
+    if (perf_map_mode == PERF_MAP_SYMBOLS) {
+        fprintf(perf_map_file, "%" PRIxPTR " %x %s\n", (uintptr_t)tb->tc_ptr, host_size, name);
+        return;
+    }
+#if defined(__linux__)
+    name_size = strlen(name) + 1;
+    record.header.id = JITDUMP_CODE_LOAD;
+    record.header.total_size = sizeof(record) + name_size + host_size;
+    record.header.timestamp = perf_map_timestamp();
+    record.pid = getpid();
+    record.tid = syscall(SYS_gettid);
+    record.vma = (uintptr_t)tb->tc_ptr;
+    record.code_addr = (uintptr_t)tb->tc_ptr;
+    record.code_size = host_size;
+    record.code_index = perf_map_code_index++;
+    fwrite(&record, sizeof(record), 1, perf_map_file);
+    fwrite(name, name_size, 1, perf_map_file);
+    fwrite(tcg_code_rw(tb->tc_ptr), host_size, 1, perf_map_file);
+#endif
+}
+
+/* called at the end of tlib_execute */
+void perf_map_flush(void)
+{
+    if (perf_map_file != NULL) {
+        fflush(perf_map_file);
+    }
+}
+
+/* Name guest code in [start, start + size). Overlapping an existing
+   symbol is an error. */
+int32_t perf_map_add_symbol(uint64_t start, uint64_t size, const char *name)
+{
+    uint32_t i;
+
+    if (size == 0) {
+        return -1;
+    }
+    for (i = perf_map_symbols_count; i > 0 && perf_map_symbols[i - 1].start > start; i--) {
+    }
+    if ((i > 0 && start - perf_map_symbols[i - 1].start < perf_map_symbols[i - 1].size) ||
+        (i < perf_map_symbols_count && perf_map_symbols[i].start - start < size)) {
+        return -1;
+    }
+    if (perf_map_symbols_count == perf_map_symbols_capacity) {
+        perf_map_symbols_capacity = perf_map_symbols_capacity != 0 ? perf_map_symbols_capacity * 2 : 64;
+        perf_map_symbols = tlib_realloc(perf_map_symbols, perf_map_symbols_capacity * sizeof(PerfMapSymbol));
+    }
+    memmove(&perf_map_symbols[i + 1], &perf_map_symbols[i], (perf_map_symbols_count - i) * sizeof(PerfMapSymbol));
+    perf_map_symbols[i].start = start;
+    perf_map_symbols[i].size = size;
+    perf_map_symbols[i].name = tlib_strdup(name);
+    perf_map_symbols_count++;
+    return 0;
+}
+
+void perf_map_clear_symbols(void)
+{
+    uint32_t i;
+
+    if (perf_map_symbols == NULL) {
+        return;
+    }
+    for (i = 0; i < perf_map_symbols_count; i++) {
+        tlib_free(perf_map_symbols[i].name);
+    }
+    tlib_free(perf_map_symbols);
+    perf_map_symbols = NULL;
+    perf_map_symbols_count = 0;
+    perf_map_symbols_capacity = 0;
+}
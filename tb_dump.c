@@ -0,0 +1,123 @@
+/*
+ *  Dump of the TCG ops and the host code of translated blocks.
+ *
+ *  Copyright (c) Antmicro
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdio.h>
+#include "cpu.h"
+#include "exec-all.h"
+#include "tcg.h"
+#include "tb_dump.h"
+
+#define TB_DUMP_TCG_PARTS (TB_DUMP_IR | TB_DUMP_IR_OPT | TB_DUMP_LIVENESS)
+
+/* The ops are written by tcg_gen_code while the block is generated, this
+   file adds a header before them and the host code after them. */
+uint32_t tb_dump_parts;
+
+static FILE *tb_dump_file;
+static uint64_t tb_dump_start;
+static uint64_t tb_dump_end_pc;
+
+/* Blocks starting at a guest pc in [start, end) are written to 'path' by
+   the time they are translated; the translated blocks are dropped so that
+   the ones in use are written too. */
+int32_t tb_dump_enable(uint32_t parts, uint64_t start, uint64_t end, const char *path)
+{
+    tb_dump_close();
+    if (parts == 0) {
+        return 0;
+    }
+    if (path == NULL || start >= end) {
+        return -1;
+    }
+    tb_dump_file = fopen(path, "w");
+    if (tb_dump_file == NULL) {
+        return -1;
+    }
+    tb_dump_parts = parts;
+    tb_dump_start = start;
+    tb_dump_end_pc = end;
+    tb_flush(cpu);
+    return 0;
+}
+
+void tb_dump_close(void)
+{
+    if (tb_dump_file == NULL) {
+        return;
+    }
+    fclose(tb_dump_file);
+    tb_dump_file = NULL;
+    tb_dump_parts = 0;
+    tcg->ctx->dump_flags = 0;
+    tcg->ctx->dump_file = NULL;
+}
+
+/* Called before 'tb' is generated, returns nonzero if it is dumped. The
+   flags are cleared by tcg_gen_code once the ops are written. */
+int tb_dump_begin(TranslationBlock *tb)
+{
+    TCGContext *s = tcg->ctx;
+
+    if ((uint64_t)tb->pc < tb_dump_start || (uint64_t)tb->pc >= tb_dump_end_pc) {
+        s->dump_flags = 0;
+        return 0;
+    }
+    fprintf(tb_dump_file, "TB pc 0x%" PRIx64 " cs_base 0x%" PRIx64 " flags 0x%" PRIx64 "\n", (uint64_t)tb->pc,
+            (uint64_t)tb->cs_base, tb->flags);
+    s->dump_flags = tb_dump_parts & TB_DUMP_TCG_PARTS;
+    s->dump_file = tb_dump_file;
+    return 1;
+}
+
+/* The host code lines can be fed to `llvm-mc --disassemble`, the offsets
+   are comments. */
+void tb_dump_end(TranslationBlock *tb, int host_size)
+{
+    TCGContext *s = tcg->ctx;
+    const uint8_t *code = tcg_code_rw(tb->tc_ptr);
+    int body_size, line_end, i, j;
+
+    fprintf(tb_dump_file, "guest: %d bytes, %u instructions; host: %d bytes at %p, %d of them in slow paths, "
+            "%d spills, %d reloads\n", tb->size, tb->icount, host_size, tb->tc_ptr, s->code_slow_path_size,
+            s->reg_spills, s->reg_reloads);
+    if (tb_dump_parts & TB_DUMP_HOST_CODE) {
+        body_size = host_size - s->code_slow_path_size;
+        for (i = 0; i < host_size; i = line_end) {
+            if (i == body_size) {
+                fprintf(tb_dump_file, "# slow paths\n");
+            }
+            line_end = i + 16 < host_size ? i + 16 : host_size;
+            if (i < body_size && line_end > body_size) {
+                line_end = body_size;
+            }
+            for (j = i; j < line_end; j++) {
+                fprintf(tb_dump_file, "0x%02x ", code[j]);
+            }
+            fprintf(tb_dump_file, "# +0x%04x\n", i);
+        }
+    }
+    fprintf(tb_dump_file, "\n");
+}
+
+/* called at the end of tlib_execute */
+void tb_dump_flush(void)
+{
+    if (tb_dump_file != NULL) {
+        fflush(tb_dump_file);
+    }
+}
@@ -0,0 +1,193 @@
+/*
+ *  Translation block profiling.
+ *
+ *  Copyright (c) Antmicro
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "cpu.h"
+#include "exec-all.h"
+#include "tb_profile.h"
+
+/* Blocks translated while profiling is enabled point to their profile
+   (tb->profile); executions are counted by the block header helper and
+   invalidations by tb_phys_invalidate. Dropping the profiles flushes the
+   translation cache, so no block is left pointing to a freed one. */
+TbProfiler tb_profiler;
+
+static uint32_t tb_profile_sort_key;
+
+static inline unsigned int tb_profile_hash(uint64_t pc, uint64_t phys_pc)
+{
+    return (pc ^ (phys_pc >> TB_PROFILE_HASH_BITS) ^ (phys_pc >> 2)) & (TB_PROFILE_HASH_SIZE - 1);
+}
+
+static TbProfile *tb_profile_get(uint64_t pc, uint64_t phys_pc)
+{
+    unsigned int h = tb_profile_hash(pc, phys_pc);
+    TbProfile *p;
+
+    for (p = tb_profiler.table[h]; p != NULL; p = p->next) {
+        if (p->pc == pc && p->phys_pc == phys_pc) {
+            return p;
+        }
+    }
+    p = tlib_mallocz(sizeof(TbProfile));
+    p->pc = pc;
+    p->phys_pc = phys_pc;
+    p->next = tb_profiler.table[h];
+    tb_profiler.table[h] = p;
+    tb_profiler.count++;
+    return p;
+}
+
+void tb_profile_translated(TranslationBlock *tb, uint64_t phys_pc, uint64_t time_ns, int host_size)
+{
+    TbProfile *p = tb_profile_get(tb->pc, phys_pc);
+
+    p->phys_page2 = tb->page_addr[1];
+    p->translations++;
+    p->translation_time_ns += time_ns;
+    p->icount = tb->icount;
+    p->guest_size = tb->size;
+    p->host_size = host_size;
+    p->disas_flags = tb->disas_flags;
+    tb->profile = p;
+}
+
+void tb_profile_free(void)
+{
+    TbProfile *p, *next;
+    int i;
+
+    for (i = 0; i < TB_PROFILE_HASH_SIZE; i++) {
+        for (p = tb_profiler.table[i]; p != NULL; p = next) {
+            next = p->next;
+            tlib_free(p);
+        }
+        tb_profiler.table[i] = NULL;
+    }
+    tb_profiler.count = 0;
+}
+
+void tb_profile_reset(void)
+{
+    tb_flush(cpu);
+    tb_profile_free();
+}
+
+void tb_profile_set_enabled(bool enabled)
+{
+    if (enabled == tb_profiler.enabled) {
+        return;
+    }
+    /* blocks are retranslated to start or stop counting */
+    tb_flush(cpu);
+    tb_profiler.enabled = enabled;
+}
+
+static uint64_t tb_profile_sort_value(const TbProfile *p)
+{
+    switch (tb_profile_sort_key) {
+    case TB_PROFILE_SORT_TRANSLATION_TIME:
+        return p->translation_time_ns;
+    case TB_PROFILE_SORT_TRANSLATIONS:
+        return p->translations;
+    case TB_PROFILE_SORT_INVALIDATIONS:
+        return p->invalidations;
+    case TB_PROFILE_SORT_HOST_SIZE:
+        return p->host_size;
+    default:
+        return p->executions;
+    }
+}
+
+static int tb_profile_compare(const void *a, const void *b)
+{
+    uint64_t value_a = tb_profile_sort_value(*(TbProfile *const *)a);
+    uint64_t value_b = tb_profile_sort_value(*(TbProfile *const *)b);
+
+    return value_a < value_b ? 1 : value_a > value_b ? -1 : 0;
+}
+
+/* The guest code is written as bytes, with the disassembler flags of the
+   block, for the host to decode. */
+static void tb_profile_write_code(FILE *f, const TbProfile *p)
+{
+    uint8_t *code;
+    uint32_t first, i;
+
+    if (p->guest_size == 0) {
+        return;
+    }
+    /* a block may be longer than a page */
+    code = tlib_malloc(p->guest_size);
+    first = TARGET_PAGE_SIZE - (p->phys_pc & ~TARGET_PAGE_MASK);
+    if (first > p->guest_size) {
+        first = p->guest_size;
+    }
+    cpu_physical_memory_read(p->phys_pc, code, first);
+    if (p->guest_size > first && p->phys_page2 != (uint64_t)-1) {
+        cpu_physical_memory_read(p->phys_page2, code + first, p->guest_size - first);
+    } else {
+        memset(code + first, 0, p->guest_size - first);
+    }
+    for (i = 0; i < p->guest_size; i++) {
+        fprintf(f, "%02x", code[i]);
+    }
+    tlib_free(code);
+}
+
+/* Write the first 'max_entries' profiles (all if 0) to 'path', sorted
+   by 'sort_key'. Returns the number of profiles written or -1 if the
+   file cannot be created. */
+int32_t tb_profile_dump(const char *path, uint32_t max_entries, uint32_t sort_key)
+{
+    TbProfile **sorted, *p;
+    uint32_t count = 0, i;
+    FILE *f;
+
+    f = fopen(path, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    sorted = tlib_malloc((tb_profiler.count + 1) * sizeof(TbProfile *));
+    for (i = 0; i < TB_PROFILE_HASH_SIZE; i++) {
+        for (p = tb_profiler.table[i]; p != NULL; p = p->next) {
+            sorted[count++] = p;
+        }
+    }
+    tb_profile_sort_key = sort_key;
+    qsort(sorted, count, sizeof(TbProfile *), tb_profile_compare);
+    if (max_entries != 0 && count > max_entries) {
+        count = max_entries;
+    }
+
+    fprintf(f, "# pc phys_pc executions instructions guest_size host_size host/guest translations invalidations "
+               "translation_time_ns disas_flags code\n");
+    for (i = 0; i < count; i++) {
+        p = sorted[i];
+        fprintf(f, "0x%" PRIx64 " 0x%" PRIx64 " %" PRIu64 " %u %u %u %.2f %u %u %" PRIu64 " 0x%x ", p->pc, p->phys_pc,
+                p->executions, p->icount, p->guest_size, p->host_size,
+                p->guest_size != 0 ? (double)p->host_size / p->guest_size : 0.0, p->translations, p->invalidations,
+                p->translation_time_ns, p->disas_flags);
+        tb_profile_write_code(f, p);
+        fprintf(f, "\n");
+    }
+    tlib_free(sorted);
+    fclose(f);
+    return count;
+}
@@ -35,8 +35,10 @@ extern unsigned int sizeof_CPUTLBEntry;
  * and up to 4 + N parameters on 64-bit archs
  * (N = number of input arguments + output arguments).  */
 #define MAX_OPC_PARAM         (4 + (MAX_OPC_PARAM_PER_ARG * MAX_OPC_PARAM_ARGS))
+
+/* Initial size of the op buffers, in ops. They grow at instruction
+   boundaries, see tcg_op_buf_reserve. */
 #define OPC_BUF_SIZE          640
-#define OPC_MAX_SIZE          (OPC_BUF_SIZE - MAX_OP_PER_INSTR)
 
 /* Maximum size a TCG op can expand to.  This is complicated because a
    single op may require several host instructions and register reloads.
@@ -44,6 +46,4 @@ extern unsigned int sizeof_CPUTLBEntry;
    a couple of fixup instructions per argument.  */
 #define TCG_MAX_OP_SIZE       192
 
-#define OPPARAM_BUF_SIZE      (OPC_BUF_SIZE * MAX_OPC_PARAM)
-
 #endif
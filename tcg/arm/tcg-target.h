@@ -77,6 +77,13 @@ typedef enum {
 #define TCG_TARGET_HAS_nor_i32       0
 #define TCG_TARGET_HAS_deposit_i32   0
 #define TCG_TARGET_HAS_muls2_i32     1
+#define TCG_TARGET_HAS_movcond_i32   0
+#define TCG_TARGET_HAS_clz_i32       0
+#define TCG_TARGET_HAS_ctz_i32       0
+#define TCG_TARGET_HAS_ctpop_i32     0
+#define TCG_TARGET_HAS_extract_i32   0
+#define TCG_TARGET_HAS_sextract_i32  0
+#define TCG_TARGET_HAS_mb            0
 
 #define TCG_TARGET_HAS_GUEST_BASE
 
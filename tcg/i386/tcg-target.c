@@ -22,6 +22,8 @@
  * THE SOFTWARE.
  */
 
+#include <cpuid.h>
+
 /* *INDENT-OFF* */
 static const int tcg_target_reg_alloc_order[] = {
 #if TCG_TARGET_REG_BITS == 64
@@ -40,6 +42,22 @@ static const int tcg_target_reg_alloc_order[] = {
     TCG_REG_RSI,
     TCG_REG_RDI,
     TCG_REG_RAX,
+    TCG_REG_XMM0,
+    TCG_REG_XMM1,
+    TCG_REG_XMM2,
+    TCG_REG_XMM3,
+    TCG_REG_XMM4,
+    TCG_REG_XMM5,
+    TCG_REG_XMM6,
+    TCG_REG_XMM7,
+    TCG_REG_XMM8,
+    TCG_REG_XMM9,
+    TCG_REG_XMM10,
+    TCG_REG_XMM11,
+    TCG_REG_XMM12,
+    TCG_REG_XMM13,
+    TCG_REG_XMM14,
+    TCG_REG_XMM15,
 #else
     TCG_REG_EBX,
     TCG_REG_ESI,
@@ -82,19 +100,36 @@ static const int tcg_target_call_oarg_regs[] = {
 
 static uint8_t *tb_ret_addr;
 
+bool have_popcnt;
+bool have_bmi1;
+static bool have_bmi2;
+static bool have_lzcnt;
+static bool have_movbe;
+static bool have_sse41;
+static bool have_sse42;
+static bool have_avx1;
+bool have_avx2;
+
+#if defined(_WIN64)
+/* xmm6 to xmm15 are callee saved and the prologue does not save them */
+#define ALL_VECTOR_REGS 0x003f0000u
+#else
+#define ALL_VECTOR_REGS 0xffff0000u
+#endif
+
 static void patch_reloc(uint8_t *code_ptr, int type, tcg_target_long value, tcg_target_long addend)
 {
     value += addend;
     switch (type) {
     case R_386_PC32:
-        value -= (uintptr_t)code_ptr;
+        value -= (uintptr_t)tcg_code_rx(code_ptr);
         if (value != (int32_t)value) {
             tcg_abort();
         }
         *(uint32_t *)code_ptr = value;
         break;
     case R_386_PC8:
-        value -= (uintptr_t)code_ptr;
+        value -= (uintptr_t)tcg_code_rx(code_ptr);
         if (value != (int8_t)value) {
             tcg_abort();
         }
@@ -201,6 +236,18 @@ static int target_parse_constraint(TCGArgConstraint *ct, const char **pct_str)
     case 'Z':
         ct->ct |= TCG_CT_CONST_U32;
         break;
+    case 'W':
+        ct->ct |= TCG_CT_CONST_WSZ;
+        break;
+
+    /* vector registers and the dup_vec constants */
+    case 'x':
+        ct->ct |= TCG_CT_REG;
+        tcg_regset_set32(ct->u.regs, 0, ALL_VECTOR_REGS);
+        break;
+    case 'M':
+        ct->ct |= TCG_CT_CONST_VDUP;
+        break;
 
     default:
         return -1;
@@ -223,6 +270,14 @@ static inline int tcg_target_const_match(tcg_target_long val, const TCGArgConstr
     if ((ct & TCG_CT_CONST_U32) && val == (uint32_t)val) {
         return 1;
     }
+    /* the operation width, which is not known here; see tcg_out_bitcount */
+    if ((ct & TCG_CT_CONST_WSZ) && (val == 32 || val == 64)) {
+        return 1;
+    }
+    /* all zeros or all ones, built without a general register */
+    if ((ct & TCG_CT_CONST_VDUP) && (val == 0 || val == -1)) {
+        return 1;
+    }
     return 0;
 }
 
@@ -234,6 +289,11 @@ static inline int tcg_target_const_match(tcg_target_long val, const TCGArgConstr
 
 #define P_EXT           0x100           /* 0x0f opcode prefix */
 #define P_DATA16        0x200           /* 0x66 opcode prefix */
+#define P_SIMDF3        0x4000          /* 0xf3 opcode prefix */
+#define P_EXT38         0x8000          /* 0x0f 0x38 opcode prefix */
+#define P_SIMDF2        0x10000         /* 0xf2 opcode prefix */
+#define P_EXT3A         0x20000         /* 0x0f 0x3a opcode prefix, VEX only */
+#define P_VEXL          0x40000         /* Set VEX.L = 1, VEX only */
 #if TCG_TARGET_REG_BITS == 64
 # define P_ADDR32       0x400           /* 0x67 opcode prefix */
 # define P_REXW         0x800           /* Set REX.W = 1 */
@@ -250,8 +310,12 @@ static inline int tcg_target_const_match(tcg_target_long val, const TCGArgConstr
 #define OPC_ARITH_EvIb  (0x83)
 #define OPC_ARITH_GvEv  (0x03)          /* ... plus (ARITH_FOO << 3) */
 #define OPC_ADD_GvEv    (OPC_ARITH_GvEv | (ARITH_ADD << 3))
+#define OPC_ANDN        (0xf2 | P_EXT38)
+#define OPC_BSF         (0xbc | P_EXT)
+#define OPC_BSR         (0xbd | P_EXT)
 #define OPC_BSWAP       (0xc8 | P_EXT)
 #define OPC_CALL_Jz     (0xe8)
+#define OPC_CMOVCC      (0x40 | P_EXT)  /* ... plus condition code */
 #define OPC_CMP_GvEv    (OPC_ARITH_GvEv | (ARITH_CMP << 3))
 #define OPC_DEC_r32     (0x48)
 #define OPC_IMUL_GvEv   (0xaf | P_EXT)
@@ -263,6 +327,9 @@ static inline int tcg_target_const_match(tcg_target_long val, const TCGArgConstr
 #define OPC_JMP_long    (0xe9)
 #define OPC_JMP_short   (0xeb)
 #define OPC_LEA         (0x8d)
+#define OPC_LZCNT       (0xbd | P_EXT | P_SIMDF3)
+#define OPC_MOVBE_GyMy  (0xf0 | P_EXT38)
+#define OPC_MOVBE_MyGy  (0xf1 | P_EXT38)
 #define OPC_MOVB_EvGv   (0x88)          /* stores, more or less */
 #define OPC_MOVL_EvGv   (0x89)          /* stores, more or less */
 #define OPC_MOVL_GvEv   (0x8b)          /* loads, more or less */
@@ -273,18 +340,66 @@ static inline int tcg_target_const_match(tcg_target_long val, const TCGArgConstr
 #define OPC_MOVSLQ      (0x63 | P_REXW)
 #define OPC_MOVZBL      (0xb6 | P_EXT)
 #define OPC_MOVZWL      (0xb7 | P_EXT)
+#define OPC_POPCNT      (0xb8 | P_EXT | P_SIMDF3)
 #define OPC_POP_r32     (0x58)
 #define OPC_PUSH_r32    (0x50)
 #define OPC_PUSH_Iv     (0x68)
 #define OPC_PUSH_Ib     (0x6a)
 #define OPC_RET         (0xc3)
+#define OPC_RORX        (0xf0 | P_EXT3A | P_SIMDF2)
+#define OPC_SARX        (0xf7 | P_EXT38 | P_SIMDF3)
 #define OPC_SETCC       (0x90 | P_EXT | P_REXB_RM) /* ... plus cc */
 #define OPC_SHIFT_1     (0xd1)
 #define OPC_SHIFT_Ib    (0xc1)
 #define OPC_SHIFT_cl    (0xd3)
+#define OPC_SHLX        (0xf7 | P_EXT38 | P_DATA16)
+#define OPC_SHRX        (0xf7 | P_EXT38 | P_SIMDF2)
 #define OPC_TESTL       (0x85)
+#define OPC_TZCNT       (0xbc | P_EXT | P_SIMDF3)
 #define OPC_XCHG_ax_r32 (0x90)
 
+/* SSE2, SSE4 and AVX2 vector instructions */
+#define OPC_MOVD_VyEy   (0x6e | P_EXT | P_DATA16)
+#define OPC_MOVDQA_VxWx (0x6f | P_EXT | P_DATA16)
+#define OPC_MOVDQU_VxWx (0x6f | P_EXT | P_SIMDF3)
+#define OPC_MOVDQU_WxVx (0x7f | P_EXT | P_SIMDF3)
+#define OPC_MOVQ_VqWq   (0x7e | P_EXT | P_SIMDF3)
+#define OPC_MOVQ_WqVq   (0xd6 | P_EXT | P_DATA16)
+#define OPC_PADDB       (0xfc | P_EXT | P_DATA16)
+#define OPC_PADDW       (0xfd | P_EXT | P_DATA16)
+#define OPC_PADDD       (0xfe | P_EXT | P_DATA16)
+#define OPC_PADDQ       (0xd4 | P_EXT | P_DATA16)
+#define OPC_PAND        (0xdb | P_EXT | P_DATA16)
+#define OPC_PANDN       (0xdf | P_EXT | P_DATA16)
+#define OPC_PCMPEQB     (0x74 | P_EXT | P_DATA16)
+#define OPC_PCMPEQW     (0x75 | P_EXT | P_DATA16)
+#define OPC_PCMPEQD     (0x76 | P_EXT | P_DATA16)
+#define OPC_PCMPEQQ     (0x29 | P_EXT38 | P_DATA16)
+#define OPC_PCMPGTB     (0x64 | P_EXT | P_DATA16)
+#define OPC_PCMPGTW     (0x65 | P_EXT | P_DATA16)
+#define OPC_PCMPGTD     (0x66 | P_EXT | P_DATA16)
+#define OPC_PCMPGTQ     (0x37 | P_EXT38 | P_DATA16)
+#define OPC_PMULLW      (0xd5 | P_EXT | P_DATA16)
+#define OPC_PMULLD      (0x40 | P_EXT38 | P_DATA16)
+#define OPC_POR         (0xeb | P_EXT | P_DATA16)
+#define OPC_PSHIFTW_Ib  (0x71 | P_EXT | P_DATA16) /* /2 shr, /4 sar, /6 shl */
+#define OPC_PSHIFTD_Ib  (0x72 | P_EXT | P_DATA16) /* /2 shr, /4 sar, /6 shl */
+#define OPC_PSHIFTQ_Ib  (0x73 | P_EXT | P_DATA16) /* /2 shr, /6 shl */
+#define OPC_PSHUFD      (0x70 | P_EXT | P_DATA16)
+#define OPC_PSHUFLW     (0x70 | P_EXT | P_SIMDF2)
+#define OPC_PSUBB       (0xf8 | P_EXT | P_DATA16)
+#define OPC_PSUBW       (0xf9 | P_EXT | P_DATA16)
+#define OPC_PSUBD       (0xfa | P_EXT | P_DATA16)
+#define OPC_PSUBQ       (0xfb | P_EXT | P_DATA16)
+#define OPC_PUNPCKLBW   (0x60 | P_EXT | P_DATA16)
+#define OPC_PUNPCKLQDQ  (0x6c | P_EXT | P_DATA16)
+#define OPC_PXOR        (0xef | P_EXT | P_DATA16)
+#define OPC_VPBROADCASTB (0x78 | P_EXT38 | P_DATA16)
+#define OPC_VPBROADCASTW (0x79 | P_EXT38 | P_DATA16)
+#define OPC_VPBROADCASTD (0x58 | P_EXT38 | P_DATA16)
+#define OPC_VPBROADCASTQ (0x59 | P_EXT38 | P_DATA16)
+#define OPC_VZEROUPPER  (0x77 | P_EXT)
+
 #define OPC_GRP3_Ev     (0xf7)
 #define OPC_GRP5        (0xff)
 
@@ -350,13 +465,19 @@ static void tcg_out_opc(TCGContext *s, int opc, int r, int rm, int x)
     int rex;
 
     if (opc & P_DATA16) {
-        /* We should never be asking for both 16 and 64-bit operation.  */
-        assert((opc & P_REXW) == 0);
+        /* We should never be asking for both 16 and 64-bit operation,
+           except for the SSE moves between xmm and 64-bit registers.  */
+        assert((opc & P_REXW) == 0 || (opc & P_EXT));
         tcg_out8(s, 0x66);
     }
     if (opc & P_ADDR32) {
         tcg_out8(s, 0x67);
     }
+    if (opc & P_SIMDF3) {
+        tcg_out8(s, 0xf3);
+    } else if (opc & P_SIMDF2) {
+        tcg_out8(s, 0xf2);
+    }
     rex = 0;
     rex |= (opc & P_REXW) >> 8;         /* REX.W */
     rex |= (r & 8) >> 1;                /* REX.R */
@@ -375,8 +496,11 @@ static void tcg_out_opc(TCGContext *s, int opc, int r, int rm, int x)
         tcg_out8(s, (uint8_t)(rex | 0x40));
     }
 
-    if (opc & P_EXT) {
+    if (opc & (P_EXT | P_EXT38)) {
         tcg_out8(s, 0x0f);
+        if (opc & P_EXT38) {
+            tcg_out8(s, 0x38);
+        }
     }
     tcg_out8(s, opc);
 }
@@ -386,8 +510,16 @@ static void tcg_out_opc(TCGContext *s, int opc)
     if (opc & P_DATA16) {
         tcg_out8(s, 0x66);
     }
-    if (opc & P_EXT) {
+    if (opc & P_SIMDF3) {
+        tcg_out8(s, 0xf3);
+    } else if (opc & P_SIMDF2) {
+        tcg_out8(s, 0xf2);
+    }
+    if (opc & (P_EXT | P_EXT38)) {
         tcg_out8(s, 0x0f);
+        if (opc & P_EXT38) {
+            tcg_out8(s, 0x38);
+        }
     }
     tcg_out8(s, opc);
 }
@@ -403,6 +535,101 @@ static void tcg_out_modrm(TCGContext *s, int opc, int r, int rm)
     tcg_out8(s, 0xc0 | (LOWREGMASK(r) << 3) | LOWREGMASK(rm));
 }
 
+/* Output the VEX prefix and the opcode of an operation with the extra
+   source operand 'v'; 'v' is 0 when the operation has none.  The two
+   byte form is used when the operation lives in the 0x0f map and needs
+   none of VEX.W, VEX.X and VEX.B.  */
+static void tcg_out_vex_opc(TCGContext *s, int opc, int r, int v, int rm, int index)
+{
+    int tmp;
+
+    if ((opc & (P_EXT | P_EXT38 | P_EXT3A | P_REXW)) == P_EXT && ((rm | index) & 8) == 0) {
+        tcg_out8(s, 0xc5);
+        tmp = (r & 8 ? 0 : 0x80);                           /* VEX.R */
+    } else {
+        tcg_out8(s, 0xc4);
+        tmp = (opc & P_EXT3A) ? 3 : (opc & P_EXT38) ? 2 : 1;  /* VEX.m-mmmm */
+        tmp |= (r & 8 ? 0 : 0x80);                          /* VEX.R */
+        tmp |= (index & 8 ? 0 : 0x40);                      /* VEX.X */
+        tmp |= (rm & 8 ? 0 : 0x20);                         /* VEX.B */
+        tcg_out8(s, tmp);
+        tmp = (opc & P_REXW ? 0x80 : 0);                    /* VEX.W */
+    }
+
+    tmp |= (opc & P_VEXL ? 0x04 : 0);                       /* VEX.L */
+    if (opc & P_DATA16) {                                   /* VEX.pp */
+        tmp |= 1;
+    } else if (opc & P_SIMDF3) {
+        tmp |= 2;
+    } else if (opc & P_SIMDF2) {
+        tmp |= 3;
+    }
+    tmp |= (~v & 15) << 3;                                  /* VEX.vvvv */
+    tcg_out8(s, tmp);
+    tcg_out8(s, opc);
+}
+
+/* Output a VEX encoded register to register operation */
+static void tcg_out_vex_modrm(TCGContext *s, int opc, int r, int v, int rm)
+{
+    tcg_out_vex_opc(s, opc, r, v, rm, 0);
+    tcg_out8(s, 0xc0 | (LOWREGMASK(r) << 3) | LOWREGMASK(rm));
+}
+
+/* Output the MODRM byte, the SIB byte and the displacement addressing
+   "rm + (index<<shift) + offset", after the opcode.  At most one of RM
+   and INDEX is missing.  */
+static void tcg_out_sib_offset(TCGContext *s, int r, int rm, int index, int shift, tcg_target_long offset)
+{
+    int mod, len;
+
+    /* Find the length of the immediate addend.  Note that the encoding
+       that would be used for (%ebp) indicates absolute addressing.  */
+    if (rm < 0) {
+        mod = 0, len = 4, rm = 5;
+    } else if (offset == 0 && LOWREGMASK(rm) != TCG_REG_EBP) {
+        mod = 0, len = 0;
+    } else if (offset == (int8_t)offset) {
+        mod = 0x40, len = 1;
+    } else {
+        mod = 0x80, len = 4;
+    }
+
+    /* Use a single byte MODRM format if possible.  Note that the encoding
+       that would be used for %esp is the escape to the two byte form.  */
+    if (index < 0 && LOWREGMASK(rm) != TCG_REG_ESP) {
+        /* Single byte MODRM format.  */
+        tcg_out8(s, mod | (LOWREGMASK(r) << 3) | LOWREGMASK(rm));
+    } else {
+        /* Two byte MODRM+SIB format.  */
+
+        /* Note that the encoding that would place %esp into the index
+           field indicates no index register.  In 64-bit mode, the REX.X
+           bit counts, so %r12 can be used as the index.  */
+        if (index < 0) {
+            index = 4;
+        } else {
+            assert(index != TCG_REG_ESP);
+        }
+
+        tcg_out8(s, mod | (LOWREGMASK(r) << 3) | 4);
+        tcg_out8(s, (shift << 6) | (LOWREGMASK(index) << 3) | LOWREGMASK(rm));
+    }
+
+    if (len == 1) {
+        tcg_out8(s, offset);
+    } else if (len == 4) {
+        tcg_out32(s, offset);
+    }
+}
+
+/* Output a VEX encoded operation with a "rm + offset" memory operand */
+static void tcg_out_vex_modrm_offset(TCGContext *s, int opc, int r, int v, int rm, tcg_target_long offset)
+{
+    tcg_out_vex_opc(s, opc, r, v, rm, 0);
+    tcg_out_sib_offset(s, r, rm, -1, 0, offset);
+}
+
 /* Output an opcode with a full "rm + (index<<shift) + offset" address mode.
    We handle either RM and INDEX missing with a negative value.  In 64-bit
    mode for absolute addresses, ~RM is the size of the immediate operand
@@ -410,13 +637,12 @@ static void tcg_out_modrm(TCGContext *s, int opc, int r, int rm)
 
 static void tcg_out_modrm_sib_offset(TCGContext *s, int opc, int r, int rm, int index, int shift, tcg_target_long offset)
 {
-    int mod, len;
 
     if (index < 0 && rm < 0) {
         if (TCG_TARGET_REG_BITS == 64) {
             /* Try for a rip-relative addressing mode.  This has replaced
                the 32-bit-mode absolute addressing encoding.  */
-            tcg_target_long pc = (tcg_target_long)s->code_ptr + 5 + ~rm;
+            tcg_target_long pc = (tcg_target_long)tcg_code_rx(s->code_ptr) + 5 + ~rm;
             tcg_target_long disp = offset - pc;
             if (disp == (int32_t)disp) {
                 tcg_out_opc(s, opc, r, 0, 0);
@@ -447,52 +673,53 @@ static void tcg_out_modrm_sib_offset(TCGContext *s, int opc, int r, int rm, int
         }
     }
 
-    /* Find the length of the immediate addend.  Note that the encoding
-       that would be used for (%ebp) indicates absolute addressing.  */
-    if (rm < 0) {
-        mod = 0, len = 4, rm = 5;
-    } else if (offset == 0 && LOWREGMASK(rm) != TCG_REG_EBP) {
-        mod = 0, len = 0;
-    } else if (offset == (int8_t)offset) {
-        mod = 0x40, len = 1;
-    } else {
-        mod = 0x80, len = 4;
-    }
-
-    /* Use a single byte MODRM format if possible.  Note that the encoding
-       that would be used for %esp is the escape to the two byte form.  */
+    /* The REX prefix takes the registers of the MODRM and SIB bytes
+       computed in tcg_out_sib_offset.  */
     if (index < 0 && LOWREGMASK(rm) != TCG_REG_ESP) {
-        /* Single byte MODRM format.  */
         tcg_out_opc(s, opc, r, rm, 0);
-        tcg_out8(s, mod | (LOWREGMASK(r) << 3) | LOWREGMASK(rm));
     } else {
-        /* Two byte MODRM+SIB format.  */
+        tcg_out_opc(s, opc, r, rm < 0 ? 5 : rm, index < 0 ? 4 : index);
+    }
+    tcg_out_sib_offset(s, r, rm, index, shift, offset);
+}
 
-        /* Note that the encoding that would place %esp into the index
-           field indicates no index register.  In 64-bit mode, the REX.X
-           bit counts, so %r12 can be used as the index.  */
-        if (index < 0) {
-            index = 4;
-        } else {
-            assert(index != TCG_REG_ESP);
-        }
+/* A simplification of the above with no index or shift.  */
+static inline void tcg_out_modrm_offset(TCGContext *s, int opc, int r, int rm, tcg_target_long offset)
+{
+    tcg_out_modrm_sib_offset(s, opc, r, rm, -1, 0, offset);
+}
 
-        tcg_out_opc(s, opc, r, rm, index);
-        tcg_out8(s, mod | (LOWREGMASK(r) << 3) | 4);
-        tcg_out8(s, (shift << 6) | (LOWREGMASK(index) << 3) | LOWREGMASK(rm));
+/* Output a vector operation, in the VEX encoding when the host has AVX.
+   The legacy SSE encoding overwrites its first source, so without AVX
+   the constraints make 'v' either 'r' or 0 for operations with a single
+   source.  */
+static void tcg_out_vec_modrm(TCGContext *s, int opc, int r, int v, int rm)
+{
+    if (have_avx1) {
+        tcg_out_vex_modrm(s, opc, r, v, rm);
+    } else {
+        assert(v == 0 || v == r);
+        tcg_out_modrm(s, opc, r, rm);
     }
+}
 
-    if (len == 1) {
-        tcg_out8(s, offset);
-    } else if (len == 4) {
-        tcg_out32(s, offset);
+static void tcg_out_vec_modrm_offset(TCGContext *s, int opc, int r, int rm, tcg_target_long offset)
+{
+    if (have_avx1) {
+        tcg_out_vex_modrm_offset(s, opc, r, 0, rm, offset);
+    } else {
+        tcg_out_modrm_offset(s, opc, r, rm, offset);
     }
 }
 
-/* A simplification of the above with no index or shift.  */
-static inline void tcg_out_modrm_offset(TCGContext *s, int opc, int r, int rm, tcg_target_long offset)
+/* Clear the upper halves of the ymm registers once the block used them,
+   before leaving it or calling out: the C code may use the legacy SSE
+   encoding, which is slowed down by dirty upper halves.  */
+static void tcg_out_vzeroupper(TCGContext *s)
 {
-    tcg_out_modrm_sib_offset(s, opc, r, rm, -1, 0, offset);
+    if (s->vec_256_used) {
+        tcg_out_vex_opc(s, OPC_VZEROUPPER, 0, 0, 0, 0);
+    }
 }
 
 /* Generate dest op= src.  Uses the same ARITH_* codes as tgen_arithi.  */
@@ -507,9 +734,20 @@ static inline void tgen_arithr(TCGContext *s, int subop, int dest, int src)
 
 static inline void tcg_out_mov(TCGContext *s, TCGType type, TCGReg ret, TCGReg arg)
 {
-    if (arg != ret) {
-        int opc = OPC_MOVL_GvEv + (type == TCG_TYPE_I64 ? P_REXW : 0);
-        tcg_out_modrm(s, opc, ret, arg);
+    if (arg == ret) {
+        return;
+    }
+    switch (type) {
+    case TCG_TYPE_V64:
+    case TCG_TYPE_V128:
+        tcg_out_vec_modrm(s, OPC_MOVDQA_VxWx, ret, 0, arg);
+        break;
+    case TCG_TYPE_V256:
+        tcg_out_vex_modrm(s, OPC_MOVDQA_VxWx | P_VEXL, ret, 0, arg);
+        break;
+    default:
+        tcg_out_modrm(s, OPC_MOVL_GvEv + (type == TCG_TYPE_I64 ? P_REXW : 0), ret, arg);
+        break;
     }
 }
 
@@ -554,16 +792,41 @@ static inline void tcg_out_pop(TCGContext *s, int reg)
     tcg_out_opc(s, OPC_POP_r32 + LOWREGMASK(reg), 0, reg, 0);
 }
 
+/* Vector memory operands need not be aligned */
 static inline void tcg_out_ld(TCGContext *s, TCGType type, TCGReg ret, TCGReg arg1, tcg_target_long arg2)
 {
-    int opc = OPC_MOVL_GvEv + (type == TCG_TYPE_I64 ? P_REXW : 0);
-    tcg_out_modrm_offset(s, opc, ret, arg1, arg2);
+    switch (type) {
+    case TCG_TYPE_V64:
+        tcg_out_vec_modrm_offset(s, OPC_MOVQ_VqWq, ret, arg1, arg2);
+        break;
+    case TCG_TYPE_V128:
+        tcg_out_vec_modrm_offset(s, OPC_MOVDQU_VxWx, ret, arg1, arg2);
+        break;
+    case TCG_TYPE_V256:
+        tcg_out_vex_modrm_offset(s, OPC_MOVDQU_VxWx | P_VEXL, ret, 0, arg1, arg2);
+        break;
+    default:
+        tcg_out_modrm_offset(s, OPC_MOVL_GvEv + (type == TCG_TYPE_I64 ? P_REXW : 0), ret, arg1, arg2);
+        break;
+    }
 }
 
 static inline void tcg_out_st(TCGContext *s, TCGType type, TCGReg arg, TCGReg arg1, tcg_target_long arg2)
 {
-    int opc = OPC_MOVL_EvGv + (type == TCG_TYPE_I64 ? P_REXW : 0);
-    tcg_out_modrm_offset(s, opc, arg, arg1, arg2);
+    switch (type) {
+    case TCG_TYPE_V64:
+        tcg_out_vec_modrm_offset(s, OPC_MOVQ_WqVq, arg, arg1, arg2);
+        break;
+    case TCG_TYPE_V128:
+        tcg_out_vec_modrm_offset(s, OPC_MOVDQU_WxVx, arg, arg1, arg2);
+        break;
+    case TCG_TYPE_V256:
+        tcg_out_vex_modrm_offset(s, OPC_MOVDQU_WxVx | P_VEXL, arg, 0, arg1, arg2);
+        break;
+    default:
+        tcg_out_modrm_offset(s, OPC_MOVL_EvGv + (type == TCG_TYPE_I64 ? P_REXW : 0), arg, arg1, arg2);
+        break;
+    }
 }
 
 static void tcg_out_shifti(TCGContext *s, int subopc, int reg, int count)
@@ -705,7 +968,7 @@ static void tcg_out_jxx(TCGContext *s, int opc, int label_index, int small)
     TCGLabel *l = &s->labels[label_index];
 
     if (l->has_value) {
-        val = l->u.value - (tcg_target_long)s->code_ptr;
+        val = l->u.value - (tcg_target_long)tcg_code_rx(s->code_ptr);
         val1 = val - 2;
         if ((int8_t)val1 == val1) {
             if (opc == -1) {
@@ -830,7 +1093,7 @@ static void tcg_out_brcond2(TCGContext *s, const TCGArg *args, const int *const_
     default:
         tcg_abort();
     }
-    tcg_out_label(s, label_next, (tcg_target_long)s->code_ptr);
+    tcg_out_label(s, label_next, (tcg_target_long)tcg_code_rx(s->code_ptr));
 }
 #endif
 
@@ -868,10 +1131,10 @@ static void tcg_out_setcond2(TCGContext *s, const TCGArg *args, const int *const
 
         tcg_out_movi(s, TCG_TYPE_I32, args[0], 0);
         tcg_out_jxx(s, JCC_JMP, label_over, 1);
-        tcg_out_label(s, label_true, (tcg_target_long)s->code_ptr);
+        tcg_out_label(s, label_true, (tcg_target_long)tcg_code_rx(s->code_ptr));
 
         tcg_out_movi(s, TCG_TYPE_I32, args[0], 1);
-        tcg_out_label(s, label_over, (tcg_target_long)s->code_ptr);
+        tcg_out_label(s, label_over, (tcg_target_long)tcg_code_rx(s->code_ptr));
     } else {
         /* When the destination does not overlap one of the arguments,
            clear the destination first, jump if cond false, and emit an
@@ -885,14 +1148,151 @@ static void tcg_out_setcond2(TCGContext *s, const TCGArg *args, const int *const
         tcg_out_brcond2(s, new_args, const_args + 1, 1);
 
         tgen_arithi(s, ARITH_ADD, args[0], 1, 0);
-        tcg_out_label(s, label_over, (tcg_target_long)s->code_ptr);
+        tcg_out_label(s, label_over, (tcg_target_long)tcg_code_rx(s->code_ptr));
     }
 }
 #endif
 
+static void tcg_out_movcond(TCGContext *s, TCGCond cond, TCGArg dest, TCGArg c1, TCGArg c2, int const_c2, TCGArg v1,
+                            int rexw)
+{
+    tcg_out_cmp(s, c1, c2, const_c2, rexw);
+    tcg_out_modrm(s, OPC_CMOVCC | tcg_cond_to_jcc[cond] | rexw, dest, v1);
+}
+
+/* lzcnt and tzcnt give the operand width for zero and set CF, so
+   'arg2' only needs selecting when it is something else. */
+static void tcg_out_bitcount(TCGContext *s, int opc, TCGArg dest, TCGArg arg1, TCGArg arg2, int const_arg2, int rexw)
+{
+    int bits = rexw ? 64 : 32;
+    int label_over;
+
+    if (const_arg2 && arg2 == bits) {
+        tcg_out_modrm(s, opc + rexw, dest, arg1);
+    } else if (!const_arg2 && arg2 != dest) {
+        tcg_out_modrm(s, opc + rexw, dest, arg1);
+        tcg_out_modrm(s, OPC_CMOVCC | JCC_JB | rexw, dest, arg2);
+    } else if (const_arg2) {
+        label_over = gen_new_label();
+        tcg_out_modrm(s, opc + rexw, dest, arg1);
+        tcg_out_jxx(s, JCC_JAE, label_over, 1);
+        tcg_out_movi(s, rexw ? TCG_TYPE_I64 : TCG_TYPE_I32, dest, arg2);
+        tcg_out_label(s, label_over, (tcg_target_long)tcg_code_rx(s->code_ptr));
+    } else {
+        /* the destination already holds the result for zero */
+        label_over = gen_new_label();
+        tcg_out_cmp(s, arg1, 0, 1, rexw);
+        tcg_out_jxx(s, JCC_JE, label_over, 1);
+        tcg_out_modrm(s, opc + rexw, dest, arg1);
+        tcg_out_label(s, label_over, (tcg_target_long)tcg_code_rx(s->code_ptr));
+    }
+}
+
+/* The destination is the counted value and 'arg2' is the result for
+   zero. bsf and bsr leave the destination undefined for zero but set
+   ZF, which selects 'arg2'. */
+static void tcg_out_clz(TCGContext *s, TCGArg dest, TCGArg arg1, TCGArg arg2, int const_arg2, int rexw)
+{
+    int bits = rexw ? 64 : 32;
+    int label_zero;
+
+    if (have_lzcnt) {
+        tcg_out_bitcount(s, OPC_LZCNT, dest, arg1, arg2, const_arg2, rexw);
+        return;
+    }
+    if (arg2 == dest) {
+        /* both inputs are the same temp, zero is its own count */
+        label_zero = gen_new_label();
+        tcg_out_cmp(s, dest, 0, 1, rexw);
+        tcg_out_jxx(s, JCC_JE, label_zero, 1);
+        tcg_out_modrm(s, OPC_BSR + rexw, dest, dest);
+        tcg_out_modrm(s, OPC_GRP3_Ev + rexw, EXT3_NOT, dest);
+        tcg_out_modrm_offset(s, OPC_LEA + rexw, dest, dest, bits);
+        tcg_out_label(s, label_zero, (tcg_target_long)tcg_code_rx(s->code_ptr));
+        return;
+    }
+    /* bits - 1 - index, as ~index + bits, which keeps the flags */
+    tcg_out_modrm(s, OPC_BSR + rexw, dest, dest);
+    tcg_out_modrm(s, OPC_GRP3_Ev + rexw, EXT3_NOT, dest);
+    tcg_out_modrm_offset(s, OPC_LEA + rexw, dest, dest, bits);
+    tcg_out_modrm(s, OPC_CMOVCC | JCC_JE | rexw, dest, arg2);
+}
+
+static void tcg_out_ctz(TCGContext *s, TCGArg dest, TCGArg arg1, TCGArg arg2, int const_arg2, int rexw)
+{
+    int label_zero;
+
+    if (have_bmi1) {
+        tcg_out_bitcount(s, OPC_TZCNT, dest, arg1, arg2, const_arg2, rexw);
+        return;
+    }
+    if (arg2 == dest) {
+        label_zero = gen_new_label();
+        tcg_out_cmp(s, dest, 0, 1, rexw);
+        tcg_out_jxx(s, JCC_JE, label_zero, 1);
+        tcg_out_modrm(s, OPC_BSF + rexw, dest, dest);
+        tcg_out_label(s, label_zero, (tcg_target_long)tcg_code_rx(s->code_ptr));
+        return;
+    }
+    tcg_out_modrm(s, OPC_BSF + rexw, dest, dest);
+    tcg_out_modrm(s, OPC_CMOVCC | JCC_JE | rexw, dest, arg2);
+}
+
+static void tcg_out_extract(TCGContext *s, TCGArg dest, TCGArg arg, int ofs, int len, int sign, int rexw)
+{
+    int bits = rexw ? 64 : 32;
+
+    if (ofs == 0 && len == 8 && (TCG_TARGET_REG_BITS == 64 || arg < 4)) {
+        if (sign) {
+            tcg_out_ext8s(s, dest, arg, rexw);
+        } else {
+            tcg_out_ext8u(s, dest, arg);
+        }
+        return;
+    }
+    if (ofs == 0 && len == 16) {
+        if (sign) {
+            tcg_out_ext16s(s, dest, arg, rexw);
+        } else {
+            tcg_out_ext16u(s, dest, arg);
+        }
+        return;
+    }
+#if TCG_TARGET_REG_BITS == 64
+    if (ofs == 0 && len == 32 && rexw) {
+        if (sign) {
+            tcg_out_ext32s(s, dest, arg);
+        } else {
+            tcg_out_ext32u(s, dest, arg);
+        }
+        return;
+    }
+#endif
+
+    tcg_out_mov(s, rexw ? TCG_TYPE_I64 : TCG_TYPE_I32, dest, arg);
+    if (ofs + len < bits) {
+        tcg_out_shifti(s, SHIFT_SHL + rexw, dest, bits - ofs - len);
+        tcg_out_shifti(s, (sign ? SHIFT_SAR : SHIFT_SHR) + rexw, dest, bits - len);
+    } else if (ofs != 0) {
+        tcg_out_shifti(s, (sign ? SHIFT_SAR : SHIFT_SHR) + rexw, dest, ofs);
+    }
+}
+
+static void tcg_out_mb(TCGContext *s, TCGArg a0)
+{
+    /* x86 reorders only stores followed by loads; a locked operation
+       orders them and, unlike mfence, exists on every host */
+    if (a0 & TCG_MO_ST_LD) {
+        /* lock orl $0, 0(%esp) */
+        tcg_out8(s, 0xf0);
+        tcg_out_modrm_offset(s, OPC_ARITH_EvIb, ARITH_OR, TCG_REG_ESP, 0);
+        tcg_out8(s, 0);
+    }
+}
+
 static void tcg_out_branch(TCGContext *s, int call, tcg_target_long dest)
 {
-    tcg_target_long disp = dest - (tcg_target_long)s->code_ptr - 5;
+    tcg_target_long disp = dest - (tcg_target_long)tcg_code_rx(s->code_ptr) - 5;
 
     if (disp == (int32_t)disp) {
         tcg_out_opc(s, call ? OPC_CALL_Jz : OPC_JMP_long, 0, 0, 0);
@@ -926,7 +1326,8 @@ static void tcg_out_jmp(TCGContext *s, tcg_target_long dest)
 
    Outputs:
    LABEL_PTRS is filled with 1 (32-bit addresses) or 2 (64-bit addresses)
-   positions of the displacements of forward jumps to the TLB miss case.
+   positions of the 32-bit displacements of forward jumps to the TLB miss
+   case, which is emitted after the block.
 
    First argument register is loaded with the low part of the address.
    In the TLB hit case, it has been adjusted as indicated by the TLB
@@ -965,19 +1366,19 @@ static inline void tcg_out_tlb_load(TCGContext *s, int addrlo_idx, int mem_index
 
     tcg_out_mov(s, type, r0, addrlo);
 
-    /* jne label1 */
-    tcg_out8(s, OPC_JCC_short + JCC_JNE);
+    /* jne slow_path */
+    tcg_out_opc(s, OPC_JCC_long + JCC_JNE, 0, 0, 0);
     label_ptr[0] = s->code_ptr;
-    s->code_ptr++;
+    s->code_ptr += 4;
 
     if (TARGET_LONG_BITS > TCG_TARGET_REG_BITS) {
         /* cmp 4(r1), addrhi */
         tcg_out_modrm_offset(s, OPC_CMP_GvEv, args[addrlo_idx + 1], r1, 4);
 
-        /* jne label1 */
-        tcg_out8(s, OPC_JCC_short + JCC_JNE);
+        /* jne slow_path */
+        tcg_out_opc(s, OPC_JCC_long + JCC_JNE, 0, 0, 0);
         label_ptr[1] = s->code_ptr;
-        s->code_ptr++;
+        s->code_ptr += 4;
     }
 
     /* TLB Hit.  */
@@ -994,6 +1395,10 @@ static void tcg_out_qemu_ld_direct(TCGContext *s, int datalo, int datahi, int ba
 #else
     const int bswap = 0;
 #endif
+    /* movbe swaps while loading */
+    const int movbe = bswap && have_movbe;
+    const int ld32 = movbe ? OPC_MOVBE_GyMy : OPC_MOVL_GvEv;
+
     switch (sizeop) {
     case 0:
         tcg_out_modrm_offset(s, OPC_MOVZBL, datalo, base, ofs);
@@ -1002,13 +1407,22 @@ static void tcg_out_qemu_ld_direct(TCGContext *s, int datalo, int datahi, int ba
         tcg_out_modrm_offset(s, OPC_MOVSBL + P_REXW, datalo, base, ofs);
         break;
     case 1:
+        if (movbe) {
+            /* there is no extending movbe, only the low half is written */
+            tcg_out_modrm_offset(s, OPC_MOVBE_GyMy + P_DATA16, datalo, base, ofs);
+            tcg_out_ext16u(s, datalo, datalo);
+            break;
+        }
         tcg_out_modrm_offset(s, OPC_MOVZWL, datalo, base, ofs);
         if (bswap) {
             tcg_out_rolw_8(s, datalo);
         }
         break;
     case 1 | 4:
-        if (bswap) {
+        if (movbe) {
+            tcg_out_modrm_offset(s, OPC_MOVBE_GyMy + P_DATA16, datalo, base, ofs);
+            tcg_out_modrm(s, OPC_MOVSWL + P_REXW, datalo, datalo);
+        } else if (bswap) {
             tcg_out_modrm_offset(s, OPC_MOVZWL, datalo, base, ofs);
             tcg_out_rolw_8(s, datalo);
             tcg_out_modrm(s, OPC_MOVSWL + P_REXW, datalo, datalo);
@@ -1017,16 +1431,18 @@ static void tcg_out_qemu_ld_direct(TCGContext *s, int datalo, int datahi, int ba
         }
         break;
     case 2:
-        tcg_out_ld(s, TCG_TYPE_I32, datalo, base, ofs);
-        if (bswap) {
+        tcg_out_modrm_offset(s, ld32, datalo, base, ofs);
+        if (bswap && !movbe) {
             tcg_out_bswap32(s, datalo);
         }
         break;
 #if TCG_TARGET_REG_BITS == 64
     case 2 | 4:
         if (bswap) {
-            tcg_out_ld(s, TCG_TYPE_I32, datalo, base, ofs);
-            tcg_out_bswap32(s, datalo);
+            tcg_out_modrm_offset(s, ld32, datalo, base, ofs);
+            if (!movbe) {
+                tcg_out_bswap32(s, datalo);
+            }
             tcg_out_ext32s(s, datalo, datalo);
         } else {
             tcg_out_modrm_offset(s, OPC_MOVSLQ, datalo, base, ofs);
@@ -1035,8 +1451,8 @@ static void tcg_out_qemu_ld_direct(TCGContext *s, int datalo, int datahi, int ba
 #endif
     case 3:
         if (TCG_TARGET_REG_BITS == 64) {
-            tcg_out_ld(s, TCG_TYPE_I64, datalo, base, ofs);
-            if (bswap) {
+            tcg_out_modrm_offset(s, ld32 + P_REXW, datalo, base, ofs);
+            if (bswap && !movbe) {
                 tcg_out_bswap64(s, datalo);
             }
         } else {
@@ -1046,13 +1462,13 @@ static void tcg_out_qemu_ld_direct(TCGContext *s, int datalo, int datahi, int ba
                 datahi = t;
             }
             if (base != datalo) {
-                tcg_out_ld(s, TCG_TYPE_I32, datalo, base, ofs);
-                tcg_out_ld(s, TCG_TYPE_I32, datahi, base, ofs + 4);
+                tcg_out_modrm_offset(s, ld32, datalo, base, ofs);
+                tcg_out_modrm_offset(s, ld32, datahi, base, ofs + 4);
             } else {
-                tcg_out_ld(s, TCG_TYPE_I32, datahi, base, ofs + 4);
-                tcg_out_ld(s, TCG_TYPE_I32, datalo, base, ofs);
+                tcg_out_modrm_offset(s, ld32, datahi, base, ofs + 4);
+                tcg_out_modrm_offset(s, ld32, datalo, base, ofs);
             }
-            if (bswap) {
+            if (bswap && !movbe) {
                 tcg_out_bswap32(s, datalo);
                 tcg_out_bswap32(s, datahi);
             }
@@ -1063,6 +1479,28 @@ static void tcg_out_qemu_ld_direct(TCGContext *s, int datalo, int datahi, int ba
     }
 }
 
+/* Record the TLB miss path of a guest memory access, which is emitted
+   by tcg_out_ldst_finalize after the block. */
+static void add_qemu_ldst_label(TCGContext *s, int is_ld, int opc, int datalo, int datahi, int addrhi, int mem_index,
+                                uint8_t **label_ptr)
+{
+    TCGLabelQemuLdst *l = tcg_malloc(sizeof(TCGLabelQemuLdst));
+
+    l->next = NULL;
+    l->is_ld = is_ld;
+    l->opc = opc;
+    l->datalo_reg = datalo;
+    l->datahi_reg = datahi;
+    l->addrhi_reg = addrhi;
+    l->mem_index = mem_index;
+    l->label_ptr[0] = label_ptr[0];
+    l->label_ptr[1] = label_ptr[1];
+    l->raddr = s->code_ptr;
+    l->op_index = s->current_op_index;
+    *s->ldst_labels_tail = l;
+    s->ldst_labels_tail = &l->next;
+}
+
 /* XXX: qemu_ld and qemu_st could be modified to clobber only EDX and
    EAX. It will be useful once fixed registers globals are less
    common. */
@@ -1070,8 +1508,8 @@ static void tcg_out_qemu_ld(TCGContext *s, const TCGArg *args, int opc)
 {
     int data_reg, data_reg2 = 0;
     int addrlo_idx;
-    int mem_index, s_bits, arg_idx;
-    uint8_t *label_ptr[3];
+    int mem_index, s_bits;
+    uint8_t *label_ptr[2];
 
     data_reg = args[0];
     addrlo_idx = 1;
@@ -1088,28 +1526,25 @@ static void tcg_out_qemu_ld(TCGContext *s, const TCGArg *args, int opc)
     /* TLB Hit.  */
     tcg_out_qemu_ld_direct(s, data_reg, data_reg2, tcg_target_call_iarg_regs[0], 0, opc);
 
-    /* jmp label2 */
-    tcg_out8(s, OPC_JMP_short);
-    label_ptr[2] = s->code_ptr;
-    s->code_ptr++;
-
-    /* TLB Miss.  */
+    add_qemu_ldst_label(s, 1, opc, data_reg, data_reg2, TARGET_LONG_BITS > TCG_TARGET_REG_BITS ? args[addrlo_idx + 1] : 0,
+                        mem_index, label_ptr);
+}
 
-    /* label1: */
-    *label_ptr[0] = s->code_ptr - label_ptr[0] - 1;
-    if (TARGET_LONG_BITS > TCG_TARGET_REG_BITS) {
-        *label_ptr[1] = s->code_ptr - label_ptr[1] - 1;
-    }
+static void tcg_out_qemu_ld_slow_path(TCGContext *s, TCGLabelQemuLdst *l)
+{
+    int opc = l->opc;
+    int data_reg = l->datalo_reg;
+    int data_reg2 = l->datahi_reg;
+    int arg_idx;
 
-    /* XXX: move that code at the end of the TB */
     /* The first argument is already loaded with addrlo.  */
     arg_idx = 1;
     if (TCG_TARGET_REG_BITS == 32 && TARGET_LONG_BITS == 64) {
-        tcg_out_mov(s, TCG_TYPE_I32, tcg_target_call_iarg_regs[arg_idx++], args[addrlo_idx + 1]);
+        tcg_out_mov(s, TCG_TYPE_I32, tcg_target_call_iarg_regs[arg_idx++], l->addrhi_reg);
     }
-    tcg_out_movi(s, TCG_TYPE_I32, tcg_target_call_iarg_regs[arg_idx], mem_index);
+    tcg_out_movi(s, TCG_TYPE_I32, tcg_target_call_iarg_regs[arg_idx], l->mem_index);
 
-    switch (s_bits) {
+    switch (opc & 3) {
     case 0:
         tcg_out_calli(s, (tcg_target_long)tcg->ldb);
         break;
@@ -1162,9 +1597,6 @@ static void tcg_out_qemu_ld(TCGContext *s, const TCGArg *args, int opc)
     default:
         tcg_abort();
     }
-
-    /* label2: */
-    *label_ptr[2] = s->code_ptr - label_ptr[2] - 1;
 }
 
 static void tcg_out_qemu_st_direct(TCGContext *s, int datalo, int datahi, int base, tcg_target_long ofs, int sizeop)
@@ -1180,6 +1612,29 @@ static void tcg_out_qemu_st_direct(TCGContext *s, int datalo, int datahi, int ba
        means that the second argument reg is definitely free here.  */
     int scratch = tcg_target_call_iarg_regs[1];
 
+    if (bswap && have_movbe && sizeop != 0) {
+        /* movbe swaps while storing and needs no scratch */
+        switch (sizeop) {
+        case 1:
+            tcg_out_modrm_offset(s, OPC_MOVBE_MyGy + P_DATA16, datalo, base, ofs);
+            break;
+        case 2:
+            tcg_out_modrm_offset(s, OPC_MOVBE_MyGy, datalo, base, ofs);
+            break;
+        case 3:
+            if (TCG_TARGET_REG_BITS == 64) {
+                tcg_out_modrm_offset(s, OPC_MOVBE_MyGy + P_REXW, datalo, base, ofs);
+            } else {
+                tcg_out_modrm_offset(s, OPC_MOVBE_MyGy, datahi, base, ofs);
+                tcg_out_modrm_offset(s, OPC_MOVBE_MyGy, datalo, base, ofs + 4);
+            }
+            break;
+        default:
+            tcg_abort();
+        }
+        return;
+    }
+
     switch (sizeop) {
     case 0:
         tcg_out_modrm_offset(s, OPC_MOVB_EvGv + P_REXB_R, datalo, base, ofs);
@@ -1230,8 +1685,7 @@ static void tcg_out_qemu_st(TCGContext *s, const TCGArg *args, int opc)
     int data_reg, data_reg2 = 0;
     int addrlo_idx;
     int mem_index, s_bits;
-    int stack_adjust;
-    uint8_t *label_ptr[3];
+    uint8_t *label_ptr[2];
 
     data_reg = args[0];
     addrlo_idx = 1;
@@ -1249,20 +1703,19 @@ static void tcg_out_qemu_st(TCGContext *s, const TCGArg *args, int opc)
     /* TLB Hit.  */
     tcg_out_qemu_st_direct(s, data_reg, data_reg2, tcg_target_call_iarg_regs[0], 0, opc);
 
-    /* jmp label2 */
-    tcg_out8(s, OPC_JMP_short);
-    label_ptr[2] = s->code_ptr;
-    s->code_ptr++;
-
-    /* TLB Miss.  */
+    add_qemu_ldst_label(s, 0, opc, data_reg, data_reg2, TARGET_LONG_BITS > TCG_TARGET_REG_BITS ? args[addrlo_idx + 1] : 0,
+                        mem_index, label_ptr);
+}
 
-    /* label1: */
-    *label_ptr[0] = s->code_ptr - label_ptr[0] - 1;
-    if (TARGET_LONG_BITS > TCG_TARGET_REG_BITS) {
-        *label_ptr[1] = s->code_ptr - label_ptr[1] - 1;
-    }
+static void tcg_out_qemu_st_slow_path(TCGContext *s, TCGLabelQemuLdst *l)
+{
+    int opc = l->opc;
+    int data_reg = l->datalo_reg;
+    int data_reg2 = l->datahi_reg;
+    int mem_index = l->mem_index;
+    int s_bits = opc;
+    int stack_adjust;
 
-    /* XXX: move that code at the end of the TB */
     if (TCG_TARGET_REG_BITS == 64) {
         tcg_out_mov(s, (opc == 3 ? TCG_TYPE_I64 : TCG_TYPE_I32), tcg_target_call_iarg_regs[1], data_reg);
         tcg_out_movi(s, TCG_TYPE_I32, tcg_target_call_iarg_regs[2], mem_index);
@@ -1279,13 +1732,13 @@ static void tcg_out_qemu_st(TCGContext *s, const TCGArg *args, int opc)
         }
     } else {
         if (opc == 3) {
-            tcg_out_mov(s, TCG_TYPE_I32, TCG_REG_EDX, args[addrlo_idx + 1]);
+            tcg_out_mov(s, TCG_TYPE_I32, TCG_REG_EDX, l->addrhi_reg);
             tcg_out_pushi(s, mem_index);
             tcg_out_push(s, data_reg2);
             tcg_out_push(s, data_reg);
             stack_adjust = 12;
         } else {
-            tcg_out_mov(s, TCG_TYPE_I32, TCG_REG_EDX, args[addrlo_idx + 1]);
+            tcg_out_mov(s, TCG_TYPE_I32, TCG_REG_EDX, l->addrhi_reg);
             switch (opc) {
             case 0:
                 tcg_out_ext8u(s, TCG_REG_ECX, data_reg);
@@ -1325,17 +1778,198 @@ static void tcg_out_qemu_st(TCGContext *s, const TCGArg *args, int opc)
     } else if (stack_adjust != 0) {
         tcg_out_addi(s, TCG_REG_CALL_STACK, stack_adjust);
     }
+}
+
+/* TLB miss: call the helper and return to the fast path */
+static void tcg_out_qemu_ldst_slow_path(TCGContext *s, TCGLabelQemuLdst *l)
+{
+    *(int32_t *)l->label_ptr[0] = s->code_ptr - l->label_ptr[0] - 4;
+    if (TARGET_LONG_BITS > TCG_TARGET_REG_BITS) {
+        *(int32_t *)l->label_ptr[1] = s->code_ptr - l->label_ptr[1] - 4;
+    }
+    tcg_out_vzeroupper(s);
+    if (l->is_ld) {
+        tcg_out_qemu_ld_slow_path(s, l);
+    } else {
+        tcg_out_qemu_st_slow_path(s, l);
+    }
+    tcg_out_jmp(s, (tcg_target_long)tcg_code_rx(l->raddr));
+}
+
+#if TCG_TARGET_REG_BITS == 64
+static void tcg_out_dup_vec(TCGContext *s, TCGType type, unsigned vece, TCGReg r, TCGArg a, int const_a)
+{
+    static const int broadcast_insn[4] = { OPC_VPBROADCASTB, OPC_VPBROADCASTW, OPC_VPBROADCASTD, OPC_VPBROADCASTQ };
+    int vexl = type == TCG_TYPE_V256 ? P_VEXL : 0;
+
+    if (const_a) {
+        /* all zeros or all ones, whatever the element size */
+        tcg_out_vec_modrm(s, (a == 0 ? OPC_PXOR : OPC_PCMPEQD) | vexl, r, r, r);
+        return;
+    }
+
+    tcg_out_vec_modrm(s, OPC_MOVD_VyEy + (vece == VECE_64 ? P_REXW : 0), r, 0, a);
+    if (have_avx2) {
+        tcg_out_vex_modrm(s, broadcast_insn[vece] | vexl, r, 0, r);
+        return;
+    }
+    switch (vece) {
+    case VECE_8:
+        tcg_out_vec_modrm(s, OPC_PUNPCKLBW, r, r, r);
+        /* fall through */
+    case VECE_16:
+        tcg_out_vec_modrm(s, OPC_PSHUFLW, r, 0, r);
+        tcg_out8(s, 0);
+        /* fall through */
+    case VECE_32:
+        tcg_out_vec_modrm(s, OPC_PSHUFD, r, 0, r);
+        tcg_out8(s, 0);
+        break;
+    default:
+        tcg_out_vec_modrm(s, OPC_PUNPCKLQDQ, r, r, r);
+        break;
+    }
+}
+
+static void tcg_out_vec_op(TCGContext *s, TCGOpcode opc, const TCGArg *args, const int *const_args)
+{
+    static const int add_insn[4] = { OPC_PADDB, OPC_PADDW, OPC_PADDD, OPC_PADDQ };
+    static const int sub_insn[4] = { OPC_PSUBB, OPC_PSUBW, OPC_PSUBD, OPC_PSUBQ };
+    static const int mul_insn[4] = { 0, OPC_PMULLW, OPC_PMULLD, 0 };
+    static const int shift_insn[4] = { 0, OPC_PSHIFTW_Ib, OPC_PSHIFTD_Ib, OPC_PSHIFTQ_Ib };
+    static const int cmpeq_insn[4] = { OPC_PCMPEQB, OPC_PCMPEQW, OPC_PCMPEQD, OPC_PCMPEQQ };
+    static const int cmpgt_insn[4] = { OPC_PCMPGTB, OPC_PCMPGTW, OPC_PCMPGTD, OPC_PCMPGTQ };
+    TCGType type;
+    int insn, sub;
+
+    switch (opc) {
+    case INDEX_op_ld_vec:
+        type = args[3];
+        tcg_out_ld(s, type, args[0], args[1], args[2]);
+        break;
+    case INDEX_op_st_vec:
+        type = args[3];
+        tcg_out_st(s, type, args[0], args[1], args[2]);
+        break;
+    case INDEX_op_dup_vec:
+        type = args[2];
+        tcg_out_dup_vec(s, type, args[3], args[0], args[1], const_args[1]);
+        break;
+
+    case INDEX_op_add_vec:
+        insn = add_insn[args[4]];
+        goto gen_simd;
+    case INDEX_op_sub_vec:
+        insn = sub_insn[args[4]];
+        goto gen_simd;
+    case INDEX_op_mul_vec:
+        insn = mul_insn[args[4]];
+        goto gen_simd;
+    case INDEX_op_and_vec:
+        insn = OPC_PAND;
+        goto gen_simd;
+    case INDEX_op_or_vec:
+        insn = OPC_POR;
+        goto gen_simd;
+    case INDEX_op_xor_vec:
+        insn = OPC_PXOR;
+    gen_simd:
+        type = args[3];
+        tcg_out_vec_modrm(s, insn | (type == TCG_TYPE_V256 ? P_VEXL : 0), args[0], args[1], args[2]);
+        break;
+    case INDEX_op_andc_vec:
+        /* pandn complements its first source */
+        type = args[3];
+        tcg_out_vec_modrm(s, OPC_PANDN | (type == TCG_TYPE_V256 ? P_VEXL : 0), args[0], args[2], args[1]);
+        break;
+
+    case INDEX_op_shli_vec:
+        sub = 6;
+        goto gen_shift;
+    case INDEX_op_shri_vec:
+        sub = 2;
+        goto gen_shift;
+    case INDEX_op_sari_vec:
+        sub = 4;
+    gen_shift:
+        /* the destination is in VEX.vvvv, or is the only operand */
+        type = args[3];
+        insn = shift_insn[args[4]] | (type == TCG_TYPE_V256 ? P_VEXL : 0);
+        if (have_avx1) {
+            tcg_out_vex_modrm(s, insn, sub, args[0], args[1]);
+        } else {
+            assert(args[0] == args[1]);
+            tcg_out_modrm(s, insn, sub, args[0]);
+        }
+        tcg_out8(s, args[2]);
+        break;
+
+    case INDEX_op_cmp_vec:
+        /* tcg_gen_cmp_vec leaves only these two */
+        type = args[4];
+        switch (args[3]) {
+        case TCG_COND_EQ:
+            insn = cmpeq_insn[args[5]];
+            break;
+        case TCG_COND_GT:
+            insn = cmpgt_insn[args[5]];
+            break;
+        default:
+            tcg_abort();
+        }
+        tcg_out_vec_modrm(s, insn | (type == TCG_TYPE_V256 ? P_VEXL : 0), args[0], args[1], args[2]);
+        break;
+
+    default:
+        tcg_abort();
+    }
+
+    if (type == TCG_TYPE_V256) {
+        s->vec_256_used = 1;
+    }
+}
 
-    /* label2: */
-    *label_ptr[2] = s->code_ptr - label_ptr[2] - 1;
+/* Which vector operations the host can do; the others are expanded by
+   tcg-op-gvec.c.  */
+int tcg_can_emit_vec_op(TCGOpcode opc, TCGType type, unsigned vece)
+{
+    if (type == TCG_TYPE_V256 && !have_avx2) {
+        return 0;
+    }
+    switch (opc) {
+    case INDEX_op_mov_vec:
+    case INDEX_op_ld_vec:
+    case INDEX_op_st_vec:
+    case INDEX_op_dup_vec:
+    case INDEX_op_add_vec:
+    case INDEX_op_sub_vec:
+    case INDEX_op_and_vec:
+    case INDEX_op_or_vec:
+    case INDEX_op_xor_vec:
+    case INDEX_op_andc_vec:
+        return 1;
+    case INDEX_op_mul_vec:
+        return vece == VECE_16 || (vece == VECE_32 && have_sse41);
+    case INDEX_op_shli_vec:
+    case INDEX_op_shri_vec:
+        return vece != VECE_8;
+    case INDEX_op_sari_vec:
+        return vece == VECE_16 || vece == VECE_32;
+    case INDEX_op_cmp_vec:
+        /* pcmpeqq comes with SSE4.1, pcmpgtq with SSE4.2 */
+        return vece != VECE_64 || have_sse42;
+    default:
+        return 0;
+    }
 }
+#endif
 
 /* *INDENT-OFF* */
 
 static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
                               const TCGArg *args, const int *const_args)
 {
-    int c, rexw = 0;
+    int c, vexop, rexw = 0;
 
 #if TCG_TARGET_REG_BITS == 64
 # define OP_32_64(x) \
@@ -1349,10 +1983,12 @@ static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
 
     switch(opc) {
     case INDEX_op_exit_tb:
+        tcg_out_vzeroupper(s);
         tcg_out_movi(s, TCG_TYPE_PTR, TCG_REG_EAX, args[0]);
         tcg_out_jmp(s, (tcg_target_long) tb_ret_addr);
         break;
     case INDEX_op_goto_tb:
+        tcg_out_vzeroupper(s);
         if (s->tb_jmp_offset) {
             /* direct jump method */
             tcg_out8(s, OPC_JMP_long); /* jmp im */
@@ -1366,6 +2002,7 @@ static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
         s->tb_next_offset[args[0]] = s->code_ptr - s->code_buf;
         break;
     case INDEX_op_call:
+        tcg_out_vzeroupper(s);
         if (const_args[0]) {
             tcg_out_calli(s, args[0]);
         } else {
@@ -1374,6 +2011,7 @@ static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
         }
         break;
     case INDEX_op_jmp:
+        tcg_out_vzeroupper(s);
         if (const_args[0]) {
             tcg_out_jmp(s, args[0]);
         } else {
@@ -1461,6 +2099,10 @@ static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
             tgen_arithr(s, c + rexw, args[0], args[2]);
         }
         break;
+    OP_32_64(andc):
+        /* andn computes ~v & rm */
+        tcg_out_vex_modrm(s, OPC_ANDN + rexw, args[0], args[2], args[1]);
+        break;
 
     OP_32_64(mul):
         if (const_args[2]) {
@@ -1487,22 +2129,39 @@ static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
 
     OP_32_64(shl):
         c = SHIFT_SHL;
+        vexop = OPC_SHLX;
         goto gen_shift;
     OP_32_64(shr):
         c = SHIFT_SHR;
+        vexop = OPC_SHRX;
         goto gen_shift;
     OP_32_64(sar):
         c = SHIFT_SAR;
+        vexop = OPC_SARX;
         goto gen_shift;
     OP_32_64(rotl):
         c = SHIFT_ROL;
+        vexop = 0;
         goto gen_shift;
     OP_32_64(rotr):
         c = SHIFT_ROR;
+        vexop = 0;
         goto gen_shift;
     gen_shift:
+        /* with BMI2 the shifts take any count register and need not
+           overwrite their source, see x86_bmi2_op_defs */
         if (const_args[2]) {
-            tcg_out_shifti(s, c + rexw, args[0], args[2]);
+            if (have_bmi2 && (c == SHIFT_ROL || c == SHIFT_ROR)) {
+                /* rorx leaves the flags alone */
+                int bits = rexw ? 64 : 32;
+                tcg_out_vex_modrm(s, OPC_RORX + rexw, args[0], 0, args[1]);
+                tcg_out8(s, (c == SHIFT_ROL ? bits - args[2] : args[2]) & (bits - 1));
+            } else {
+                tcg_out_mov(s, rexw ? TCG_TYPE_I64 : TCG_TYPE_I32, args[0], args[1]);
+                tcg_out_shifti(s, c + rexw, args[0], args[2]);
+            }
+        } else if (have_bmi2 && vexop) {
+            tcg_out_vex_modrm(s, vexop + rexw, args[0], args[2], args[1]);
         } else {
             tcg_out_modrm(s, OPC_SHIFT_cl + rexw, c, args[0]);
         }
@@ -1516,6 +2175,30 @@ static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
         tcg_out_setcond32(s, args[3], args[0], args[1],
                           args[2], const_args[2]);
         break;
+    OP_32_64(movcond):
+        tcg_out_movcond(s, args[5], args[0], args[1], args[2], const_args[2], args[3], rexw);
+        break;
+
+    OP_32_64(clz):
+        tcg_out_clz(s, args[0], args[1], args[2], const_args[2], rexw);
+        break;
+    OP_32_64(ctz):
+        tcg_out_ctz(s, args[0], args[1], args[2], const_args[2], rexw);
+        break;
+    OP_32_64(ctpop):
+        tcg_out_modrm(s, OPC_POPCNT + rexw, args[0], args[1]);
+        break;
+
+    OP_32_64(extract):
+        tcg_out_extract(s, args[0], args[1], args[2], args[3], 0, rexw);
+        break;
+    OP_32_64(sextract):
+        tcg_out_extract(s, args[0], args[1], args[2], args[3], 1, rexw);
+        break;
+
+    case INDEX_op_mb:
+        tcg_out_mb(s, args[0]);
+        break;
 
     OP_32_64(bswap16):
         tcg_out_rolw_8(s, args[0]);
@@ -1668,6 +2351,25 @@ static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
         }
         break;
 
+#if TCG_TARGET_REG_BITS == 64
+    case INDEX_op_ld_vec:
+    case INDEX_op_st_vec:
+    case INDEX_op_dup_vec:
+    case INDEX_op_add_vec:
+    case INDEX_op_sub_vec:
+    case INDEX_op_mul_vec:
+    case INDEX_op_and_vec:
+    case INDEX_op_or_vec:
+    case INDEX_op_xor_vec:
+    case INDEX_op_andc_vec:
+    case INDEX_op_shli_vec:
+    case INDEX_op_shri_vec:
+    case INDEX_op_sari_vec:
+    case INDEX_op_cmp_vec:
+        tcg_out_vec_op(s, opc, args, const_args);
+        break;
+#endif
+
     default:
         tcg_abort();
     }
@@ -1700,6 +2402,7 @@ static const TCGTargetOpDef x86_op_defs[] = {
     { INDEX_op_and_i32, { "r", "0", "ri" } },
     { INDEX_op_or_i32, { "r", "0", "ri" } },
     { INDEX_op_xor_i32, { "r", "0", "ri" } },
+    { INDEX_op_andc_i32, { "r", "r", "r" } },
 
     { INDEX_op_shl_i32, { "r", "0", "ci" } },
     { INDEX_op_shr_i32, { "r", "0", "ci" } },
@@ -1724,6 +2427,16 @@ static const TCGTargetOpDef x86_op_defs[] = {
     { INDEX_op_setcond_i32, { "q", "r", "ri" } },
 
     { INDEX_op_deposit_i32, { "Q", "0", "Q" } },
+    { INDEX_op_movcond_i32, { "r", "r", "ri", "r", "0" } },
+
+    { INDEX_op_clz_i32, { "r", "0", "r" } },
+    { INDEX_op_ctz_i32, { "r", "0", "r" } },
+    { INDEX_op_ctpop_i32, { "r", "r" } },
+
+    { INDEX_op_extract_i32, { "r", "r" } },
+    { INDEX_op_sextract_i32, { "r", "r" } },
+
+    { INDEX_op_mb, { } },
 
     { INDEX_op_mulu2_i32, { "a", "d", "a", "r" } },
     { INDEX_op_muls2_i32, { "a", "d", "a", "r" } },
@@ -1756,6 +2469,7 @@ static const TCGTargetOpDef x86_op_defs[] = {
     { INDEX_op_and_i64, { "r", "0", "reZ" } },
     { INDEX_op_or_i64, { "r", "0", "re" } },
     { INDEX_op_xor_i64, { "r", "0", "re" } },
+    { INDEX_op_andc_i64, { "r", "r", "r" } },
 
     { INDEX_op_shl_i64, { "r", "0", "ci" } },
     { INDEX_op_shr_i64, { "r", "0", "ci" } },
@@ -1780,9 +2494,34 @@ static const TCGTargetOpDef x86_op_defs[] = {
     { INDEX_op_ext32u_i64, { "r", "r" } },
 
     { INDEX_op_deposit_i64, { "Q", "0", "Q" } },
+    { INDEX_op_movcond_i64, { "r", "r", "re", "r", "0" } },
+
+    { INDEX_op_clz_i64, { "r", "0", "r" } },
+    { INDEX_op_ctz_i64, { "r", "0", "r" } },
+    { INDEX_op_ctpop_i64, { "r", "r" } },
+
+    { INDEX_op_extract_i64, { "r", "r" } },
+    { INDEX_op_sextract_i64, { "r", "r" } },
 
     { INDEX_op_mulu2_i64, { "a", "d", "a", "r" } },
     { INDEX_op_muls2_i64, { "a", "d", "a", "r" } },
+
+    /* the SSE encodings overwrite their first source */
+    { INDEX_op_mov_vec, { "x", "x" } },
+    { INDEX_op_ld_vec, { "x", "r" } },
+    { INDEX_op_st_vec, { "x", "r" } },
+    { INDEX_op_dup_vec, { "x", "rM" } },
+    { INDEX_op_add_vec, { "x", "0", "x" } },
+    { INDEX_op_sub_vec, { "x", "0", "x" } },
+    { INDEX_op_mul_vec, { "x", "0", "x" } },
+    { INDEX_op_and_vec, { "x", "0", "x" } },
+    { INDEX_op_or_vec, { "x", "0", "x" } },
+    { INDEX_op_xor_vec, { "x", "0", "x" } },
+    { INDEX_op_andc_vec, { "x", "x", "0" } },
+    { INDEX_op_shli_vec, { "x", "0" } },
+    { INDEX_op_shri_vec, { "x", "0" } },
+    { INDEX_op_sari_vec, { "x", "0" } },
+    { INDEX_op_cmp_vec, { "x", "0", "x" } },
 #endif
 
 #if TCG_TARGET_REG_BITS == 64
@@ -1827,6 +2566,52 @@ static const TCGTargetOpDef x86_op_defs[] = {
     { -1 },
 };
 
+/* Constraints replacing the ones above when the host has the feature */
+static const TCGTargetOpDef x86_bmi1_op_defs[] = {
+    { INDEX_op_ctz_i32, { "r", "r", "rW" } },
+#if TCG_TARGET_REG_BITS == 64
+    { INDEX_op_ctz_i64, { "r", "r", "rW" } },
+#endif
+    { -1 },
+};
+
+static const TCGTargetOpDef x86_bmi2_op_defs[] = {
+    { INDEX_op_shl_i32, { "r", "r", "ri" } },
+    { INDEX_op_shr_i32, { "r", "r", "ri" } },
+    { INDEX_op_sar_i32, { "r", "r", "ri" } },
+#if TCG_TARGET_REG_BITS == 64
+    { INDEX_op_shl_i64, { "r", "r", "ri" } },
+    { INDEX_op_shr_i64, { "r", "r", "ri" } },
+    { INDEX_op_sar_i64, { "r", "r", "ri" } },
+#endif
+    { -1 },
+};
+
+static const TCGTargetOpDef x86_lzcnt_op_defs[] = {
+    { INDEX_op_clz_i32, { "r", "r", "rW" } },
+#if TCG_TARGET_REG_BITS == 64
+    { INDEX_op_clz_i64, { "r", "r", "rW" } },
+#endif
+    { -1 },
+};
+
+#if TCG_TARGET_REG_BITS == 64
+static const TCGTargetOpDef x86_avx_op_defs[] = {
+    { INDEX_op_add_vec, { "x", "x", "x" } },
+    { INDEX_op_sub_vec, { "x", "x", "x" } },
+    { INDEX_op_mul_vec, { "x", "x", "x" } },
+    { INDEX_op_and_vec, { "x", "x", "x" } },
+    { INDEX_op_or_vec, { "x", "x", "x" } },
+    { INDEX_op_xor_vec, { "x", "x", "x" } },
+    { INDEX_op_andc_vec, { "x", "x", "x" } },
+    { INDEX_op_shli_vec, { "x", "x" } },
+    { INDEX_op_shri_vec, { "x", "x" } },
+    { INDEX_op_sari_vec, { "x", "x" } },
+    { INDEX_op_cmp_vec, { "x", "x", "x" } },
+    { -1 },
+};
+#endif
+
 static int tcg_target_callee_save_regs[] = {
 #if TCG_TARGET_REG_BITS == 64
     TCG_REG_RBP,
@@ -1875,7 +2660,7 @@ static void tcg_target_qemu_prologue(TCGContext *s)
     tcg_out_modrm(s, OPC_GRP5, EXT5_JMPN_Ev, tcg_target_call_iarg_regs[1]);
 
     /* TB epilogue */
-    tb_ret_addr = s->code_ptr;
+    tb_ret_addr = tcg_code_rx(s->code_ptr);
 
     tcg_out_addi(s, TCG_REG_CALL_STACK, stack_addend);
     for (i = ARRAY_SIZE(tcg_target_callee_save_regs) - 1; i >= 0; i--) {
@@ -1886,14 +2671,43 @@ static void tcg_target_qemu_prologue(TCGContext *s)
 
 static void tcg_target_init(TCGContext *s)
 {
+    unsigned int a, b, c, d;
+
     /* fail safe */
     if ((1 << CPU_TLB_ENTRY_BITS) != sizeof_CPUTLBEntry) {
         tcg_abort();
     }
 
+    if (__get_cpuid(1, &a, &b, &c, &d)) {
+        have_popcnt = (c & bit_POPCNT) != 0;
+        have_movbe = (c & bit_MOVBE) != 0;
+        have_sse41 = (c & bit_SSE4_1) != 0;
+        have_sse42 = (c & bit_SSE4_2) != 0;
+        /* the OS must also save the ymm registers */
+        if ((c & bit_OSXSAVE) && (c & bit_AVX)) {
+            unsigned int xcr0, xcr0h;
+            asm("xgetbv" : "=a" (xcr0), "=d" (xcr0h) : "c" (0));
+            have_avx1 = (xcr0 & 6) == 6;
+        }
+    }
+    if (__get_cpuid_max(0, NULL) >= 7) {
+        __cpuid_count(7, 0, a, b, c, d);
+        have_bmi1 = (b & bit_BMI) != 0;
+        have_bmi2 = (b & bit_BMI2) != 0;
+        have_avx2 = have_avx1 && (b & bit_AVX2) != 0;
+    }
+    if (__get_cpuid(0x80000001, &a, &b, &c, &d)) {
+        have_lzcnt = (c & bit_LZCNT) != 0;
+    }
+
     if (TCG_TARGET_REG_BITS == 64) {
         tcg_regset_set32(tcg_target_available_regs[TCG_TYPE_I32], 0, 0xffff);
         tcg_regset_set32(tcg_target_available_regs[TCG_TYPE_I64], 0, 0xffff);
+        tcg_regset_set32(tcg_target_available_regs[TCG_TYPE_V64], 0, ALL_VECTOR_REGS);
+        tcg_regset_set32(tcg_target_available_regs[TCG_TYPE_V128], 0, ALL_VECTOR_REGS);
+        if (have_avx2) {
+            tcg_regset_set32(tcg_target_available_regs[TCG_TYPE_V256], 0, ALL_VECTOR_REGS);
+        }
     } else {
         tcg_regset_set32(tcg_target_available_regs[TCG_TYPE_I32], 0, 0xff);
     }
@@ -1911,10 +2725,25 @@ static void tcg_target_init(TCGContext *s)
         tcg_regset_set_reg(tcg_target_call_clobber_regs, TCG_REG_R9);
         tcg_regset_set_reg(tcg_target_call_clobber_regs, TCG_REG_R10);
         tcg_regset_set_reg(tcg_target_call_clobber_regs, TCG_REG_R11);
+        tcg_regset_set32(tcg_target_call_clobber_regs, 0, ALL_VECTOR_REGS);
     }
 
     tcg_regset_clear(s->reserved_regs);
     tcg_regset_set_reg(s->reserved_regs, TCG_REG_CALL_STACK);
 
     tcg_add_target_add_op_defs(x86_op_defs);
+    if (have_bmi1) {
+        tcg_add_target_add_op_defs(x86_bmi1_op_defs);
+    }
+    if (have_bmi2) {
+        tcg_add_target_add_op_defs(x86_bmi2_op_defs);
+    }
+    if (have_lzcnt) {
+        tcg_add_target_add_op_defs(x86_lzcnt_op_defs);
+    }
+#if TCG_TARGET_REG_BITS == 64
+    if (have_avx1) {
+        tcg_add_target_add_op_defs(x86_avx_op_defs);
+    }
+#endif
 }
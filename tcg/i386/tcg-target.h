@@ -28,7 +28,7 @@
 //#define TCG_TARGET_WORDS_BIGENDIAN
 
 #if TCG_TARGET_REG_BITS == 64
-# define TCG_TARGET_NB_REGS 16
+# define TCG_TARGET_NB_REGS 32
 #else
 # define TCG_TARGET_NB_REGS 8
 #endif
@@ -53,6 +53,25 @@ typedef enum {
     TCG_REG_R13,
     TCG_REG_R14,
     TCG_REG_R15,
+
+    /* vector registers, only used on 64-bit hosts */
+    TCG_REG_XMM0,
+    TCG_REG_XMM1,
+    TCG_REG_XMM2,
+    TCG_REG_XMM3,
+    TCG_REG_XMM4,
+    TCG_REG_XMM5,
+    TCG_REG_XMM6,
+    TCG_REG_XMM7,
+    TCG_REG_XMM8,
+    TCG_REG_XMM9,
+    TCG_REG_XMM10,
+    TCG_REG_XMM11,
+    TCG_REG_XMM12,
+    TCG_REG_XMM13,
+    TCG_REG_XMM14,
+    TCG_REG_XMM15,
+
     TCG_REG_RAX = TCG_REG_EAX,
     TCG_REG_RCX = TCG_REG_ECX,
     TCG_REG_RDX = TCG_REG_EDX,
@@ -65,6 +84,8 @@ typedef enum {
 
 #define TCG_CT_CONST_S32             0x100
 #define TCG_CT_CONST_U32             0x200
+#define TCG_CT_CONST_WSZ             0x400
+#define TCG_CT_CONST_VDUP            0x800
 
 /* used for function call generation */
 #define TCG_REG_CALL_STACK           TCG_REG_ESP
@@ -75,6 +96,11 @@ typedef enum {
 #define TCG_TARGET_CALL_STACK_OFFSET 0
 #endif
 
+/* host features detected at run time */
+extern bool have_popcnt;
+extern bool have_bmi1;
+extern bool have_avx2;
+
 /* optional instructions */
 #define TCG_TARGET_HAS_div2_i32      1
 #define TCG_TARGET_HAS_rot_i32       1
@@ -86,12 +112,19 @@ typedef enum {
 #define TCG_TARGET_HAS_bswap32_i32   1
 #define TCG_TARGET_HAS_neg_i32       1
 #define TCG_TARGET_HAS_not_i32       1
-#define TCG_TARGET_HAS_andc_i32      0
+#define TCG_TARGET_HAS_andc_i32      have_bmi1
 #define TCG_TARGET_HAS_orc_i32       0
 #define TCG_TARGET_HAS_eqv_i32       0
 #define TCG_TARGET_HAS_nand_i32      0
 #define TCG_TARGET_HAS_nor_i32       0
 #define TCG_TARGET_HAS_deposit_i32   1
+#define TCG_TARGET_HAS_movcond_i32   1
+#define TCG_TARGET_HAS_clz_i32       1
+#define TCG_TARGET_HAS_ctz_i32       1
+#define TCG_TARGET_HAS_ctpop_i32     have_popcnt
+#define TCG_TARGET_HAS_extract_i32   1
+#define TCG_TARGET_HAS_sextract_i32  1
+#define TCG_TARGET_HAS_mb            1
 #if TCG_TARGET_REG_BITS == 32
 #define TCG_TARGET_HAS_muls2_i32     1
 #define TCG_TARGET_HAS_mulu2_i32     1
@@ -113,7 +146,7 @@ typedef enum {
 #define TCG_TARGET_HAS_bswap64_i64   1
 #define TCG_TARGET_HAS_neg_i64       1
 #define TCG_TARGET_HAS_not_i64       1
-#define TCG_TARGET_HAS_andc_i64      0
+#define TCG_TARGET_HAS_andc_i64      have_bmi1
 #define TCG_TARGET_HAS_orc_i64       0
 #define TCG_TARGET_HAS_eqv_i64       0
 #define TCG_TARGET_HAS_nand_i64      0
@@ -121,6 +154,18 @@ typedef enum {
 #define TCG_TARGET_HAS_deposit_i64   1
 #define TCG_TARGET_HAS_mulu2_i64     1
 #define TCG_TARGET_HAS_muls2_i64     1
+#define TCG_TARGET_HAS_movcond_i64   1
+#define TCG_TARGET_HAS_clz_i64       1
+#define TCG_TARGET_HAS_ctz_i64       1
+#define TCG_TARGET_HAS_ctpop_i64     have_popcnt
+#define TCG_TARGET_HAS_extract_i64   1
+#define TCG_TARGET_HAS_sextract_i64  1
+
+/* SSE2 is part of x86-64; 256-bit integer operations need AVX2 */
+#define TCG_TARGET_MAYBE_vec         1
+#define TCG_TARGET_HAS_v64           1
+#define TCG_TARGET_HAS_v128          1
+#define TCG_TARGET_HAS_v256          have_avx2
 #endif
 
 #define TCG_TARGET_deposit_i32_valid(ofs, len) \
@@ -130,6 +175,9 @@ typedef enum {
 
 #define TCG_TARGET_HAS_GUEST_BASE
 
+/* the TLB miss paths of guest memory accesses follow the block */
+#define TCG_TARGET_NEED_LDST_LABELS
+
 /* Note: must be synced with cpu-defs.h */
 #if TCG_TARGET_REG_BITS == 64
 # define TCG_AREG0 TCG_REG_R14
@@ -50,9 +50,35 @@ struct tcg_temp_info {
     uint16_t prev_copy;
     uint16_t next_copy;
     tcg_target_ulong val;
+    /* bits known to be zero, valid in every state but TCG_TEMP_CONST */
+    tcg_target_ulong zeros;
 };
 
-static struct tcg_temp_info temps[TCG_MAX_TEMPS];
+/* one per temp, allocated from the pool for each block */
+static struct tcg_temp_info *temps;
+
+#define TCG_OPT_MAX_ENV_ACCESSES 32
+
+/* A field of the CPU state whose value is held in 'temp', as it would
+   be loaded by 'load_op'. */
+struct tcg_env_value {
+    tcg_target_long offset;
+    int size;
+    TCGOpcode load_op;
+    TCGArg temp;
+};
+
+/* A store to the CPU state nothing has read back yet. */
+struct tcg_env_store {
+    tcg_target_long offset;
+    int size;
+    int op_index;
+};
+
+static struct tcg_env_value env_values[TCG_OPT_MAX_ENV_ACCESSES];
+static int nb_env_values;
+static struct tcg_env_store env_stores[TCG_OPT_MAX_ENV_ACCESSES];
+static int nb_env_stores;
 
 /* Reset TEMP's state to TCG_TEMP_ANY.  If TEMP was a representative of some
    class of equivalent temp's, a new representative should be chosen in this
@@ -84,11 +110,34 @@ static void reset_temp(TCGArg temp, int nb_temps, int nb_globals)
         new_base = temps[temp].val;
     }
     temps[temp].state = TCG_TEMP_ANY;
+    temps[temp].zeros = 0;
     if (new_base != (TCGArg) - 1 && temps[new_base].next_copy == new_base) {
         temps[new_base].state = TCG_TEMP_ANY;
     }
 }
 
+/* Forget what is known about the temps that die at the end of a basic
+   block. Globals and local temps keep their values across branches. */
+static void reset_bb_temps(TCGContext *s, int nb_temps, int nb_globals)
+{
+    int i;
+
+    for (i = nb_globals; i < nb_temps; i++) {
+        if (!s->temps[i].temp_local) {
+            reset_temp(i, nb_temps, nb_globals);
+        }
+    }
+}
+
+/* Bits that may be set in the value of 'temp'. */
+static tcg_target_ulong temp_mask(TCGArg temp)
+{
+    if (temps[temp].state == TCG_TEMP_CONST) {
+        return temps[temp].val;
+    }
+    return ~temps[temp].zeros;
+}
+
 static int op_bits(TCGOpcode op)
 {
     const TCGOpDef *def = &tcg_op_defs[op];
@@ -115,6 +164,7 @@ static void tcg_opt_gen_mov(TCGContext *s, TCGArg *gen_args, TCGArg dst, TCGArg
 {
     reset_temp(dst, nb_temps, nb_globals);
     assert(temps[src].state != TCG_TEMP_COPY);
+    temps[dst].zeros = temps[src].zeros;
     /* Don't try to copy if one of temps is a global or either one
        is local and another is register */
     if (src >= nb_globals && dst >= nb_globals && tcg_arg_is_local(s, src) == tcg_arg_is_local(s, dst)) {
@@ -254,6 +304,24 @@ static TCGArg do_constant_folding_2(TCGOpcode op, TCGArg x, TCGArg y)
     case INDEX_op_ext32u_i64:
         return (uint32_t)x;
 
+    case INDEX_op_clz_i32:
+        return (uint32_t)x ? clz32(x) : y;
+
+    case INDEX_op_clz_i64:
+        return x ? clz64(x) : y;
+
+    case INDEX_op_ctz_i32:
+        return (uint32_t)x ? ctz32(x) : y;
+
+    case INDEX_op_ctz_i64:
+        return x ? ctz64(x) : y;
+
+    case INDEX_op_ctpop_i32:
+        return ctpop64((uint32_t)x);
+
+    case INDEX_op_ctpop_i64:
+        return ctpop64(x);
+
     default:
         fprintf(stderr, "Unrecognized operation %d in do_constant_folding.\n", op);
         tcg_abort();
@@ -271,17 +339,351 @@ static TCGArg do_constant_folding(TCGOpcode op, TCGArg x, TCGArg y)
     return res;
 }
 
+static tcg_target_ulong op_width_mask(TCGOpcode op)
+{
+    return op_bits(op) == 32 ? 0xffffffff : (tcg_target_ulong)-1;
+}
+
+/* Bits that may be set in the result of 'op'. The upper half of the
+   result of a 32-bit operation is undefined. */
+static tcg_target_ulong op_result_mask(TCGOpcode op, const TCGArg *args)
+{
+    tcg_target_ulong width = op_width_mask(op);
+    tcg_target_ulong mask, shift;
+
+    switch (op) {
+    CASE_OP_32_64(and):
+        mask = temp_mask(args[1]) & temp_mask(args[2]);
+        break;
+    CASE_OP_32_64(or):
+    CASE_OP_32_64(xor):
+        mask = temp_mask(args[1]) | temp_mask(args[2]);
+        break;
+    CASE_OP_32_64(shl):
+    CASE_OP_32_64(shr):
+    CASE_OP_32_64(sar):
+        shift = temps[args[2]].val;
+        if (temps[args[2]].state != TCG_TEMP_CONST || shift >= op_bits(op)) {
+            return -1;
+        }
+        mask = temp_mask(args[1]) & width;
+        if (op == INDEX_op_shl_i32 || op == INDEX_op_shl_i64) {
+            mask <<= shift;
+        } else if ((op == INDEX_op_sar_i32 || op == INDEX_op_sar_i64) && (mask & ~(width >> 1))) {
+            /* the sign bit may be set */
+            return -1;
+        } else {
+            mask >>= shift;
+        }
+        break;
+    CASE_OP_32_64(ext8u):
+        mask = temp_mask(args[1]) & 0xff;
+        break;
+    CASE_OP_32_64(ext16u):
+        mask = temp_mask(args[1]) & 0xffff;
+        break;
+    case INDEX_op_ext32u_i64:
+        mask = temp_mask(args[1]) & 0xffffffff;
+        break;
+    CASE_OP_32_64(ld8u):
+        mask = 0xff;
+        break;
+    CASE_OP_32_64(ld16u):
+        mask = 0xffff;
+        break;
+    case INDEX_op_ld32u_i64:
+        mask = 0xffffffff;
+        break;
+    CASE_OP_32_64(setcond):
+        mask = 1;
+        break;
+    CASE_OP_32_64(movcond):
+        mask = temp_mask(args[3]) | temp_mask(args[4]);
+        break;
+    CASE_OP_32_64(clz):
+    CASE_OP_32_64(ctz):
+        mask = (op_bits(op) * 2 - 1) | temp_mask(args[2]);
+        break;
+    CASE_OP_32_64(ctpop):
+        mask = op_bits(op) * 2 - 1;
+        break;
+    CASE_OP_32_64(extract):
+        mask = (temp_mask(args[1]) >> args[2]) & (((tcg_target_ulong)2 << (args[3] - 1)) - 1);
+        break;
+    default:
+        return -1;
+    }
+    return (mask & width) | ~width;
+}
+
+/* Value of the bitfield extracted by 'op' from 'x' */
+static TCGArg do_constant_folding_extract(TCGOpcode op, TCGArg x, int ofs, int len)
+{
+    int bits = op_bits(op);
+
+    x <<= sizeof(TCGArg) * 8 - ofs - len;
+    if (op == INDEX_op_sextract_i32 || op == INDEX_op_sextract_i64) {
+        x = (tcg_target_long)x >> (sizeof(TCGArg) * 8 - len);
+    } else {
+        x >>= sizeof(TCGArg) * 8 - len;
+    }
+    return bits == 32 ? x & 0xffffffff : x;
+}
+
+static int do_constant_folding_cond_2(TCGOpcode op, TCGArg x, TCGArg y, TCGCond c)
+{
+    if (op_bits(op) == 32) {
+        switch (c) {
+        case TCG_COND_EQ:
+            return (uint32_t)x == (uint32_t)y;
+        case TCG_COND_NE:
+            return (uint32_t)x != (uint32_t)y;
+        case TCG_COND_LT:
+            return (int32_t)x < (int32_t)y;
+        case TCG_COND_GE:
+            return (int32_t)x >= (int32_t)y;
+        case TCG_COND_LE:
+            return (int32_t)x <= (int32_t)y;
+        case TCG_COND_GT:
+            return (int32_t)x > (int32_t)y;
+        case TCG_COND_LTU:
+            return (uint32_t)x < (uint32_t)y;
+        case TCG_COND_GEU:
+            return (uint32_t)x >= (uint32_t)y;
+        case TCG_COND_LEU:
+            return (uint32_t)x <= (uint32_t)y;
+        case TCG_COND_GTU:
+            return (uint32_t)x > (uint32_t)y;
+        default:
+            break;
+        }
+    } else {
+        switch (c) {
+        case TCG_COND_EQ:
+            return (uint64_t)x == (uint64_t)y;
+        case TCG_COND_NE:
+            return (uint64_t)x != (uint64_t)y;
+        case TCG_COND_LT:
+            return (int64_t)x < (int64_t)y;
+        case TCG_COND_GE:
+            return (int64_t)x >= (int64_t)y;
+        case TCG_COND_LE:
+            return (int64_t)x <= (int64_t)y;
+        case TCG_COND_GT:
+            return (int64_t)x > (int64_t)y;
+        case TCG_COND_LTU:
+            return (uint64_t)x < (uint64_t)y;
+        case TCG_COND_GEU:
+            return (uint64_t)x >= (uint64_t)y;
+        case TCG_COND_LEU:
+            return (uint64_t)x <= (uint64_t)y;
+        case TCG_COND_GTU:
+            return (uint64_t)x > (uint64_t)y;
+        default:
+            break;
+        }
+    }
+    fprintf(stderr, "Unrecognized condition %d in do_constant_folding_cond.\n", c);
+    tcg_abort();
+    /* Never reached */
+    return 0;
+}
+
+/* Return 1 if the condition always holds, 0 if it never does and 2 if
+   it cannot be decided at translation time. */
+static int do_constant_folding_cond(TCGOpcode op, TCGArg x, TCGArg y, TCGCond c)
+{
+    if (temps[x].state == TCG_TEMP_CONST && temps[y].state == TCG_TEMP_CONST) {
+        return do_constant_folding_cond_2(op, temps[x].val, temps[y].val, c);
+    }
+    if (x == y) {
+        switch (c) {
+        case TCG_COND_EQ:
+        case TCG_COND_GE:
+        case TCG_COND_LE:
+        case TCG_COND_GEU:
+        case TCG_COND_LEU:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+    if (temps[y].state == TCG_TEMP_CONST && (temps[y].val & op_width_mask(op)) == 0) {
+        switch (c) {
+        case TCG_COND_LTU:
+            return 0;
+        case TCG_COND_GEU:
+            return 1;
+        default:
+            break;
+        }
+    }
+    return 2;
+}
+
+/* Accesses to the CPU state through env, which TCG globals are the only
+   other way of writing to. Values loaded or stored are reused by later
+   loads of the same field, and a store overwritten before anything can
+   read it is dropped. Both only last until the next call, guest memory
+   access or branch: a helper or a fault may read the CPU state. */
+
+static bool is_env_base(TCGContext *s, TCGArg arg)
+{
+    return s->temps[arg].fixed_reg && s->temps[arg].reg == TCG_AREG0;
+}
+
+static int env_access_size(TCGOpcode op)
+{
+    switch (op) {
+    CASE_OP_32_64(ld8u):
+    CASE_OP_32_64(ld8s):
+    CASE_OP_32_64(st8):
+        return 1;
+    CASE_OP_32_64(ld16u):
+    CASE_OP_32_64(ld16s):
+    CASE_OP_32_64(st16):
+        return 2;
+    case INDEX_op_ld_i32:
+    case INDEX_op_st_i32:
+    case INDEX_op_ld32u_i64:
+    case INDEX_op_ld32s_i64:
+    case INDEX_op_st32_i64:
+        return 4;
+    case INDEX_op_ld_i64:
+    case INDEX_op_st_i64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+static inline bool env_overlap(tcg_target_long offset1, int size1, tcg_target_long offset2, int size2)
+{
+    return offset1 < offset2 + size2 && offset2 < offset1 + size1;
+}
+
+static void env_forget_all(void)
+{
+    nb_env_values = 0;
+    nb_env_stores = 0;
+}
+
+/* 'temp' is about to be overwritten */
+static void env_forget_temp(TCGArg temp)
+{
+    int i;
+
+    for (i = 0; i < nb_env_values; ) {
+        if (env_values[i].temp == temp) {
+            env_values[i] = env_values[--nb_env_values];
+        } else {
+            i++;
+        }
+    }
+}
+
+static void env_forget_range(tcg_target_long offset, int size)
+{
+    int i;
+
+    for (i = 0; i < nb_env_values; ) {
+        if (env_overlap(env_values[i].offset, env_values[i].size, offset, size)) {
+            env_values[i] = env_values[--nb_env_values];
+        } else {
+            i++;
+        }
+    }
+}
+
+/* the stores to [offset, offset + size) are read */
+static void env_observe_range(tcg_target_long offset, int size)
+{
+    int i;
+
+    for (i = 0; i < nb_env_stores; ) {
+        if (env_overlap(env_stores[i].offset, env_stores[i].size, offset, size)) {
+            env_stores[i] = env_stores[--nb_env_stores];
+        } else {
+            i++;
+        }
+    }
+}
+
+static void env_remember_value(tcg_target_long offset, int size, TCGOpcode load_op, TCGArg temp)
+{
+    if (nb_env_values < TCG_OPT_MAX_ENV_ACCESSES) {
+        env_values[nb_env_values].offset = offset;
+        env_values[nb_env_values].size = size;
+        env_values[nb_env_values].load_op = load_op;
+        env_values[nb_env_values].temp = temp;
+        nb_env_values++;
+    }
+}
+
+static struct tcg_env_value *env_find_value(tcg_target_long offset, int size, TCGOpcode load_op)
+{
+    int i;
+
+    for (i = 0; i < nb_env_values; i++) {
+        if (env_values[i].offset == offset && env_values[i].size == size && env_values[i].load_op == load_op) {
+            return &env_values[i];
+        }
+    }
+    return NULL;
+}
+
+/* Record the store at 'op_index', dropping the earlier stores it
+   overwrites entirely. Stores keep their three arguments as a nop3. */
+static void env_record_store(int op_index, tcg_target_long offset, int size)
+{
+    int i;
+
+    for (i = 0; i < nb_env_stores; ) {
+        if (env_stores[i].offset >= offset && env_stores[i].offset + env_stores[i].size <= offset + size) {
+            tcg->gen_opc_buf[env_stores[i].op_index] = INDEX_op_nop3;
+            env_stores[i] = env_stores[--nb_env_stores];
+        } else if (env_overlap(env_stores[i].offset, env_stores[i].size, offset, size)) {
+            env_stores[i] = env_stores[--nb_env_stores];
+        } else {
+            i++;
+        }
+    }
+    if (nb_env_stores < TCG_OPT_MAX_ENV_ACCESSES) {
+        env_stores[nb_env_stores].offset = offset;
+        env_stores[nb_env_stores].size = size;
+        env_stores[nb_env_stores].op_index = op_index;
+        nb_env_stores++;
+    }
+}
+
+static int op_nb_args(TCGOpcode op, const TCGArg *args)
+{
+    switch (op) {
+    case INDEX_op_call:
+        return (args[0] >> 16) + (args[0] & 0xffff) + 3;
+    case INDEX_op_nopn:
+        return args[0];
+    default:
+        return tcg_op_defs[op].nb_args;
+    }
+}
+
 /* *INDENT-OFF* */
 
-/* Propagate constants and copies, fold constant expressions. */
+/* Propagate constants and copies, fold constant expressions and
+   branches, drop unreachable code and redundant accesses to the CPU
+   state, and simplify operations on values with known zero bits. */
 static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
                                     TCGArg *args, TCGOpDef *tcg_op_defs)
 {
-    int i, nb_ops, op_index, nb_temps, nb_globals, nb_call_args;
+    int i, nb_ops, op_index, nb_temps, nb_globals, nb_call_args, size;
+    bool unreachable = false;
     TCGOpcode op;
     const TCGOpDef *def;
     TCGArg *gen_args;
     TCGArg tmp;
+    tcg_target_ulong mask;
+    struct tcg_env_value *value;
     /* Array VALS has an element for each temp.
        If this temp holds a constant then its value is kept in VALS' element.
        If this temp is a copy of other ones then this equivalence class'
@@ -291,13 +693,26 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
 
     nb_temps = s->nb_temps;
     nb_globals = s->nb_globals;
+    temps = tcg_malloc(nb_temps * sizeof(struct tcg_temp_info));
     memset(temps, 0, nb_temps * sizeof(struct tcg_temp_info));
+    env_forget_all();
 
     nb_ops = tcg_opc_ptr - tcg->gen_opc_buf;
     gen_args = args;
     for (op_index = 0; op_index < nb_ops; op_index++) {
         op = tcg->gen_opc_buf[op_index];
         def = &tcg_op_defs[op];
+
+        /* Nothing jumps past an unconditional branch but to a label */
+        if (unreachable) {
+            if (op != INDEX_op_set_label) {
+                args += op_nb_args(op, args);
+                tcg->gen_opc_buf[op_index] = INDEX_op_nop;
+                continue;
+            }
+            unreachable = false;
+        }
+
         /* Do copy propagation */
         if (!(def->flags & (TCG_OPF_CALL_CLOBBER | TCG_OPF_SIDE_EFFECTS))) {
             assert(op != INDEX_op_call);
@@ -308,6 +723,116 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
             }
         }
 
+        /* Reuse and drop accesses to the CPU state */
+        size = env_access_size(op);
+        if (size != 0 && is_env_base(s, args[1])) {
+            if (def->nb_oargs == 0) {
+                tmp = args[0];
+                if (temps[tmp].state == TCG_TEMP_COPY) {
+                    tmp = temps[tmp].val;
+                }
+                env_forget_range(args[2], size);
+                env_record_store(op_index, args[2], size);
+                if (op == INDEX_op_st_i32) {
+                    env_remember_value(args[2], size, INDEX_op_ld_i32, tmp);
+                } else if (op == INDEX_op_st_i64) {
+                    env_remember_value(args[2], size, INDEX_op_ld_i64, tmp);
+                }
+                for (i = 0; i < 3; i++) {
+                    gen_args[i] = args[i];
+                }
+                gen_args += 3;
+                args += 3;
+                continue;
+            }
+            env_observe_range(args[2], size);
+            value = env_find_value(args[2], size, op);
+            if (value == NULL) {
+                mask = op_result_mask(op, args);
+                env_forget_temp(args[0]);
+                reset_temp(args[0], nb_temps, nb_globals);
+                temps[args[0]].zeros = ~mask;
+                env_remember_value(args[2], size, op, args[0]);
+                for (i = 0; i < 3; i++) {
+                    gen_args[i] = args[i];
+                }
+                gen_args += 3;
+                args += 3;
+                continue;
+            }
+            /* the field is already in a temp */
+            tmp = value->temp;
+            if (tmp == args[0] || (temps[args[0]].state == TCG_TEMP_COPY && temps[args[0]].val == tmp)) {
+                tcg->gen_opc_buf[op_index] = INDEX_op_nop;
+            } else if (temps[tmp].state == TCG_TEMP_CONST) {
+                env_forget_temp(args[0]);
+                tcg->gen_opc_buf[op_index] = op_to_movi(op);
+                tcg_opt_gen_movi(gen_args, args[0], temps[tmp].val, nb_temps, nb_globals);
+                gen_args += 2;
+            } else {
+                env_forget_temp(args[0]);
+                tcg->gen_opc_buf[op_index] = op_to_mov(op);
+                tcg_opt_gen_mov(s, gen_args, args[0], tmp, nb_temps, nb_globals);
+                gen_args += 2;
+            }
+            args += 3;
+            continue;
+        }
+        /* Vector accesses, sized by their type. The stores are never
+           dropped: they have four arguments, which no nop matches. */
+        if ((op == INDEX_op_ld_vec || op == INDEX_op_st_vec) && is_env_base(s, args[1])) {
+            size = 8 << (args[3] - TCG_TYPE_V64);
+            env_observe_range(args[2], size);
+            if (op == INDEX_op_st_vec) {
+                tmp = args[0];
+                if (temps[tmp].state == TCG_TEMP_COPY) {
+                    tmp = temps[tmp].val;
+                }
+                env_forget_range(args[2], size);
+                env_remember_value(args[2], size, INDEX_op_ld_vec, tmp);
+            } else {
+                value = env_find_value(args[2], size, op);
+                if (value != NULL) {
+                    tmp = value->temp;
+                    if (tmp == args[0] || (temps[args[0]].state == TCG_TEMP_COPY && temps[args[0]].val == tmp)) {
+                        tcg->gen_opc_buf[op_index] = INDEX_op_nop;
+                    } else {
+                        env_forget_temp(args[0]);
+                        tcg->gen_opc_buf[op_index] = INDEX_op_mov_vec;
+                        tcg_opt_gen_mov(s, gen_args, args[0], tmp, nb_temps, nb_globals);
+                        gen_args += 2;
+                    }
+                    args += 4;
+                    continue;
+                }
+                env_forget_temp(args[0]);
+                reset_temp(args[0], nb_temps, nb_globals);
+                env_remember_value(args[2], size, op, args[0]);
+            }
+            for (i = 0; i < 4; i++) {
+                gen_args[i] = args[i];
+            }
+            gen_args += 4;
+            args += 4;
+            continue;
+        }
+        if (size != 0 || op == INDEX_op_ld_vec || op == INDEX_op_st_vec) {
+            /* the base may point into the CPU state */
+            if (def->nb_oargs == 0) {
+                nb_env_values = 0;
+            } else {
+                nb_env_stores = 0;
+                env_forget_temp(args[0]);
+            }
+        } else if (op == INDEX_op_call || op == INDEX_op_set_label
+                   || (def->flags & (TCG_OPF_CALL_CLOBBER | TCG_OPF_SIDE_EFFECTS | TCG_OPF_BB_END))) {
+            env_forget_all();
+        } else {
+            for (i = 0; i < def->nb_oargs; i++) {
+                env_forget_temp(args[i]);
+            }
+        }
+
         /* For commutative operations make constant second argument */
         switch (op) {
         CASE_OP_32_64(add):
@@ -337,6 +862,8 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
         CASE_OP_32_64(sar):
         CASE_OP_32_64(rotl):
         CASE_OP_32_64(rotr):
+        CASE_OP_32_64(or):
+        CASE_OP_32_64(xor):
             if (temps[args[1]].state == TCG_TEMP_CONST) {
                 /* Proceed with possible constant folding. */
                 break;
@@ -368,6 +895,11 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
                 continue;
             }
             break;
+        default:
+            break;
+        }
+
+        switch (op) {
         CASE_OP_32_64(or):
         CASE_OP_32_64(and):
             if (args[1] == args[2]) {
@@ -388,11 +920,58 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
             break;
         }
 
+        /* Simplify operations on values with known zero bits */
+        switch (op) {
+        CASE_OP_32_64(and):
+        CASE_OP_32_64(shl):
+        CASE_OP_32_64(shr):
+        CASE_OP_32_64(ext8u):
+        CASE_OP_32_64(ext16u):
+        case INDEX_op_ext32u_i64:
+            if (temps[args[1]].state == TCG_TEMP_CONST) {
+                /* Proceed with possible constant folding. */
+                break;
+            }
+            mask = op_result_mask(op, args) & op_width_mask(op);
+            if (mask == 0) {
+                tcg->gen_opc_buf[op_index] = op_to_movi(op);
+                tcg_opt_gen_movi(gen_args, args[0], 0, nb_temps, nb_globals);
+                args += def->nb_args;
+                gen_args += 2;
+                continue;
+            }
+            /* An and with a constant or a zero extension that clears
+               no bit which may be set is a copy. */
+            if (op == INDEX_op_shl_i32 || op == INDEX_op_shl_i64
+                || op == INDEX_op_shr_i32 || op == INDEX_op_shr_i64
+                || ((op == INDEX_op_and_i32 || op == INDEX_op_and_i64)
+                    && temps[args[2]].state != TCG_TEMP_CONST)
+                || (temp_mask(args[1]) & op_width_mask(op) & ~mask) != 0) {
+                break;
+            }
+            if ((temps[args[0]].state == TCG_TEMP_COPY
+                && temps[args[0]].val == args[1])
+                || args[0] == args[1]) {
+                args += def->nb_args;
+                tcg->gen_opc_buf[op_index] = INDEX_op_nop;
+            } else {
+                tcg->gen_opc_buf[op_index] = op_to_mov(op);
+                tcg_opt_gen_mov(s, gen_args, args[0], args[1],
+                                nb_temps, nb_globals);
+                gen_args += 2;
+                args += def->nb_args;
+            }
+            continue;
+        default:
+            break;
+        }
+
         /* Propagate constants through copy operations and do constant
            folding.  Constants will be substituted to arguments by register
            allocator where needed and possible.  Also detect copies. */
         switch (op) {
         CASE_OP_32_64(mov):
+        case INDEX_op_mov_vec:
             if ((temps[args[1]].state == TCG_TEMP_COPY
                 && temps[args[1]].val == args[0])
                 || args[0] == args[1]) {
@@ -426,6 +1005,7 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
         CASE_OP_32_64(ext16u):
         case INDEX_op_ext32s_i64:
         case INDEX_op_ext32u_i64:
+        CASE_OP_32_64(ctpop):
             if (temps[args[1]].state == TCG_TEMP_CONST) {
                 tcg->gen_opc_buf[op_index] = op_to_movi(op);
                 tmp = do_constant_folding(op, temps[args[1]].val, 0);
@@ -434,7 +1014,9 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
                 args += 2;
                 break;
             } else {
+                mask = op_result_mask(op, args);
                 reset_temp(args[0], nb_temps, nb_globals);
+                temps[args[0]].zeros = ~mask;
                 gen_args[0] = args[0];
                 gen_args[1] = args[1];
                 gen_args += 2;
@@ -467,7 +1049,9 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
                 args += 3;
                 break;
             } else {
+                mask = op_result_mask(op, args);
                 reset_temp(args[0], nb_temps, nb_globals);
+                temps[args[0]].zeros = ~mask;
                 gen_args[0] = args[0];
                 gen_args[1] = args[1];
                 gen_args[2] = args[2];
@@ -475,9 +1059,88 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
                 args += 3;
                 break;
             }
+        CASE_OP_32_64(clz):
+        CASE_OP_32_64(ctz):
+            /* the count of a known non-zero value does not need the
+               second argument */
+            if (temps[args[1]].state == TCG_TEMP_CONST
+                && (temps[args[1]].val & op_width_mask(op)) != 0) {
+                tcg->gen_opc_buf[op_index] = op_to_movi(op);
+                tmp = do_constant_folding(op, temps[args[1]].val, 0);
+                tcg_opt_gen_movi(gen_args, args[0], tmp, nb_temps, nb_globals);
+                gen_args += 2;
+                args += 3;
+                break;
+            }
+            if (temps[args[1]].state == TCG_TEMP_CONST
+                && temps[args[2]].state == TCG_TEMP_CONST) {
+                tcg->gen_opc_buf[op_index] = op_to_movi(op);
+                tcg_opt_gen_movi(gen_args, args[0], temps[args[2]].val, nb_temps, nb_globals);
+                gen_args += 2;
+                args += 3;
+                break;
+            }
+            mask = op_result_mask(op, args);
+            reset_temp(args[0], nb_temps, nb_globals);
+            temps[args[0]].zeros = ~mask;
+            gen_args[0] = args[0];
+            gen_args[1] = args[1];
+            gen_args[2] = args[2];
+            gen_args += 3;
+            args += 3;
+            break;
+        CASE_OP_32_64(extract):
+        CASE_OP_32_64(sextract):
+            if (temps[args[1]].state == TCG_TEMP_CONST) {
+                tcg->gen_opc_buf[op_index] = op_to_movi(op);
+                tmp = do_constant_folding_extract(op, temps[args[1]].val, args[2], args[3]);
+                tcg_opt_gen_movi(gen_args, args[0], tmp, nb_temps, nb_globals);
+                gen_args += 2;
+                args += 4;
+                break;
+            }
+            mask = op_result_mask(op, args);
+            reset_temp(args[0], nb_temps, nb_globals);
+            temps[args[0]].zeros = ~mask;
+            for (i = 0; i < 4; i++) {
+                gen_args[i] = args[i];
+            }
+            gen_args += 4;
+            args += 4;
+            break;
+        CASE_OP_32_64(movcond):
+            tmp = do_constant_folding_cond(op, args[1], args[2], args[5]);
+            if (tmp != 2) {
+                /* the selected value is copied */
+                tmp = tmp ? args[3] : args[4];
+                if ((temps[args[0]].state == TCG_TEMP_COPY
+                    && temps[args[0]].val == tmp)
+                    || args[0] == tmp) {
+                    tcg->gen_opc_buf[op_index] = INDEX_op_nop;
+                } else if (temps[tmp].state == TCG_TEMP_CONST) {
+                    tcg->gen_opc_buf[op_index] = op_to_movi(op);
+                    tcg_opt_gen_movi(gen_args, args[0], temps[tmp].val, nb_temps, nb_globals);
+                    gen_args += 2;
+                } else {
+                    tcg->gen_opc_buf[op_index] = op_to_mov(op);
+                    tcg_opt_gen_mov(s, gen_args, args[0], tmp, nb_temps, nb_globals);
+                    gen_args += 2;
+                }
+                args += 6;
+                break;
+            }
+            mask = op_result_mask(op, args);
+            reset_temp(args[0], nb_temps, nb_globals);
+            temps[args[0]].zeros = ~mask;
+            for (i = 0; i < 6; i++) {
+                gen_args[i] = args[i];
+            }
+            gen_args += 6;
+            args += 6;
+            break;
         case INDEX_op_call:
             nb_call_args = (args[0] >> 16) + (args[0] & 0xffff);
-            if (!(args[nb_call_args + 1] & (TCG_CALL_CONST | TCG_CALL_PURE))) {
+            if (!(args[nb_call_args + 1] & (TCG_CALL_NO_READ_GLOBALS | TCG_CALL_NO_WRITE_GLOBALS | TCG_CALL_NO_SIDE_EFFECTS))) {
                 for (i = 0; i < nb_globals; i++) {
                     reset_temp(i, nb_temps, nb_globals);
                 }
@@ -493,10 +1156,55 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
                 i--;
             }
             break;
-        case INDEX_op_set_label:
+        CASE_OP_32_64(setcond):
+            tmp = do_constant_folding_cond(op, args[1], args[2], args[3]);
+            if (tmp != 2) {
+                tcg->gen_opc_buf[op_index] = op_to_movi(op);
+                tcg_opt_gen_movi(gen_args, args[0], tmp, nb_temps, nb_globals);
+                gen_args += 2;
+                args += 4;
+                break;
+            }
+            mask = op_result_mask(op, args);
+            reset_temp(args[0], nb_temps, nb_globals);
+            temps[args[0]].zeros = ~mask;
+            for (i = 0; i < 4; i++) {
+                gen_args[i] = args[i];
+            }
+            gen_args += 4;
+            args += 4;
+            break;
+        CASE_OP_32_64(brcond):
+            tmp = do_constant_folding_cond(op, args[0], args[1], args[2]);
+            if (tmp != 2) {
+                if (tmp) {
+                    tcg->gen_opc_buf[op_index] = INDEX_op_br;
+                    gen_args[0] = args[3];
+                    gen_args += 1;
+                    unreachable = true;
+                } else {
+                    tcg->gen_opc_buf[op_index] = INDEX_op_nop;
+                }
+                args += 4;
+                break;
+            }
+            /* fallthrough */
+        case INDEX_op_brcond2_i32:
+            /* the code following a conditional branch only loses the
+               temps that die at the end of the basic block */
+            reset_bb_temps(s, nb_temps, nb_globals);
+            for (i = 0; i < def->nb_args; i++) {
+                *gen_args = *args;
+                args++;
+                gen_args++;
+            }
+            break;
         case INDEX_op_jmp:
         case INDEX_op_br:
-        CASE_OP_32_64(brcond):
+        case INDEX_op_exit_tb:
+            unreachable = true;
+            /* fallthrough */
+        case INDEX_op_set_label:
             memset(temps, 0, nb_temps * sizeof(struct tcg_temp_info));
             for (i = 0; i < def->nb_args; i++) {
                 *gen_args = *args;
@@ -507,9 +1215,13 @@ static TCGArg *tcg_constant_folding(TCGContext *s, uint16_t *tcg_opc_ptr,
         default:
             /* Default case: we do know nothing about operation so no
                propagation is done.  We only trash output args.  */
+            mask = def->nb_oargs == 1 && !(def->flags & TCG_OPF_VECTOR) ? op_result_mask(op, args) : (tcg_target_ulong)-1;
             for (i = 0; i < def->nb_oargs; i++) {
                 reset_temp(args[i], nb_temps, nb_globals);
             }
+            if (def->nb_oargs == 1) {
+                temps[args[0]].zeros = ~mask;
+            }
             for (i = 0; i < def->nb_args; i++) {
                 gen_args[i] = args[i];
             }
@@ -0,0 +1,756 @@
+/*
+ * Copyright (c) Antmicro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <assert.h>
+#include "tcg-op-gvec.h"
+
+static inline TCGType vec_type(TCGv_vec v)
+{
+    return tcg->ctx->temps[GET_TCGV_VEC(v)].base_type;
+}
+
+void tcg_gen_mov_vec(TCGv_vec r, TCGv_vec a)
+{
+    if (GET_TCGV_VEC(r) != GET_TCGV_VEC(a)) {
+        *gen_opc_ptr++ = INDEX_op_mov_vec;
+        *gen_opparam_ptr++ = GET_TCGV_VEC(r);
+        *gen_opparam_ptr++ = GET_TCGV_VEC(a);
+    }
+}
+
+static void vec_gen_ldst(TCGOpcode opc, TCGv_vec r, TCGv_ptr base, tcg_target_long offset)
+{
+    *gen_opc_ptr++ = opc;
+    *gen_opparam_ptr++ = GET_TCGV_VEC(r);
+    *gen_opparam_ptr++ = GET_TCGV_PTR(base);
+    *gen_opparam_ptr++ = offset;
+    *gen_opparam_ptr++ = vec_type(r);
+}
+
+void tcg_gen_ld_vec(TCGv_vec r, TCGv_ptr base, tcg_target_long offset)
+{
+    vec_gen_ldst(INDEX_op_ld_vec, r, base, offset);
+}
+
+void tcg_gen_st_vec(TCGv_vec r, TCGv_ptr base, tcg_target_long offset)
+{
+    vec_gen_ldst(INDEX_op_st_vec, r, base, offset);
+}
+
+void tcg_gen_dup_i64_vec(unsigned vece, TCGv_vec r, TCGv_i64 a)
+{
+    *gen_opc_ptr++ = INDEX_op_dup_vec;
+    *gen_opparam_ptr++ = GET_TCGV_VEC(r);
+    *gen_opparam_ptr++ = GET_TCGV_I64(a);
+    *gen_opparam_ptr++ = vec_type(r);
+    *gen_opparam_ptr++ = vece;
+}
+
+/* All zeros and all ones are built by the backend without the constant */
+void tcg_gen_dupi_vec(unsigned vece, TCGv_vec r, uint64_t a)
+{
+    TCGv_i64 t0 = tcg_const_i64(dup_const(vece, a));
+
+    tcg_gen_dup_i64_vec(vece, r, t0);
+    tcg_temp_free_i64(t0);
+}
+
+static void vec_gen_op3(TCGOpcode opc, unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    *gen_opc_ptr++ = opc;
+    *gen_opparam_ptr++ = GET_TCGV_VEC(r);
+    *gen_opparam_ptr++ = GET_TCGV_VEC(a);
+    *gen_opparam_ptr++ = GET_TCGV_VEC(b);
+    *gen_opparam_ptr++ = vec_type(r);
+    *gen_opparam_ptr++ = vece;
+}
+
+void tcg_gen_add_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    vec_gen_op3(INDEX_op_add_vec, vece, r, a, b);
+}
+
+void tcg_gen_sub_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    vec_gen_op3(INDEX_op_sub_vec, vece, r, a, b);
+}
+
+void tcg_gen_mul_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    vec_gen_op3(INDEX_op_mul_vec, vece, r, a, b);
+}
+
+void tcg_gen_and_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    vec_gen_op3(INDEX_op_and_vec, vece, r, a, b);
+}
+
+void tcg_gen_or_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    vec_gen_op3(INDEX_op_or_vec, vece, r, a, b);
+}
+
+void tcg_gen_xor_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    vec_gen_op3(INDEX_op_xor_vec, vece, r, a, b);
+}
+
+void tcg_gen_andc_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    vec_gen_op3(INDEX_op_andc_vec, vece, r, a, b);
+}
+
+void tcg_gen_orc_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    TCGv_vec t0 = tcg_temp_new_vec(vec_type(r));
+
+    tcg_gen_not_vec(vece, t0, b);
+    tcg_gen_or_vec(vece, r, a, t0);
+    tcg_temp_free_vec(t0);
+}
+
+void tcg_gen_not_vec(unsigned vece, TCGv_vec r, TCGv_vec a)
+{
+    TCGv_vec t0 = tcg_temp_new_vec(vec_type(r));
+
+    tcg_gen_dupi_vec(vece, t0, -1);
+    tcg_gen_xor_vec(vece, r, a, t0);
+    tcg_temp_free_vec(t0);
+}
+
+void tcg_gen_neg_vec(unsigned vece, TCGv_vec r, TCGv_vec a)
+{
+    TCGv_vec t0 = tcg_temp_new_vec(vec_type(r));
+
+    tcg_gen_dupi_vec(vece, t0, 0);
+    tcg_gen_sub_vec(vece, r, t0, a);
+    tcg_temp_free_vec(t0);
+}
+
+static void vec_gen_opi(TCGOpcode opc, unsigned vece, TCGv_vec r, TCGv_vec a, int64_t i)
+{
+    assert(i >= 0 && i < (8 << vece));
+    *gen_opc_ptr++ = opc;
+    *gen_opparam_ptr++ = GET_TCGV_VEC(r);
+    *gen_opparam_ptr++ = GET_TCGV_VEC(a);
+    *gen_opparam_ptr++ = i;
+    *gen_opparam_ptr++ = vec_type(r);
+    *gen_opparam_ptr++ = vece;
+}
+
+void tcg_gen_shli_vec(unsigned vece, TCGv_vec r, TCGv_vec a, int64_t i)
+{
+    vec_gen_opi(INDEX_op_shli_vec, vece, r, a, i);
+}
+
+void tcg_gen_shri_vec(unsigned vece, TCGv_vec r, TCGv_vec a, int64_t i)
+{
+    vec_gen_opi(INDEX_op_shri_vec, vece, r, a, i);
+}
+
+void tcg_gen_sari_vec(unsigned vece, TCGv_vec r, TCGv_vec a, int64_t i)
+{
+    vec_gen_opi(INDEX_op_sari_vec, vece, r, a, i);
+}
+
+/* The host only compares for equality and signed greater than: the other
+   conditions swap the operands, invert the result, or flip the sign bits
+   to compare unsigned elements. */
+void tcg_gen_cmp_vec(TCGCond cond, unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    TCGType type = vec_type(r);
+    TCGv_vec t0, t1, t2;
+    int invert = 0, swap = 0, bias = 0;
+
+    switch (cond) {
+    case TCG_COND_EQ:
+    case TCG_COND_GT:
+        break;
+    case TCG_COND_NE:
+    case TCG_COND_LE:
+        invert = 1;
+        break;
+    case TCG_COND_LT:
+        swap = 1;
+        break;
+    case TCG_COND_GE:
+        swap = invert = 1;
+        break;
+    case TCG_COND_GTU:
+        bias = 1;
+        break;
+    case TCG_COND_LEU:
+        bias = invert = 1;
+        break;
+    case TCG_COND_LTU:
+        bias = swap = 1;
+        break;
+    case TCG_COND_GEU:
+        bias = swap = invert = 1;
+        break;
+    default:
+        tcg_abort();
+    }
+    if (swap) {
+        t0 = a;
+        a = b;
+        b = t0;
+    }
+
+    t1 = a;
+    t2 = b;
+    if (bias) {
+        t0 = tcg_temp_new_vec(type);
+        t1 = tcg_temp_new_vec(type);
+        t2 = tcg_temp_new_vec(type);
+        tcg_gen_dupi_vec(vece, t0, 1ull << ((8 << vece) - 1));
+        tcg_gen_xor_vec(vece, t1, a, t0);
+        tcg_gen_xor_vec(vece, t2, b, t0);
+        tcg_temp_free_vec(t0);
+    }
+
+    *gen_opc_ptr++ = INDEX_op_cmp_vec;
+    *gen_opparam_ptr++ = GET_TCGV_VEC(r);
+    *gen_opparam_ptr++ = GET_TCGV_VEC(t1);
+    *gen_opparam_ptr++ = GET_TCGV_VEC(t2);
+    *gen_opparam_ptr++ = cond == TCG_COND_EQ || cond == TCG_COND_NE ? TCG_COND_EQ : TCG_COND_GT;
+    *gen_opparam_ptr++ = type;
+    *gen_opparam_ptr++ = vece;
+
+    if (bias) {
+        tcg_temp_free_vec(t1);
+        tcg_temp_free_vec(t2);
+    }
+    if (invert) {
+        tcg_gen_not_vec(vece, r, r);
+    }
+}
+
+/* The largest host vector type the next 'size' bytes of an operation
+   can use, or TCG_TYPE_I64 when 8 of them go through integer registers */
+static TCGType gvec_type(TCGOpcode opc, unsigned vece, uint32_t size)
+{
+    if (TCG_TARGET_HAS_v256 && size >= 32 && tcg_can_emit_vec_op(opc, TCG_TYPE_V256, vece)) {
+        return TCG_TYPE_V256;
+    }
+    if (TCG_TARGET_HAS_v128 && size >= 16 && tcg_can_emit_vec_op(opc, TCG_TYPE_V128, vece)) {
+        return TCG_TYPE_V128;
+    }
+    if (TCG_TARGET_HAS_v64 && tcg_can_emit_vec_op(opc, TCG_TYPE_V64, vece)) {
+        return TCG_TYPE_V64;
+    }
+    return TCG_TYPE_I64;
+}
+
+static uint32_t gvec_type_size(TCGType type)
+{
+    switch (type) {
+    case TCG_TYPE_V256:
+        return 32;
+    case TCG_TYPE_V128:
+        return 16;
+    default:
+        return 8;
+    }
+}
+
+static void gvec_ld_elem_i32(unsigned vece, TCGv_i32 r, uint32_t offset, int sign)
+{
+    TCGv_ptr env = tcg->ctx->env;
+
+    switch (vece) {
+    case VECE_8:
+        if (sign) {
+            tcg_gen_ld8s_i32(r, env, offset);
+        } else {
+            tcg_gen_ld8u_i32(r, env, offset);
+        }
+        break;
+    case VECE_16:
+        if (sign) {
+            tcg_gen_ld16s_i32(r, env, offset);
+        } else {
+            tcg_gen_ld16u_i32(r, env, offset);
+        }
+        break;
+    default:
+        tcg_gen_ld_i32(r, env, offset);
+        break;
+    }
+}
+
+static void gvec_st_elem_i32(unsigned vece, TCGv_i32 r, uint32_t offset)
+{
+    TCGv_ptr env = tcg->ctx->env;
+
+    switch (vece) {
+    case VECE_8:
+        tcg_gen_st8_i32(r, env, offset);
+        break;
+    case VECE_16:
+        tcg_gen_st16_i32(r, env, offset);
+        break;
+    default:
+        tcg_gen_st_i32(r, env, offset);
+        break;
+    }
+}
+
+/* An operation, in host vectors of any type with 'fniv' when the host
+   has 'opc', and otherwise 8 bytes at a time in integer registers with
+   'fni8'. For elements of up to 32 bits, 'fni4' replaces 'fni8' when the
+   operation does not fit 64-bit words, and works element by element. */
+typedef struct GVecGen2 {
+    void (*fni8)(unsigned vece, TCGv_i64 d, TCGv_i64 a);
+    void (*fniv)(unsigned vece, TCGv_vec d, TCGv_vec a);
+    TCGOpcode opc;
+} GVecGen2;
+
+typedef struct GVecGen2i {
+    void (*fni8)(unsigned vece, TCGv_i64 d, TCGv_i64 a, int64_t c);
+    void (*fniv)(unsigned vece, TCGv_vec d, TCGv_vec a, int64_t c);
+    TCGOpcode opc;
+} GVecGen2i;
+
+typedef struct GVecGen3 {
+    void (*fni8)(unsigned vece, TCGv_i64 d, TCGv_i64 a, TCGv_i64 b);
+    void (*fni4)(TCGv_i32 d, TCGv_i32 a, TCGv_i32 b);
+    void (*fniv)(unsigned vece, TCGv_vec d, TCGv_vec a, TCGv_vec b);
+    TCGOpcode opc;
+} GVecGen3;
+
+static void expand_2(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t oprsz, const GVecGen2 *g)
+{
+    TCGv_ptr env = tcg->ctx->env;
+    TCGType type;
+    uint32_t i, size;
+
+    for (i = 0; i < oprsz; i += size) {
+        type = gvec_type(g->opc, vece, oprsz - i);
+        size = gvec_type_size(type);
+        if (type != TCG_TYPE_I64) {
+            TCGv_vec t0 = tcg_temp_new_vec(type);
+            tcg_gen_ld_vec(t0, env, aofs + i);
+            g->fniv(vece, t0, t0);
+            tcg_gen_st_vec(t0, env, dofs + i);
+            tcg_temp_free_vec(t0);
+        } else {
+            TCGv_i64 t0 = tcg_temp_new_i64();
+            tcg_gen_ld_i64(t0, env, aofs + i);
+            g->fni8(vece, t0, t0);
+            tcg_gen_st_i64(t0, env, dofs + i);
+            tcg_temp_free_i64(t0);
+        }
+    }
+}
+
+static void expand_2i(unsigned vece, uint32_t dofs, uint32_t aofs, int64_t c, uint32_t oprsz, const GVecGen2i *g)
+{
+    TCGv_ptr env = tcg->ctx->env;
+    TCGType type;
+    uint32_t i, size;
+
+    for (i = 0; i < oprsz; i += size) {
+        type = gvec_type(g->opc, vece, oprsz - i);
+        size = gvec_type_size(type);
+        if (type != TCG_TYPE_I64) {
+            TCGv_vec t0 = tcg_temp_new_vec(type);
+            tcg_gen_ld_vec(t0, env, aofs + i);
+            g->fniv(vece, t0, t0, c);
+            tcg_gen_st_vec(t0, env, dofs + i);
+            tcg_temp_free_vec(t0);
+        } else {
+            TCGv_i64 t0 = tcg_temp_new_i64();
+            tcg_gen_ld_i64(t0, env, aofs + i);
+            g->fni8(vece, t0, t0, c);
+            tcg_gen_st_i64(t0, env, dofs + i);
+            tcg_temp_free_i64(t0);
+        }
+    }
+}
+
+static void expand_3(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t bofs, uint32_t oprsz, const GVecGen3 *g)
+{
+    TCGv_ptr env = tcg->ctx->env;
+    TCGType type;
+    uint32_t i, j, size;
+
+    for (i = 0; i < oprsz; i += size) {
+        type = gvec_type(g->opc, vece, oprsz - i);
+        size = gvec_type_size(type);
+        if (type != TCG_TYPE_I64) {
+            TCGv_vec t0 = tcg_temp_new_vec(type);
+            TCGv_vec t1 = tcg_temp_new_vec(type);
+            tcg_gen_ld_vec(t0, env, aofs + i);
+            tcg_gen_ld_vec(t1, env, bofs + i);
+            g->fniv(vece, t0, t0, t1);
+            tcg_gen_st_vec(t0, env, dofs + i);
+            tcg_temp_free_vec(t0);
+            tcg_temp_free_vec(t1);
+        } else if (g->fni4 == NULL || vece == VECE_64) {
+            TCGv_i64 t0 = tcg_temp_new_i64();
+            TCGv_i64 t1 = tcg_temp_new_i64();
+            tcg_gen_ld_i64(t0, env, aofs + i);
+            tcg_gen_ld_i64(t1, env, bofs + i);
+            g->fni8(vece, t0, t0, t1);
+            tcg_gen_st_i64(t0, env, dofs + i);
+            tcg_temp_free_i64(t0);
+            tcg_temp_free_i64(t1);
+        } else {
+            TCGv_i32 t0 = tcg_temp_new_i32();
+            TCGv_i32 t1 = tcg_temp_new_i32();
+            for (j = i; j < i + 8; j += 1 << vece) {
+                gvec_ld_elem_i32(vece, t0, aofs + j, 0);
+                gvec_ld_elem_i32(vece, t1, bofs + j, 0);
+                g->fni4(t0, t0, t1);
+                gvec_st_elem_i32(vece, t0, dofs + j);
+            }
+            tcg_temp_free_i32(t0);
+            tcg_temp_free_i32(t1);
+        }
+    }
+}
+
+void tcg_gen_gvec_mov(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t oprsz)
+{
+    TCGv_ptr env = tcg->ctx->env;
+    TCGType type;
+    uint32_t i, size;
+
+    if (dofs == aofs) {
+        return;
+    }
+    for (i = 0; i < oprsz; i += size) {
+        type = gvec_type(INDEX_op_mov_vec, vece, oprsz - i);
+        size = gvec_type_size(type);
+        if (type != TCG_TYPE_I64) {
+            TCGv_vec t0 = tcg_temp_new_vec(type);
+            tcg_gen_ld_vec(t0, env, aofs + i);
+            tcg_gen_st_vec(t0, env, dofs + i);
+            tcg_temp_free_vec(t0);
+        } else {
+            TCGv_i64 t0 = tcg_temp_new_i64();
+            tcg_gen_ld_i64(t0, env, aofs + i);
+            tcg_gen_st_i64(t0, env, dofs + i);
+            tcg_temp_free_i64(t0);
+        }
+    }
+}
+
+void tcg_gen_gvec_dupi(unsigned vece, uint32_t dofs, uint32_t oprsz, uint64_t c)
+{
+    TCGv_ptr env = tcg->ctx->env;
+    TCGType type;
+    uint32_t i, size;
+
+    for (i = 0; i < oprsz; i += size) {
+        type = gvec_type(INDEX_op_dup_vec, vece, oprsz - i);
+        size = gvec_type_size(type);
+        if (type != TCG_TYPE_I64) {
+            TCGv_vec t0 = tcg_temp_new_vec(type);
+            tcg_gen_dupi_vec(vece, t0, c);
+            tcg_gen_st_vec(t0, env, dofs + i);
+            tcg_temp_free_vec(t0);
+        } else {
+            TCGv_i64 t0 = tcg_const_i64(dup_const(vece, c));
+            tcg_gen_st_i64(t0, env, dofs + i);
+            tcg_temp_free_i64(t0);
+        }
+    }
+}
+
+static void gvec_not8(unsigned vece, TCGv_i64 d, TCGv_i64 a)
+{
+    tcg_gen_not_i64(d, a);
+}
+
+void tcg_gen_gvec_not(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t oprsz)
+{
+    static const GVecGen2 g = { gvec_not8, tcg_gen_not_vec, INDEX_op_xor_vec };
+    expand_2(vece, dofs, aofs, oprsz, &g);
+}
+
+/* The sign bits of the elements of size 'vece' in a 64-bit word */
+static uint64_t gvec_sign_mask(unsigned vece)
+{
+    return dup_const(vece, 1ull << ((8 << vece) - 1));
+}
+
+/* In 64-bit words holding several elements, the carries and borrows
+   must not cross from one element into the next one: the sign bits
+   are set aside and computed by xor. */
+static void gvec_neg8(unsigned vece, TCGv_i64 d, TCGv_i64 a)
+{
+    TCGv_i64 m, t1, t2;
+
+    if (vece == VECE_64) {
+        tcg_gen_neg_i64(d, a);
+        return;
+    }
+    m = tcg_const_i64(gvec_sign_mask(vece));
+    t1 = tcg_temp_new_i64();
+    t2 = tcg_temp_new_i64();
+    tcg_gen_andc_i64(t1, m, a);
+    tcg_gen_andc_i64(t2, a, m);
+    tcg_gen_sub_i64(d, m, t2);
+    tcg_gen_xor_i64(d, d, t1);
+    tcg_temp_free_i64(m);
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t2);
+}
+
+void tcg_gen_gvec_neg(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t oprsz)
+{
+    static const GVecGen2 g = { gvec_neg8, tcg_gen_neg_vec, INDEX_op_sub_vec };
+    expand_2(vece, dofs, aofs, oprsz, &g);
+}
+
+static void gvec_add8(unsigned vece, TCGv_i64 d, TCGv_i64 a, TCGv_i64 b)
+{
+    uint64_t m = gvec_sign_mask(vece);
+    TCGv_i64 t1, t2, t3;
+
+    if (vece == VECE_64) {
+        tcg_gen_add_i64(d, a, b);
+        return;
+    }
+    t1 = tcg_temp_new_i64();
+    t2 = tcg_temp_new_i64();
+    t3 = tcg_temp_new_i64();
+    tcg_gen_andi_i64(t1, a, ~m);
+    tcg_gen_andi_i64(t2, b, ~m);
+    tcg_gen_xor_i64(t3, a, b);
+    tcg_gen_add_i64(d, t1, t2);
+    tcg_gen_andi_i64(t3, t3, m);
+    tcg_gen_xor_i64(d, d, t3);
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t2);
+    tcg_temp_free_i64(t3);
+}
+
+void tcg_gen_gvec_add(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t bofs, uint32_t oprsz)
+{
+    static const GVecGen3 g = { gvec_add8, NULL, tcg_gen_add_vec, INDEX_op_add_vec };
+    expand_3(vece, dofs, aofs, bofs, oprsz, &g);
+}
+
+static void gvec_sub8(unsigned vece, TCGv_i64 d, TCGv_i64 a, TCGv_i64 b)
+{
+    uint64_t m = gvec_sign_mask(vece);
+    TCGv_i64 t1, t2, t3;
+
+    if (vece == VECE_64) {
+        tcg_gen_sub_i64(d, a, b);
+        return;
+    }
+    t1 = tcg_temp_new_i64();
+    t2 = tcg_temp_new_i64();
+    t3 = tcg_temp_new_i64();
+    tcg_gen_ori_i64(t1, a, m);
+    tcg_gen_andi_i64(t2, b, ~m);
+    tcg_gen_eqv_i64(t3, a, b);
+    tcg_gen_sub_i64(d, t1, t2);
+    tcg_gen_andi_i64(t3, t3, m);
+    tcg_gen_xor_i64(d, d, t3);
+    tcg_temp_free_i64(t1);
+    tcg_temp_free_i64(t2);
+    tcg_temp_free_i64(t3);
+}
+
+void tcg_gen_gvec_sub(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t bofs, uint32_t oprsz)
+{
+    static const GVecGen3 g = { gvec_sub8, NULL, tcg_gen_sub_vec, INDEX_op_sub_vec };
+    expand_3(vece, dofs, aofs, bofs, oprsz, &g);
+}
+
+/* only for whole 64-bit elements, the smaller ones go through fni4 */
+static void gvec_mul8(unsigned vece, TCGv_i64 d, TCGv_i64 a, TCGv_i64 b)
+{
+    tcg_gen_mul_i64(d, a, b);
+}
+
+void tcg_gen_gvec_mul(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t bofs, uint32_t oprsz)
+{
+    static const GVecGen3 g = { gvec_mul8, tcg_gen_mul_i32, tcg_gen_mul_vec, INDEX_op_mul_vec };
+    expand_3(vece, dofs, aofs, bofs, oprsz, &g);
+}
+
+static void gvec_and8(unsigned vece, TCGv_i64 d, TCGv_i64 a, TCGv_i64 b)
+{
+    tcg_gen_and_i64(d, a, b);
+}
+
+void tcg_gen_gvec_and(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t bofs, uint32_t oprsz)
+{
+    static const GVecGen3 g = { gvec_and8, NULL, tcg_gen_and_vec, INDEX_op_and_vec };
+    expand_3(vece, dofs, aofs, bofs, oprsz, &g);
+}
+
+static void gvec_or8(unsigned vece, TCGv_i64 d, TCGv_i64 a, TCGv_i64 b)
+{
+    tcg_gen_or_i64(d, a, b);
+}
+
+void tcg_gen_gvec_or(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t bofs, uint32_t oprsz)
+{
+    static const GVecGen3 g = { gvec_or8, NULL, tcg_gen_or_vec, INDEX_op_or_vec };
+    expand_3(vece, dofs, aofs, bofs, oprsz, &g);
+}
+
+static void gvec_xor8(unsigned vece, TCGv_i64 d, TCGv_i64 a, TCGv_i64 b)
+{
+    tcg_gen_xor_i64(d, a, b);
+}
+
+void tcg_gen_gvec_xor(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t bofs, uint32_t oprsz)
+{
+    static const GVecGen3 g = { gvec_xor8, NULL, tcg_gen_xor_vec, INDEX_op_xor_vec };
+    expand_3(vece, dofs, aofs, bofs, oprsz, &g);
+}
+
+static void gvec_andc8(unsigned vece, TCGv_i64 d, TCGv_i64 a, TCGv_i64 b)
+{
+    tcg_gen_andc_i64(d, a, b);
+}
+
+void tcg_gen_gvec_andc(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t bofs, uint32_t oprsz)
+{
+    static const GVecGen3 g = { gvec_andc8, NULL, tcg_gen_andc_vec, INDEX_op_andc_vec };
+    expand_3(vece, dofs, aofs, bofs, oprsz, &g);
+}
+
+static void gvec_orc8(unsigned vece, TCGv_i64 d, TCGv_i64 a, TCGv_i64 b)
+{
+    tcg_gen_orc_i64(d, a, b);
+}
+
+void tcg_gen_gvec_orc(unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t bofs, uint32_t oprsz)
+{
+    static const GVecGen3 g = { gvec_orc8, NULL, tcg_gen_orc_vec, INDEX_op_or_vec };
+    expand_3(vece, dofs, aofs, bofs, oprsz, &g);
+}
+
+/* The bits shifted in from the neighbouring elements are masked off */
+static void gvec_shli8(unsigned vece, TCGv_i64 d, TCGv_i64 a, int64_t c)
+{
+    tcg_gen_shli_i64(d, a, c);
+    if (vece != VECE_64) {
+        tcg_gen_andi_i64(d, d, dup_const(vece, ~0ull << c));
+    }
+}
+
+void tcg_gen_gvec_shli(unsigned vece, uint32_t dofs, uint32_t aofs, int64_t shift, uint32_t oprsz)
+{
+    static const GVecGen2i g = { gvec_shli8, tcg_gen_shli_vec, INDEX_op_shli_vec };
+
+    assert(shift >= 0 && shift < (8 << vece));
+    expand_2i(vece, dofs, aofs, shift, oprsz, &g);
+}
+
+static void gvec_shri8(unsigned vece, TCGv_i64 d, TCGv_i64 a, int64_t c)
+{
+    tcg_gen_shri_i64(d, a, c);
+    if (vece != VECE_64) {
+        tcg_gen_andi_i64(d, d, dup_const(vece, (~0ull >> (64 - (8 << vece))) >> c));
+    }
+}
+
+void tcg_gen_gvec_shri(unsigned vece, uint32_t dofs, uint32_t aofs, int64_t shift, uint32_t oprsz)
+{
+    static const GVecGen2i g = { gvec_shri8, tcg_gen_shri_vec, INDEX_op_shri_vec };
+
+    assert(shift >= 0 && shift < (8 << vece));
+    expand_2i(vece, dofs, aofs, shift, oprsz, &g);
+}
+
+/* A logical shift, then the sign bits, now 'c' bits lower, are copied
+   over the 'c' bits above them by a multiplication. */
+static void gvec_sari8(unsigned vece, TCGv_i64 d, TCGv_i64 a, int64_t c)
+{
+    TCGv_i64 t0;
+
+    if (vece == VECE_64) {
+        tcg_gen_sari_i64(d, a, c);
+        return;
+    }
+    t0 = tcg_temp_new_i64();
+    tcg_gen_shri_i64(d, a, c);
+    tcg_gen_andi_i64(t0, d, dup_const(vece, (1ull << ((8 << vece) - 1)) >> c));
+    tcg_gen_muli_i64(t0, t0, (2ll << c) - 2);
+    tcg_gen_andi_i64(d, d, dup_const(vece, (~0ull >> (64 - (8 << vece))) >> c));
+    tcg_gen_or_i64(d, d, t0);
+    tcg_temp_free_i64(t0);
+}
+
+void tcg_gen_gvec_sari(unsigned vece, uint32_t dofs, uint32_t aofs, int64_t shift, uint32_t oprsz)
+{
+    static const GVecGen2i g = { gvec_sari8, tcg_gen_sari_vec, INDEX_op_sari_vec };
+
+    assert(shift >= 0 && shift < (8 << vece));
+    expand_2i(vece, dofs, aofs, shift, oprsz, &g);
+}
+
+void tcg_gen_gvec_cmp(TCGCond cond, unsigned vece, uint32_t dofs, uint32_t aofs, uint32_t bofs, uint32_t oprsz)
+{
+    TCGv_ptr env = tcg->ctx->env;
+    int sign = cond == TCG_COND_LT || cond == TCG_COND_GE || cond == TCG_COND_LE || cond == TCG_COND_GT;
+    TCGType type;
+    uint32_t i, j, size;
+
+    for (i = 0; i < oprsz; i += size) {
+        type = gvec_type(INDEX_op_cmp_vec, vece, oprsz - i);
+        size = gvec_type_size(type);
+        if (type != TCG_TYPE_I64) {
+            TCGv_vec t0 = tcg_temp_new_vec(type);
+            TCGv_vec t1 = tcg_temp_new_vec(type);
+            tcg_gen_ld_vec(t0, env, aofs + i);
+            tcg_gen_ld_vec(t1, env, bofs + i);
+            tcg_gen_cmp_vec(cond, vece, t0, t0, t1);
+            tcg_gen_st_vec(t0, env, dofs + i);
+            tcg_temp_free_vec(t0);
+            tcg_temp_free_vec(t1);
+        } else if (vece == VECE_64) {
+            TCGv_i64 t0 = tcg_temp_new_i64();
+            TCGv_i64 t1 = tcg_temp_new_i64();
+            tcg_gen_ld_i64(t0, env, aofs + i);
+            tcg_gen_ld_i64(t1, env, bofs + i);
+            tcg_gen_setcond_i64(cond, t0, t0, t1);
+            tcg_gen_neg_i64(t0, t0);
+            tcg_gen_st_i64(t0, env, dofs + i);
+            tcg_temp_free_i64(t0);
+            tcg_temp_free_i64(t1);
+        } else {
+            TCGv_i32 t0 = tcg_temp_new_i32();
+            TCGv_i32 t1 = tcg_temp_new_i32();
+            for (j = i; j < i + 8; j += 1 << vece) {
+                gvec_ld_elem_i32(vece, t0, aofs + j, sign);
+                gvec_ld_elem_i32(vece, t1, bofs + j, sign);
+                tcg_gen_setcond_i32(cond, t0, t0, t1);
+                tcg_gen_neg_i32(t0, t0);
+                gvec_st_elem_i32(vece, t0, dofs + j);
+            }
+            tcg_temp_free_i32(t0);
+            tcg_temp_free_i32(t1);
+        }
+    }
+}
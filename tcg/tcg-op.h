@@ -2017,32 +2017,208 @@ static inline void tcg_gen_deposit_i32(TCGv_i32 ret, TCGv_i32 arg1, TCGv_i32 arg
     tcg_temp_free_i32(t1);
 }
 
+/* ret = c1 cond c2 ? v1 : v2 */
 static inline void tcg_gen_movcond_i32(TCGCond cond, TCGv_i32 ret, TCGv_i32 c1, TCGv_i32 c2, TCGv_i32 v1, TCGv_i32 v2)
 {
-    assert(cond == TCG_COND_EQ);
-    TCGv_i32 t0 = tcg_temp_new_i32();
-    TCGv_i32 t1 = tcg_temp_new_i32();
-    tcg_gen_setcond_i32(cond, t0, c1, c2);
-    tcg_gen_neg_i32(t0, t0);
-    tcg_gen_and_i32(t1, v1, t0);
-    tcg_gen_andc_i32(ret, v2, t0);
-    tcg_gen_or_i32(ret, ret, t1);
-    tcg_temp_free_i32(t0);
-    tcg_temp_free_i32(t1);
+    if (TCG_TARGET_HAS_movcond_i32) {
+        tcg_gen_op6i_i32(INDEX_op_movcond_i32, ret, c1, c2, v1, v2, cond);
+    } else {
+        TCGv_i32 t0 = tcg_temp_new_i32();
+        TCGv_i32 t1 = tcg_temp_new_i32();
+        tcg_gen_setcond_i32(cond, t0, c1, c2);
+        tcg_gen_neg_i32(t0, t0);
+        tcg_gen_and_i32(t1, v1, t0);
+        tcg_gen_andc_i32(ret, v2, t0);
+        tcg_gen_or_i32(ret, ret, t1);
+        tcg_temp_free_i32(t0);
+        tcg_temp_free_i32(t1);
+    }
 }
 
 static inline void tcg_gen_movcond_i64(TCGCond cond, TCGv_i64 ret, TCGv_i64 c1, TCGv_i64 c2, TCGv_i64 v1, TCGv_i64 v2)
 {
-    assert(cond == TCG_COND_EQ);
-    TCGv_i64 t0 = tcg_temp_new_i64();
-    TCGv_i64 t1 = tcg_temp_new_i64();
-    tcg_gen_setcond_i64(cond, t0, c1, c2);
-    tcg_gen_neg_i64(t0, t0);
-    tcg_gen_and_i64(t1, v1, t0);
-    tcg_gen_andc_i64(ret, v2, t0);
-    tcg_gen_or_i64(ret, ret, t1);
+    if (TCG_TARGET_HAS_movcond_i64) {
+        tcg_gen_op6i_i64(INDEX_op_movcond_i64, ret, c1, c2, v1, v2, cond);
+    } else {
+        TCGv_i64 t0 = tcg_temp_new_i64();
+        TCGv_i64 t1 = tcg_temp_new_i64();
+        tcg_gen_setcond_i64(cond, t0, c1, c2);
+        tcg_gen_neg_i64(t0, t0);
+        tcg_gen_and_i64(t1, v1, t0);
+        tcg_gen_andc_i64(ret, v2, t0);
+        tcg_gen_or_i64(ret, ret, t1);
+        tcg_temp_free_i64(t0);
+        tcg_temp_free_i64(t1);
+    }
+}
+
+/* Count leading zeros of arg1, arg2 if it is zero */
+static inline void tcg_gen_clz_i32(TCGv_i32 ret, TCGv_i32 arg1, TCGv_i32 arg2)
+{
+    if (TCG_TARGET_HAS_clz_i32) {
+        tcg_gen_op3_i32(INDEX_op_clz_i32, ret, arg1, arg2);
+    } else {
+        int sizemask = 0;
+        /* Return value and both arguments are 32-bit and unsigned.  */
+        sizemask |= tcg_gen_sizemask(0, 0, 0);
+        sizemask |= tcg_gen_sizemask(1, 0, 0);
+        sizemask |= tcg_gen_sizemask(2, 0, 0);
+        tcg_gen_helper32(tcg_helper_clz_i32, sizemask, ret, arg1, arg2);
+    }
+}
+
+static inline void tcg_gen_clzi_i32(TCGv_i32 ret, TCGv_i32 arg1, uint32_t arg2)
+{
+    TCGv_i32 t0 = tcg_const_i32(arg2);
+    tcg_gen_clz_i32(ret, arg1, t0);
+    tcg_temp_free_i32(t0);
+}
+
+/* Count trailing zeros of arg1, arg2 if it is zero */
+static inline void tcg_gen_ctz_i32(TCGv_i32 ret, TCGv_i32 arg1, TCGv_i32 arg2)
+{
+    if (TCG_TARGET_HAS_ctz_i32) {
+        tcg_gen_op3_i32(INDEX_op_ctz_i32, ret, arg1, arg2);
+    } else {
+        int sizemask = 0;
+        /* Return value and both arguments are 32-bit and unsigned.  */
+        sizemask |= tcg_gen_sizemask(0, 0, 0);
+        sizemask |= tcg_gen_sizemask(1, 0, 0);
+        sizemask |= tcg_gen_sizemask(2, 0, 0);
+        tcg_gen_helper32(tcg_helper_ctz_i32, sizemask, ret, arg1, arg2);
+    }
+}
+
+static inline void tcg_gen_ctzi_i32(TCGv_i32 ret, TCGv_i32 arg1, uint32_t arg2)
+{
+    TCGv_i32 t0 = tcg_const_i32(arg2);
+    tcg_gen_ctz_i32(ret, arg1, t0);
+    tcg_temp_free_i32(t0);
+}
+
+static inline void tcg_gen_ctpop_i32(TCGv_i32 ret, TCGv_i32 arg)
+{
+    if (TCG_TARGET_HAS_ctpop_i32) {
+        tcg_gen_op2_i32(INDEX_op_ctpop_i32, ret, arg);
+    } else {
+        int sizemask = 0;
+        TCGArg args[1];
+        /* Return value and the argument are 32-bit and unsigned.  */
+        sizemask |= tcg_gen_sizemask(0, 0, 0);
+        sizemask |= tcg_gen_sizemask(1, 0, 0);
+        args[0] = GET_TCGV_I32(arg);
+        tcg_gen_helperN(tcg_helper_ctpop_i32, TCG_CALL_NO_RWG_SE, sizemask, GET_TCGV_I32(ret), 1, args);
+    }
+}
+
+static inline void tcg_gen_clz_i64(TCGv_i64 ret, TCGv_i64 arg1, TCGv_i64 arg2)
+{
+    if (TCG_TARGET_HAS_clz_i64) {
+        tcg_gen_op3_i64(INDEX_op_clz_i64, ret, arg1, arg2);
+    } else {
+        int sizemask = 0;
+        /* Return value and both arguments are 64-bit and unsigned.  */
+        sizemask |= tcg_gen_sizemask(0, 1, 0);
+        sizemask |= tcg_gen_sizemask(1, 1, 0);
+        sizemask |= tcg_gen_sizemask(2, 1, 0);
+        tcg_gen_helper64(tcg_helper_clz_i64, sizemask, ret, arg1, arg2);
+    }
+}
+
+static inline void tcg_gen_clzi_i64(TCGv_i64 ret, TCGv_i64 arg1, uint64_t arg2)
+{
+    TCGv_i64 t0 = tcg_const_i64(arg2);
+    tcg_gen_clz_i64(ret, arg1, t0);
     tcg_temp_free_i64(t0);
-    tcg_temp_free_i64(t1);
+}
+
+static inline void tcg_gen_ctz_i64(TCGv_i64 ret, TCGv_i64 arg1, TCGv_i64 arg2)
+{
+    if (TCG_TARGET_HAS_ctz_i64) {
+        tcg_gen_op3_i64(INDEX_op_ctz_i64, ret, arg1, arg2);
+    } else {
+        int sizemask = 0;
+        /* Return value and both arguments are 64-bit and unsigned.  */
+        sizemask |= tcg_gen_sizemask(0, 1, 0);
+        sizemask |= tcg_gen_sizemask(1, 1, 0);
+        sizemask |= tcg_gen_sizemask(2, 1, 0);
+        tcg_gen_helper64(tcg_helper_ctz_i64, sizemask, ret, arg1, arg2);
+    }
+}
+
+static inline void tcg_gen_ctzi_i64(TCGv_i64 ret, TCGv_i64 arg1, uint64_t arg2)
+{
+    TCGv_i64 t0 = tcg_const_i64(arg2);
+    tcg_gen_ctz_i64(ret, arg1, t0);
+    tcg_temp_free_i64(t0);
+}
+
+static inline void tcg_gen_ctpop_i64(TCGv_i64 ret, TCGv_i64 arg)
+{
+    if (TCG_TARGET_HAS_ctpop_i64) {
+        tcg_gen_op2_i64(INDEX_op_ctpop_i64, ret, arg);
+    } else {
+        int sizemask = 0;
+        TCGArg args[1];
+        /* Return value and the argument are 64-bit and unsigned.  */
+        sizemask |= tcg_gen_sizemask(0, 1, 0);
+        sizemask |= tcg_gen_sizemask(1, 1, 0);
+        args[0] = GET_TCGV_I64(arg);
+        tcg_gen_helperN(tcg_helper_ctpop_i64, TCG_CALL_NO_RWG_SE, sizemask, GET_TCGV_I64(ret), 1, args);
+    }
+}
+
+/* Extract the len bits of arg starting at bit ofs, zero or sign extended */
+static inline void tcg_gen_extract_i32(TCGv_i32 ret, TCGv_i32 arg, unsigned int ofs, unsigned int len)
+{
+    assert(len > 0 && ofs + len <= 32);
+    if (ofs + len == 32) {
+        tcg_gen_shri_i32(ret, arg, ofs);
+    } else if (TCG_TARGET_HAS_extract_i32) {
+        tcg_gen_op4ii_i32(INDEX_op_extract_i32, ret, arg, ofs, len);
+    } else {
+        tcg_gen_shri_i32(ret, arg, ofs);
+        tcg_gen_andi_i32(ret, ret, (1u << len) - 1);
+    }
+}
+
+static inline void tcg_gen_sextract_i32(TCGv_i32 ret, TCGv_i32 arg, unsigned int ofs, unsigned int len)
+{
+    assert(len > 0 && ofs + len <= 32);
+    if (ofs + len == 32) {
+        tcg_gen_sari_i32(ret, arg, ofs);
+    } else if (TCG_TARGET_HAS_sextract_i32) {
+        tcg_gen_op4ii_i32(INDEX_op_sextract_i32, ret, arg, ofs, len);
+    } else {
+        tcg_gen_shli_i32(ret, arg, 32 - ofs - len);
+        tcg_gen_sari_i32(ret, ret, 32 - len);
+    }
+}
+
+static inline void tcg_gen_extract_i64(TCGv_i64 ret, TCGv_i64 arg, unsigned int ofs, unsigned int len)
+{
+    assert(len > 0 && ofs + len <= 64);
+    if (ofs + len == 64) {
+        tcg_gen_shri_i64(ret, arg, ofs);
+    } else if (TCG_TARGET_HAS_extract_i64) {
+        tcg_gen_op4ii_i64(INDEX_op_extract_i64, ret, arg, ofs, len);
+    } else {
+        tcg_gen_shri_i64(ret, arg, ofs);
+        tcg_gen_andi_i64(ret, ret, (1ull << len) - 1);
+    }
+}
+
+static inline void tcg_gen_sextract_i64(TCGv_i64 ret, TCGv_i64 arg, unsigned int ofs, unsigned int len)
+{
+    assert(len > 0 && ofs + len <= 64);
+    if (ofs + len == 64) {
+        tcg_gen_sari_i64(ret, arg, ofs);
+    } else if (TCG_TARGET_HAS_sextract_i64) {
+        tcg_gen_op4ii_i64(INDEX_op_sextract_i64, ret, arg, ofs, len);
+    } else {
+        tcg_gen_shli_i64(ret, arg, 64 - ofs - len);
+        tcg_gen_sari_i64(ret, ret, 64 - len);
+    }
 }
 
 static inline void tcg_gen_deposit_i64(TCGv_i64 ret, TCGv_i64 arg1, TCGv_i64 arg2, unsigned int ofs, unsigned int len)
@@ -2241,6 +2417,14 @@ static inline void tcg_gen_goto_tb(int idx)
     tcg_gen_op1i(INDEX_op_goto_tb, idx);
 }
 
+/* Order the guest memory accesses of the kinds in 'type' (a TCGBar) */
+static inline void tcg_gen_mb(TCGBar type)
+{
+    if (TCG_TARGET_HAS_mb) {
+        tcg_gen_op1i(INDEX_op_mb, type);
+    }
+}
+
 #if TCG_TARGET_REG_BITS == 32
 static inline void tcg_gen_qemu_ld8u(TCGv ret, TCGv addr, int mem_index)
 {
@@ -2495,6 +2679,13 @@ static inline void tcg_gen_qemu_st64(TCGv_i64 arg, TCGv addr, int mem_index)
 #define tcg_gen_mulu2_tl      tcg_gen_mulu2_i64
 #define tcg_gen_muls2_tl      tcg_gen_muls2_i64
 #define tcg_gen_movcond_tl    tcg_gen_movcond_i64
+#define tcg_gen_clz_tl        tcg_gen_clz_i64
+#define tcg_gen_clzi_tl       tcg_gen_clzi_i64
+#define tcg_gen_ctz_tl        tcg_gen_ctz_i64
+#define tcg_gen_ctzi_tl       tcg_gen_ctzi_i64
+#define tcg_gen_ctpop_tl      tcg_gen_ctpop_i64
+#define tcg_gen_extract_tl    tcg_gen_extract_i64
+#define tcg_gen_sextract_tl   tcg_gen_sextract_i64
 #else
 #define tcg_gen_movi_tl       tcg_gen_movi_i32
 #define tcg_gen_mov_tl        tcg_gen_mov_i32
@@ -2569,6 +2760,13 @@ static inline void tcg_gen_qemu_st64(TCGv_i64 arg, TCGv addr, int mem_index)
 #define tcg_gen_mulu2_tl      tcg_gen_mulu2_i32
 #define tcg_gen_muls2_tl      tcg_gen_muls2_i32
 #define tcg_gen_movcond_tl    tcg_gen_movcond_i32
+#define tcg_gen_clz_tl        tcg_gen_clz_i32
+#define tcg_gen_clzi_tl       tcg_gen_clzi_i32
+#define tcg_gen_ctz_tl        tcg_gen_ctz_i32
+#define tcg_gen_ctzi_tl       tcg_gen_ctzi_i32
+#define tcg_gen_ctpop_tl      tcg_gen_ctpop_i32
+#define tcg_gen_extract_tl    tcg_gen_extract_i32
+#define tcg_gen_sextract_tl   tcg_gen_sextract_i32
 #endif
 
 #if TCG_TARGET_REG_BITS == 32
@@ -17,4 +17,11 @@ uint64_t tcg_helper_divu_i64(uint64_t arg1, uint64_t arg2);
 uint64_t tcg_helper_remu_i64(uint64_t arg1, uint64_t arg2);
 uint64_t tcg_helper_muluh_i64(uint64_t arg1, uint64_t arg2);
 
+uint32_t tcg_helper_clz_i32(uint32_t arg1, uint32_t arg2);
+uint32_t tcg_helper_ctz_i32(uint32_t arg1, uint32_t arg2);
+uint32_t tcg_helper_ctpop_i32(uint32_t arg);
+uint64_t tcg_helper_clz_i64(uint64_t arg1, uint64_t arg2);
+uint64_t tcg_helper_ctz_i64(uint64_t arg1, uint64_t arg2);
+uint64_t tcg_helper_ctpop_i64(uint64_t arg);
+
 #endif
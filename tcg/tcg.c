@@ -61,6 +61,9 @@ static void tcg_out_op(TCGContext *s, TCGOpcode opc, const TCGArg *args, const i
 static void tcg_out_st(TCGContext *s, TCGType type, TCGReg arg, TCGReg arg1, tcg_target_long arg2);
 static int tcg_target_const_match(tcg_target_long val, const TCGArgConstraint *arg_ct);
 static int tcg_target_get_call_iarg_regs_count(int flags);
+#ifdef TCG_TARGET_NEED_LDST_LABELS
+static void tcg_out_qemu_ldst_slow_path(TCGContext *s, TCGLabelQemuLdst *l);
+#endif
 
 TCGOpDef tcg_op_defs[] = {
 #define DEF(s, oargs, iargs, cargs, flags) { #s, oargs, iargs, cargs, iargs + oargs + cargs, flags },
@@ -69,7 +72,7 @@ TCGOpDef tcg_op_defs[] = {
 };
 const size_t tcg_op_defs_max = ARRAY_SIZE(tcg_op_defs);
 
-static TCGRegSet tcg_target_available_regs[2];
+static TCGRegSet tcg_target_available_regs[TCG_TYPE_COUNT];
 static TCGRegSet tcg_target_call_clobber_regs;
 
 /* XXX: move that inside the context */
@@ -141,18 +144,31 @@ int gen_new_label(void)
     int idx;
     TCGLabel *l;
 
-    if (s->nb_labels >= TCG_MAX_LABELS) {
-        tcg_abort();
+    if (s->nb_labels == s->allocated_labels) {
+        /* the old array stays in the pool until the end of the block */
+        l = tcg_malloc(sizeof(TCGLabel) * s->allocated_labels * 2);
+        memcpy(l, s->labels, sizeof(TCGLabel) * s->nb_labels);
+        s->labels = l;
+        s->allocated_labels *= 2;
     }
     idx = s->nb_labels++;
     l = &s->labels[idx];
     l->has_value = 0;
     l->u.first_reloc = NULL;
+    l->back_ref = 0;
+    l->reg_state = NULL;
     return idx;
 }
 
 #include "tcg-target.c"
 
+#if !TCG_TARGET_MAYBE_vec
+int tcg_can_emit_vec_op(TCGOpcode opc, TCGType type, unsigned vece)
+{
+    return 0;
+}
+#endif
+
 /* pool based memory allocation */
 void *tcg_malloc_internal(TCGContext *s, int size)
 {
@@ -160,15 +176,12 @@ void *tcg_malloc_internal(TCGContext *s, int size)
     int pool_size;
 
     if (size > TCG_POOL_CHUNK_SIZE) {
-        /* big malloc: insert a new pool (XXX: could optimize) */
+        /* big malloc: kept apart from the chunks and freed on reset */
         p = TCG_malloc(sizeof(TCGPool) + size);
         p->size = size;
-        if (s->pool_current) {
-            s->pool_current->next = p;
-        } else {
-            s->pool_first = p;
-        }
-        p->next = s->pool_current;
+        p->next = s->pool_first_large;
+        s->pool_first_large = p;
+        return p->data;
     } else {
         p = s->pool_current;
         if (!p) {
@@ -201,6 +214,13 @@ new_pool:
 
 void tcg_pool_reset(TCGContext *s)
 {
+    TCGPool *p, *next;
+
+    for (p = s->pool_first_large; p != NULL; p = next) {
+        next = p->next;
+        TCG_free(p);
+    }
+    s->pool_first_large = NULL;
     s->pool_cur = s->pool_end = NULL;
     s->pool_current = NULL;
 }
@@ -215,6 +235,7 @@ static void tcg_pool_free_inner(TCGPool *pool)
 
 static void tcg_pool_free(TCGContext *s)
 {
+    tcg_pool_reset(s);
     if (s->pool_first) {
         tcg_pool_free_inner(s->pool_first);
     }
@@ -222,22 +243,53 @@ static void tcg_pool_free(TCGContext *s)
 
 static uint8_t code_gen_prologue[1024] code_gen_section;
 static TCGContext ctx;
-static TCGArg gen_opparam_buf[OPPARAM_BUF_SIZE];
-static uint16_t gen_opc_buf[OPC_BUF_SIZE];
-static target_ulong gen_opc_pc[OPC_BUF_SIZE];
-static target_ulong gen_opc_additional[OPC_BUF_SIZE];
-static uint8_t gen_opc_instr_start[OPC_BUF_SIZE];
 
 void tcg_attach(tcg_t *c)
 {
     tcg = c;
     tcg->ctx = &ctx;
     tcg->code_gen_prologue = code_gen_prologue;
-    tcg->gen_opparam_buf = gen_opparam_buf;
-    tcg->gen_opc_buf = gen_opc_buf;
-    tcg->gen_opc_pc = gen_opc_pc;
-    tcg->gen_opc_additional = gen_opc_additional;
-    tcg->gen_opc_instr_start = gen_opc_instr_start;
+}
+
+static void tcg_op_buf_resize(int size)
+{
+    int old_size = tcg->gen_opc_buf_size;
+
+    tcg->gen_opc_buf = TCG_realloc(tcg->gen_opc_buf, size * sizeof(uint16_t));
+    tcg->gen_opparam_buf = TCG_realloc(tcg->gen_opparam_buf, size * MAX_OPC_PARAM * sizeof(TCGArg));
+    tcg->gen_opc_pc = TCG_realloc(tcg->gen_opc_pc, size * sizeof(target_ulong));
+    tcg->gen_opc_additional = TCG_realloc(tcg->gen_opc_additional, size * sizeof(target_ulong));
+    tcg->gen_opc_instr_start = TCG_realloc(tcg->gen_opc_instr_start, size);
+    memset(tcg->gen_opc_instr_start + old_size, 0, size - old_size);
+    tcg->gen_opc_buf_size = size;
+}
+
+/* Make room for 'count' more ops, growing the op buffers up to 'max_ops'
+   ops in total. Returns -1 if they would have to grow past it. Other
+   pointers into the buffers than gen_opc_ptr and gen_opparam_ptr do not
+   survive growing. */
+int tcg_op_buf_reserve(int count, int max_ops)
+{
+    int nb_ops = gen_opc_ptr - tcg->gen_opc_buf;
+    int nb_params = gen_opparam_ptr - tcg->gen_opparam_buf;
+    int size = tcg->gen_opc_buf_size;
+
+    if (nb_ops + count <= size) {
+        return 0;
+    }
+    if (nb_ops + count > max_ops) {
+        return -1;
+    }
+    while (size < nb_ops + count) {
+        size *= 2;
+    }
+    if (size > max_ops) {
+        size = max_ops;
+    }
+    tcg_op_buf_resize(size);
+    gen_opc_ptr = tcg->gen_opc_buf + nb_ops;
+    gen_opparam_ptr = tcg->gen_opparam_buf + nb_params;
+    return 0;
 }
 
 void tcg_context_init()
@@ -249,8 +301,10 @@ void tcg_context_init()
     int *sorted_args;
 
     memset(s, 0, sizeof(*s));
-    s->temps = s->static_temps;
+    s->temps = TCG_malloc(sizeof(TCGTemp) * TCG_INITIAL_TEMPS);
+    s->allocated_temps = TCG_INITIAL_TEMPS;
     s->nb_globals = 0;
+    tcg_op_buf_resize(OPC_BUF_SIZE);
 
     /* Count total number of arguments and allocate the corresponding
        space */
@@ -281,15 +335,27 @@ void tcg_dispose()
     TCG_free(tcg_op_defs[0].sorted_args);
     tcg_pool_free(tcg->ctx);
     TCG_free(tcg->ctx->helpers);
+    TCG_free(tcg->ctx->temps);
+    TCG_free(tcg->gen_opc_buf);
+    TCG_free(tcg->gen_opparam_buf);
+    TCG_free(tcg->gen_opc_pc);
+    TCG_free(tcg->gen_opc_additional);
+    TCG_free(tcg->gen_opc_instr_start);
+    tcg->gen_opc_buf = NULL;
+    tcg->gen_opparam_buf = NULL;
+    tcg->gen_opc_pc = NULL;
+    tcg->gen_opc_additional = NULL;
+    tcg->gen_opc_instr_start = NULL;
+    tcg->gen_opc_buf_size = 0;
 }
 
 void tcg_prologue_init()
 {
     /* init global prologue and epilogue */
-    tcg->ctx->code_buf = tcg->code_gen_prologue;
+    tcg->ctx->code_buf = tcg_code_rw(tcg->code_gen_prologue);
     tcg->ctx->code_ptr = tcg->ctx->code_buf;
     tcg_target_qemu_prologue(tcg->ctx);
-    flush_icache_range((uintptr_t)tcg->ctx->code_buf, (uintptr_t)tcg->ctx->code_ptr);
+    flush_icache_range((uintptr_t)tcg->code_gen_prologue, (uintptr_t)tcg_code_rx(tcg->ctx->code_ptr));
 }
 
 void tcg_set_frame(TCGContext *s, int reg, tcg_target_long start, tcg_target_long size)
@@ -307,7 +373,8 @@ void tcg_func_start(TCGContext *s)
     for (i = 0; i < (TCG_TYPE_COUNT * 2); i++) {
         s->first_free_temp[i] = -1;
     }
-    s->labels = tcg_malloc(sizeof(TCGLabel) * TCG_MAX_LABELS);
+    s->labels = tcg_malloc(sizeof(TCGLabel) * TCG_INITIAL_LABELS);
+    s->allocated_labels = TCG_INITIAL_LABELS;
     s->nb_labels = 0;
     s->current_frame_offset = s->frame_start;
 
@@ -317,9 +384,22 @@ void tcg_func_start(TCGContext *s)
 
 static inline void tcg_temp_alloc(TCGContext *s, int n)
 {
+    int size = s->allocated_temps;
+
+    if (n <= size) {
+        return;
+    }
     if (n > TCG_MAX_TEMPS) {
         tcg_abort();
     }
+    while (size < n) {
+        size *= 2;
+    }
+    if (size > TCG_MAX_TEMPS) {
+        size = TCG_MAX_TEMPS;
+    }
+    s->temps = TCG_realloc(s->temps, sizeof(TCGTemp) * size);
+    s->allocated_temps = size;
 }
 
 static inline int tcg_global_reg_new_internal(TCGType type, int reg, const char *name)
@@ -527,6 +607,15 @@ static inline void tcg_temp_free_internal(int idx)
     s->first_free_temp[k] = idx;
 }
 
+TCGv_vec tcg_temp_new_vec(TCGType type)
+{
+    int idx;
+
+    assert(type >= TCG_TYPE_V64 && type <= TCG_TYPE_V256);
+    idx = tcg_temp_new_internal(type, 0);
+    return MAKE_TCGV_VEC(idx);
+}
+
 void tcg_temp_free_i32(TCGv_i32 arg)
 {
     tcg_temp_free_internal(GET_TCGV_I32(arg));
@@ -537,6 +626,11 @@ void tcg_temp_free_i64(TCGv_i64 arg)
     tcg_temp_free_internal(GET_TCGV_I64(arg));
 }
 
+void tcg_temp_free_vec(TCGv_vec arg)
+{
+    tcg_temp_free_internal(GET_TCGV_VEC(arg));
+}
+
 TCGv_i32 tcg_const_i32(int32_t val)
 {
     TCGv_i32 t0;
@@ -870,6 +964,157 @@ static const char * const cond_name[] =
 
 /* *INDENT-ON* */
 
+const char *tcg_helper_get_name(TCGContext *s, void *func)
+{
+    TCGHelperInfo *th;
+
+    th = tcg_find_helper(s, (tcg_target_ulong)func);
+    return th != NULL ? th->name : NULL;
+}
+
+static void tcg_dump_arg(TCGContext *s, FILE *outfile, int k, TCGArg arg, int dead)
+{
+    char buf[128];
+
+    if (arg == TCG_CALL_DUMMY_ARG) {
+        fprintf(outfile, "%s<dummy>", k ? "," : " ");
+        return;
+    }
+    fprintf(outfile, "%s%s%s", k ? "," : " ", tcg_get_arg_str_idx(s, buf, sizeof(buf), arg), dead ? "*" : "");
+}
+
+/* Write the ops of the block being generated to 'outfile', one per line.
+   With 'liveness', which needs tcg_liveness_analysis to have run, the
+   arguments dying at an op are marked with a '*', the registers its
+   outputs are next used in follow "pref=" and the temps that may be live
+   after a branch or a label follow "live:". */
+static void tcg_dump_ops_common(TCGContext *s, FILE *outfile, int liveness)
+{
+    const TCGOpDef *def;
+    const TCGArg *args;
+    const char *name;
+    TCGOpcode c;
+    unsigned int dead_args;
+    int op_index, i, k, nb_oargs, nb_iargs, nb_cargs, nb_args, label_arg;
+    tcg_target_ulong *movi_value;
+    uint8_t *movi_known;
+    uint8_t *dead_temps;
+    char buf[128];
+
+    /* the helper called is named after the constant moved to its temp */
+    movi_value = tcg_malloc(s->nb_temps * sizeof(tcg_target_ulong));
+    movi_known = tcg_malloc(s->nb_temps);
+    memset(movi_known, 0, s->nb_temps);
+
+    args = tcg->gen_opparam_buf;
+    for (op_index = 0; (c = tcg->gen_opc_buf[op_index]) != INDEX_op_end; op_index++) {
+        def = &tcg_op_defs[c];
+        dead_args = liveness ? s->op_dead_args[op_index] : 0;
+        switch (c) {
+        case INDEX_op_nop:
+        case INDEX_op_nop1:
+        case INDEX_op_nop2:
+        case INDEX_op_nop3:
+            args += def->nb_args;
+            continue;
+        case INDEX_op_nopn:
+            args += args[0];
+            continue;
+        case INDEX_op_call:
+            nb_oargs = args[0] >> 16;
+            nb_iargs = args[0] & 0xffff;
+            nb_args = nb_oargs + nb_iargs + 3;
+            args++;
+            i = args[nb_oargs + nb_iargs - 1];
+            name = movi_known[i] ? tcg_helper_get_name(s, (void *)movi_value[i]) : NULL;
+            if (name != NULL) {
+                fprintf(outfile, " call %s", name);
+            } else if (movi_known[i]) {
+                fprintf(outfile, " call $0x%" PRIx64, (uint64_t)movi_value[i]);
+            } else {
+                fprintf(outfile, " call ?");
+            }
+            fprintf(outfile, ",$0x%" PRIx64, (uint64_t)args[nb_oargs + nb_iargs]);
+            for (i = 0; i < nb_oargs + nb_iargs; i++) {
+                tcg_dump_arg(s, outfile, 1, args[i], (dead_args >> i) & 1);
+            }
+            args += nb_args - 1;
+            break;
+        default:
+            nb_oargs = def->nb_oargs;
+            nb_iargs = def->nb_iargs;
+            nb_cargs = def->nb_cargs;
+            fprintf(outfile, " %s", def->name);
+            for (i = 0; i < nb_oargs + nb_iargs; i++) {
+                tcg_dump_arg(s, outfile, i, args[i], (dead_args >> i) & 1);
+            }
+            k = nb_oargs + nb_iargs;
+            label_arg = -1;
+            switch (c) {
+            case INDEX_op_set_label:
+            case INDEX_op_br:
+                label_arg = 0;
+                break;
+            case INDEX_op_brcond_i32:
+            case INDEX_op_brcond_i64:
+            case INDEX_op_brcond2_i32:
+            case INDEX_op_setcond_i32:
+            case INDEX_op_setcond_i64:
+            case INDEX_op_setcond2_i32:
+            case INDEX_op_movcond_i32:
+            case INDEX_op_movcond_i64:
+            case INDEX_op_cmp_vec:
+                if (args[k] < ARRAY_SIZE(cond_name) && cond_name[args[k]] != NULL) {
+                    fprintf(outfile, "%s%s", k ? "," : " ", cond_name[args[k]]);
+                } else {
+                    fprintf(outfile, "%s$0x%" PRIx64, k ? "," : " ", (uint64_t)args[k]);
+                }
+                if (def->flags & TCG_OPF_BB_END) {
+                    label_arg = k + 1;
+                }
+                k++;
+                break;
+            case INDEX_op_movi_i32:
+            case INDEX_op_movi_i64:
+                movi_value[args[0]] = args[1];
+                movi_known[args[0]] = 1;
+                break;
+            default:
+                break;
+            }
+            for (; k < nb_oargs + nb_iargs + nb_cargs; k++) {
+                if (k == label_arg) {
+                    fprintf(outfile, "%s$L%d", k ? "," : " ", (int)args[k]);
+                } else {
+                    fprintf(outfile, "%s$0x%" PRIx64, k ? "," : " ", (uint64_t)args[k]);
+                }
+            }
+            for (i = 0; liveness && i < nb_oargs && i < TCG_MAX_OUTPUT_PREFS; i++) {
+                if (s->op_output_pref[op_index * TCG_MAX_OUTPUT_PREFS + i]) {
+                    fprintf(outfile, " pref=0x%" PRIx64, (uint64_t)s->op_output_pref[op_index * TCG_MAX_OUTPUT_PREFS + i]);
+                }
+            }
+            args += def->nb_args;
+            break;
+        }
+        dead_temps = liveness ? s->op_dead_temps[op_index] : NULL;
+        if (dead_temps != NULL && (c == INDEX_op_set_label || (def->flags & TCG_OPF_BB_END))) {
+            fprintf(outfile, "  live:");
+            for (i = 0; i < s->nb_temps; i++) {
+                if (!dead_temps[i]) {
+                    fprintf(outfile, " %s", tcg_get_arg_str_idx(s, buf, sizeof(buf), i));
+                }
+            }
+        }
+        fprintf(outfile, "\n");
+    }
+}
+
+void tcg_dump_ops(TCGContext *s, FILE *outfile)
+{
+    tcg_dump_ops_common(s, outfile, 0);
+}
+
 /* we give more priority to constraints with less registers */
 static int get_constraint_priority(const TCGOpDef *def, int k)
 {
@@ -996,55 +1241,142 @@ static inline void tcg_set_nop(TCGContext *s, uint16_t *opc_ptr, TCGArg *args, i
     }
 }
 
+/* label a branch operation jumps to, -1 if none */
+static inline int tcg_op_branch_label(TCGOpcode op, const TCGArg *args)
+{
+    switch (op) {
+    case INDEX_op_br:
+        return args[0];
+    case INDEX_op_brcond_i32:
+    case INDEX_op_brcond_i64:
+        return args[3];
+    case INDEX_op_brcond2_i32:
+        return args[5];
+    default:
+        return -1;
+    }
+}
+
 /* liveness analysis: end of function: globals are live, temps are
    dead. */
-/* XXX: at this stage, not used as there would be little gains because
-   most TBs end with a conditional jump. */
 static inline void tcg_la_func_end(TCGContext *s, uint8_t *dead_temps)
 {
     memset(dead_temps, 0, s->nb_globals);
     memset(dead_temps + s->nb_globals, 1, s->nb_temps - s->nb_globals);
 }
 
-/* liveness analysis: end of basic block: globals are live, temps are
-   dead, local temps are live. */
+/* liveness analysis: end of basic block: temps are dead, globals and
+   local temps are live if they are in one of the successors. */
 static inline void tcg_la_bb_end(TCGContext *s, uint8_t *dead_temps)
 {
     int i;
-    TCGTemp *ts;
 
-    memset(dead_temps, 0, s->nb_globals);
-    ts = &s->temps[s->nb_globals];
     for (i = s->nb_globals; i < s->nb_temps; i++) {
-        if (ts->temp_local) {
-            dead_temps[i] = 0;
-        } else {
+        if (!s->temps[i].temp_local) {
             dead_temps[i] = 1;
         }
-        ts++;
     }
 }
 
-/* Liveness analysis : update the opc_dead_args array to tell if a
-   given input arguments is dead. Instructions updating dead
-   temporaries are removed. */
-static void tcg_liveness_analysis(TCGContext *s)
+/* liveness analysis: add the temps live at a label to the ones live
+   after a branch to it. In the first pass, nothing is known to be live
+   at the loop heads yet. */
+static inline void tcg_la_branch_to(TCGContext *s, uint8_t *dead_temps, const uint8_t *label_dead_temps)
+{
+    int i;
+
+    if (label_dead_temps == NULL) {
+        return;
+    }
+    for (i = 0; i < s->nb_temps; i++) {
+        dead_temps[i] &= label_dead_temps[i];
+    }
+}
+
+/* Temps live across an operation that clobbers the call clobbered
+   registers are better kept in the other ones. Globals are only
+   included if they can stay in registers over the operation. */
+static inline void tcg_la_call_clobber(TCGContext *s, const uint8_t *dead_temps, TCGRegSet *temp_pref, int first_temp)
+{
+    TCGRegSet pref;
+    int i;
+
+    for (i = first_temp; i < s->nb_temps; i++) {
+        if (dead_temps[i] || s->temps[i].fixed_reg) {
+            continue;
+        }
+        pref = temp_pref[i] ? temp_pref[i] : tcg_target_available_regs[s->temps[i].type];
+        tcg_regset_andnot(pref, pref, tcg_target_call_clobber_regs);
+        if (pref) {
+            temp_pref[i] = pref;
+        }
+    }
+}
+
+/* Find the labels a branch follows, they are loop heads. Return their
+   number. */
+static int tcg_la_find_back_refs(TCGContext *s)
 {
-    int i, op_index, nb_args, nb_iargs, nb_oargs, arg, nb_ops;
+    int op_index, label_index, nb_back_refs;
+    uint8_t *label_placed;
     TCGOpcode op;
-    TCGArg *args;
+    const TCGArg *args;
     const TCGOpDef *def;
-    uint8_t *dead_temps;
-    unsigned int dead_args;
 
-    gen_opc_ptr++; /* skip end */
+    label_placed = tcg_malloc(s->nb_labels);
+    memset(label_placed, 0, s->nb_labels);
+    nb_back_refs = 0;
 
-    nb_ops = gen_opc_ptr - tcg->gen_opc_buf;
+    args = tcg->gen_opparam_buf;
+    for (op_index = 0; (op = tcg->gen_opc_buf[op_index]) != INDEX_op_end; op_index++) {
+        def = &tcg_op_defs[op];
+        switch (op) {
+        case INDEX_op_call:
+            args += (args[0] >> 16) + (args[0] & 0xffff) + def->nb_cargs + 1;
+            break;
+        case INDEX_op_nopn:
+            args += args[0];
+            break;
+        case INDEX_op_set_label:
+            label_placed[args[0]] = 1;
+            args += def->nb_args;
+            break;
+        default:
+            if (def->flags & TCG_OPF_BB_END) {
+                label_index = tcg_op_branch_label(op, args);
+                if (label_index >= 0 && label_placed[label_index] && !s->labels[label_index].back_ref) {
+                    s->labels[label_index].back_ref = 1;
+                    nb_back_refs++;
+                }
+            }
+            args += def->nb_args;
+            break;
+        }
+    }
+    return nb_back_refs;
+}
 
-    s->op_dead_args = tcg_malloc(nb_ops * sizeof(uint16_t));
+/* One backward pass of the liveness analysis over the TB. The temps
+   live at each label are kept in 'label_dead_temps' for the branches
+   to it. If 'final' is not set, nothing is removed and the return value
+   tells if the temps live at a loop head changed, in which case the
+   branches to it saw an old state and the pass has to be run again. */
+static int tcg_liveness_pass(TCGContext *s, int nb_ops, uint8_t **label_dead_temps, int final)
+{
+    int i, op_index, nb_args, nb_iargs, nb_oargs, arg, label_index, changed;
+    TCGOpcode op;
+    TCGArg *args;
+    const TCGOpDef *def;
+    uint8_t *dead_temps;
+    TCGRegSet *temp_pref;
+    TCGRegSet pref;
+    unsigned int dead_args;
 
     dead_temps = tcg_malloc(s->nb_temps);
     memset(dead_temps, 1, s->nb_temps);
+    temp_pref = tcg_malloc(s->nb_temps * sizeof(TCGRegSet));
+    memset(temp_pref, 0, s->nb_temps * sizeof(TCGRegSet));
+    changed = 0;
 
     args = gen_opparam_ptr;
     op_index = nb_ops - 1;
@@ -1054,7 +1386,7 @@ static void tcg_liveness_analysis(TCGContext *s)
         switch (op) {
         case INDEX_op_call:
         {
-            int call_flags;
+            int call_flags, nb_regs;
 
             nb_args = args[-1];
             args -= nb_args;
@@ -1063,16 +1395,18 @@ static void tcg_liveness_analysis(TCGContext *s)
             args++;
             call_flags = args[nb_oargs + nb_iargs];
 
-            /* pure functions can be removed if their result is not
-               used */
-            if (call_flags & TCG_CALL_PURE) {
+            /* calls without side effects can be removed if their result
+               is not used */
+            if (call_flags & TCG_CALL_NO_SIDE_EFFECTS) {
                 for (i = 0; i < nb_oargs; i++) {
                     arg = args[i];
                     if (!dead_temps[arg]) {
                         goto do_not_remove_call;
                     }
                 }
-                tcg_set_nop(s, tcg->gen_opc_buf + op_index, args - 1, nb_args);
+                if (final) {
+                    tcg_set_nop(s, tcg->gen_opc_buf + op_index, args - 1, nb_args);
+                }
             } else {
 do_not_remove_call:
 
@@ -1084,19 +1418,31 @@ do_not_remove_call:
                         dead_args |= (1 << i);
                     }
                     dead_temps[arg] = 1;
+                    temp_pref[arg] = 0;
                 }
 
-                if (!(call_flags & TCG_CALL_CONST)) {
+                /* globals stay in registers over calls that do not
+                   write them */
+                tcg_la_call_clobber(s, dead_temps, temp_pref,
+                                    call_flags & (TCG_CALL_NO_READ_GLOBALS | TCG_CALL_NO_WRITE_GLOBALS) ? 0 : s->nb_globals);
+
+                if (!(call_flags & TCG_CALL_NO_READ_GLOBALS)) {
                     /* globals are live (they may be used by the call) */
                     memset(dead_temps, 0, s->nb_globals);
                 }
 
-                /* input args are live */
+                /* input args are live, the ones used for the last time
+                   are best computed in their argument register */
+                nb_regs = tcg_target_get_call_iarg_regs_count(call_flags);
                 for (i = nb_oargs; i < nb_iargs + nb_oargs; i++) {
                     arg = args[i];
                     if (arg != TCG_CALL_DUMMY_ARG) {
                         if (dead_temps[arg]) {
                             dead_args |= (1 << i);
+                            if (i - nb_oargs < nb_regs && i - nb_oargs < nb_iargs - 1) {
+                                tcg_regset_clear(temp_pref[arg]);
+                                tcg_regset_set_reg(temp_pref[arg], tcg_target_call_iarg_regs[i - nb_oargs]);
+                            }
                         }
                         dead_temps[arg] = 0;
                     }
@@ -1110,6 +1456,17 @@ do_not_remove_call:
             args--;
             /* mark end of basic block */
             tcg_la_bb_end(s, dead_temps);
+            memset(temp_pref, 0, s->nb_temps * sizeof(TCGRegSet));
+            label_index = args[0];
+            if (label_dead_temps[label_index] == NULL) {
+                label_dead_temps[label_index] = tcg_malloc(s->nb_temps);
+                memset(label_dead_temps[label_index], 1, s->nb_temps);
+            }
+            if (s->labels[label_index].back_ref && memcmp(label_dead_temps[label_index], dead_temps, s->nb_temps)) {
+                changed = 1;
+            }
+            memcpy(label_dead_temps[label_index], dead_temps, s->nb_temps);
+            s->op_dead_temps[op_index] = label_dead_temps[label_index];
             break;
         case INDEX_op_nopn:
             nb_args = args[-1];
@@ -1138,7 +1495,9 @@ do_not_remove_call:
                         goto do_not_remove;
                     }
                 }
-                tcg_set_nop(s, tcg->gen_opc_buf + op_index, args, def->nb_args);
+                if (final) {
+                    tcg_set_nop(s, tcg->gen_opc_buf + op_index, args, def->nb_args);
+                }
             } else {
 do_not_remove:
 
@@ -1150,12 +1509,34 @@ do_not_remove:
                         dead_args |= (1 << i);
                     }
                     dead_temps[arg] = 1;
+                    if (i < TCG_MAX_OUTPUT_PREFS) {
+                        s->op_output_pref[op_index * TCG_MAX_OUTPUT_PREFS + i] = temp_pref[arg];
+                    }
+                    temp_pref[arg] = 0;
                 }
 
                 /* if end of basic block, update */
                 if (def->flags & TCG_OPF_BB_END) {
-                    tcg_la_bb_end(s, dead_temps);
+                    label_index = tcg_op_branch_label(op, args);
+                    if (op == INDEX_op_br) {
+                        memset(dead_temps, 1, s->nb_temps);
+                        tcg_la_branch_to(s, dead_temps, label_dead_temps[label_index]);
+                    } else if (label_index >= 0) {
+                        tcg_la_branch_to(s, dead_temps, label_dead_temps[label_index]);
+                        tcg_la_bb_end(s, dead_temps);
+                    } else if (op == INDEX_op_goto_tb) {
+                        /* the jump leaves the TB or falls through */
+                        memset(dead_temps, 0, s->nb_globals);
+                        tcg_la_bb_end(s, dead_temps);
+                    } else {
+                        tcg_la_func_end(s, dead_temps);
+                    }
+                    memset(temp_pref, 0, s->nb_temps * sizeof(TCGRegSet));
+                    s->op_dead_temps[op_index] = tcg_malloc(s->nb_temps);
+                    memcpy(s->op_dead_temps[op_index], dead_temps, s->nb_temps);
                 } else if (def->flags & TCG_OPF_CALL_CLOBBER) {
+                    /* globals are saved, only temps can stay in registers */
+                    tcg_la_call_clobber(s, dead_temps, temp_pref, s->nb_globals);
                     /* globals are live */
                     memset(dead_temps, 0, s->nb_globals);
                 }
@@ -1165,7 +1546,15 @@ do_not_remove:
                     arg = args[i];
                     if (dead_temps[arg]) {
                         dead_args |= (1 << i);
+                        if ((op == INDEX_op_mov_i32 || op == INDEX_op_mov_i64 || op == INDEX_op_mov_vec) && i == 1) {
+                            /* the move is done by renaming the register */
+                            temp_pref[arg] = s->op_output_pref[op_index * TCG_MAX_OUTPUT_PREFS];
+                            dead_temps[arg] = 0;
+                            continue;
+                        }
                     }
+                    tcg_regset_and(pref, temp_pref[arg], def->args_ct[i].u.regs);
+                    temp_pref[arg] = pref ? pref : def->args_ct[i].u.regs;
                     dead_temps[arg] = 0;
                 }
                 s->op_dead_args[op_index] = dead_args;
@@ -1178,34 +1567,107 @@ do_not_remove:
     if (args != tcg->gen_opparam_buf) {
         tcg_abort();
     }
+    return changed;
+}
+
+/* Liveness analysis : update the opc_dead_args array to tell if a
+   given input arguments is dead. Instructions updating dead
+   temporaries are removed. Along the way, find the registers the
+   outputs of each operation are next used in and the temps that are
+   dead after each branch and label. The branches within the TB are
+   followed, so the globals and local temps that are not used on any
+   path after a branch are not kept alive by it. */
+static void tcg_liveness_analysis(TCGContext *s)
+{
+    int nb_ops;
+    uint8_t **label_dead_temps;
+
+    gen_opc_ptr++; /* skip end */
+
+    nb_ops = gen_opc_ptr - tcg->gen_opc_buf;
+
+    s->op_dead_args = tcg_malloc(nb_ops * sizeof(uint16_t));
+    s->op_output_pref = tcg_malloc(nb_ops * TCG_MAX_OUTPUT_PREFS * sizeof(TCGRegSet));
+    memset(s->op_output_pref, 0, nb_ops * TCG_MAX_OUTPUT_PREFS * sizeof(TCGRegSet));
+    s->op_dead_temps = tcg_malloc(nb_ops * sizeof(uint8_t *));
+
+    label_dead_temps = tcg_malloc(s->nb_labels * sizeof(uint8_t *));
+    memset(label_dead_temps, 0, s->nb_labels * sizeof(uint8_t *));
+
+    /* loops are iterated until the temps live at their heads settle */
+    if (tcg_la_find_back_refs(s) != 0) {
+        while (tcg_liveness_pass(s, nb_ops, label_dead_temps, 0)) {
+        }
+    }
+    tcg_liveness_pass(s, nb_ops, label_dead_temps, 1);
 }
 #else
 /* dummy liveness analysis */
 static void tcg_liveness_analysis(TCGContext *s)
 {
     int nb_ops;
+    int i;
     nb_ops = gen_opc_ptr - tcg->gen_opc_buf;
 
     s->op_dead_args = tcg_malloc(nb_ops * sizeof(uint16_t));
     memset(s->op_dead_args, 0, nb_ops * sizeof(uint16_t));
+    s->op_output_pref = tcg_malloc(nb_ops * TCG_MAX_OUTPUT_PREFS * sizeof(TCGRegSet));
+    memset(s->op_output_pref, 0, nb_ops * TCG_MAX_OUTPUT_PREFS * sizeof(TCGRegSet));
+    s->op_dead_temps = tcg_malloc(nb_ops * sizeof(uint8_t *));
+    memset(s->op_dead_temps, 0, nb_ops * sizeof(uint8_t *));
+    /* without liveness, every label may be a loop head */
+    for (i = 0; i < s->nb_labels; i++) {
+        s->labels[i].back_ref = 1;
+    }
 }
 #endif
 
 static void temp_allocate_frame(TCGContext *s, int temp)
 {
     TCGTemp *ts;
+    tcg_target_long size, align;
+
     ts = &s->temps[temp];
+    switch (ts->type) {
+    case TCG_TYPE_V64:
+        size = 8;
+        break;
+    case TCG_TYPE_V128:
+        size = 16;
+        break;
+    case TCG_TYPE_V256:
+        size = 32;
+        break;
+    default:
+        size = sizeof(tcg_target_long);
+        break;
+    }
+    /* the stack pointer is not aligned any further */
+    align = size < 16 ? size : 16;
 #ifndef __sparc_v9__ /* Sparc64 stack is accessed with offset of 2047 */
-    s->current_frame_offset = (s->current_frame_offset + (tcg_target_long)sizeof(tcg_target_long) - 1) &
-                              ~(sizeof(tcg_target_long) - 1);
+    s->current_frame_offset = (s->current_frame_offset + align - 1) & ~(align - 1);
 #endif
-    if (s->current_frame_offset + (tcg_target_long)sizeof(tcg_target_long) > s->frame_end) {
+    if (s->current_frame_offset + size > s->frame_end) {
         tcg_abort();
     }
     ts->mem_offset = s->current_frame_offset;
     ts->mem_reg = s->frame_reg;
     ts->mem_allocated = 1;
-    s->current_frame_offset += (tcg_target_long)sizeof(tcg_target_long);
+    s->current_frame_offset += size;
+}
+
+/* Loads and stores of temps to their memory slots, counted for the
+   statistics. */
+static inline void temp_load(TCGContext *s, TCGTemp *ts, int reg)
+{
+    tcg_out_ld(s, ts->type, reg, ts->mem_reg, ts->mem_offset);
+    s->reg_reloads++;
+}
+
+static inline void temp_store(TCGContext *s, TCGTemp *ts, int reg)
+{
+    tcg_out_st(s, ts->type, reg, ts->mem_reg, ts->mem_offset);
+    s->reg_spills++;
 }
 
 /* free register 'reg' by spilling the corresponding temporary if necessary */
@@ -1222,22 +1684,32 @@ static void tcg_reg_free(TCGContext *s, int reg)
             if (!ts->mem_allocated) {
                 temp_allocate_frame(s, temp);
             }
-            tcg_out_st(s, ts->type, reg, ts->mem_reg, ts->mem_offset);
+            temp_store(s, ts, reg);
         }
         ts->val_type = TEMP_VAL_MEM;
         s->reg_to_temp[reg] = -1;
     }
 }
 
-/* Allocate a register belonging to reg1 & ~reg2 */
-static int tcg_reg_alloc(TCGContext *s, TCGRegSet reg1, TCGRegSet reg2)
+/* Allocate a register belonging to reg1 & ~reg2, one of 'preferred' if
+   possible */
+static int tcg_reg_alloc(TCGContext *s, TCGRegSet reg1, TCGRegSet reg2, TCGRegSet preferred)
 {
     int i, reg;
-    TCGRegSet reg_ct;
+    TCGRegSet reg_ct, reg_pref;
 
     tcg_regset_andnot(reg_ct, reg1, reg2);
-
-    /* first try free registers */
+    tcg_regset_and(reg_pref, reg_ct, preferred);
+
+    /* first try free registers, the preferred ones first */
+    if (reg_pref) {
+        for (i = 0; i < ARRAY_SIZE(tcg_target_reg_alloc_order); i++) {
+            reg = tcg_target_reg_alloc_order[i];
+            if (tcg_regset_test_reg(reg_pref, reg) && s->reg_to_temp[reg] == -1) {
+                return reg;
+            }
+        }
+    }
     for (i = 0; i < ARRAY_SIZE(tcg_target_reg_alloc_order); i++) {
         reg = tcg_target_reg_alloc_order[i];
         if (tcg_regset_test_reg(reg_ct, reg) && s->reg_to_temp[reg] == -1) {
@@ -1245,7 +1717,14 @@ static int tcg_reg_alloc(TCGContext *s, TCGRegSet reg1, TCGRegSet reg2)
         }
     }
 
-    /* XXX: do better spill choice */
+    /* then spill a temp that does not need to be stored */
+    for (i = 0; i < ARRAY_SIZE(tcg_target_reg_alloc_order); i++) {
+        reg = tcg_target_reg_alloc_order[i];
+        if (tcg_regset_test_reg(reg_ct, reg) && s->temps[s->reg_to_temp[reg]].mem_coherent) {
+            tcg_reg_free(s, reg);
+            return reg;
+        }
+    }
     for (i = 0; i < ARRAY_SIZE(tcg_target_reg_alloc_order); i++) {
         reg = tcg_target_reg_alloc_order[i];
         if (tcg_regset_test_reg(reg_ct, reg)) {
@@ -1276,12 +1755,12 @@ static void temp_save(TCGContext *s, int temp, TCGRegSet allocated_regs)
             ts->val_type = TEMP_VAL_MEM;
             break;
         case TEMP_VAL_CONST:
-            reg = tcg_reg_alloc(s, tcg_target_available_regs[ts->type], allocated_regs);
+            reg = tcg_reg_alloc(s, tcg_target_available_regs[ts->type], allocated_regs, 0);
             if (!ts->mem_allocated) {
                 temp_allocate_frame(s, temp);
             }
             tcg_out_movi(s, ts->type, reg, ts->val);
-            tcg_out_st(s, ts->type, reg, ts->mem_reg, ts->mem_offset);
+            temp_store(s, ts, reg);
             ts->val_type = TEMP_VAL_MEM;
             break;
         case TEMP_VAL_MEM:
@@ -1304,6 +1783,61 @@ static void save_globals(TCGContext *s, TCGRegSet allocated_regs)
     }
 }
 
+/* store a temporary to memory, keeping it in its register if it is
+   held in one */
+static void temp_sync(TCGContext *s, int temp, TCGRegSet allocated_regs)
+{
+    TCGTemp *ts;
+
+    ts = &s->temps[temp];
+    if (ts->fixed_reg) {
+        return;
+    }
+    if (ts->val_type == TEMP_VAL_REG) {
+        if (!ts->mem_coherent) {
+            if (!ts->mem_allocated) {
+                temp_allocate_frame(s, temp);
+            }
+            temp_store(s, ts, ts->reg);
+            ts->mem_coherent = 1;
+        }
+    } else {
+        temp_save(s, temp, allocated_regs);
+    }
+}
+
+/* store globals to their canonical location, keeping the ones held in
+   registers there */
+static void sync_globals(TCGContext *s, TCGRegSet allocated_regs)
+{
+    int i;
+
+    for (i = 0; i < s->nb_globals; i++) {
+        temp_sync(s, i, allocated_regs);
+    }
+}
+
+/* forget the temps the liveness analysis found dead at a branch or a
+   label, they need not be stored */
+static void tcg_reg_alloc_dead_temps(TCGContext *s, const uint8_t *dead_temps)
+{
+    TCGTemp *ts;
+    int i;
+
+    if (dead_temps == NULL) {
+        return;
+    }
+    for (i = 0; i < s->nb_temps; i++) {
+        ts = &s->temps[i];
+        if (dead_temps[i] && !ts->fixed_reg) {
+            if (ts->val_type == TEMP_VAL_REG) {
+                s->reg_to_temp[ts->reg] = -1;
+            }
+            ts->val_type = TEMP_VAL_DEAD;
+        }
+    }
+}
+
 /* at the end of a basic block, we assume all temporaries are dead and
    all globals are stored at their canonical location. */
 static void tcg_reg_alloc_bb_end(TCGContext *s, TCGRegSet allocated_regs)
@@ -1326,6 +1860,107 @@ static void tcg_reg_alloc_bb_end(TCGContext *s, TCGRegSet allocated_regs)
     save_globals(s, allocated_regs);
 }
 
+/* Like tcg_reg_alloc_bb_end, but the globals held in registers stay
+   there, in sync with memory. Local temps are often dead by then, so
+   they give their registers up. */
+static void tcg_reg_sync_bb_end(TCGContext *s, TCGRegSet allocated_regs)
+{
+    TCGTemp *ts;
+    int i;
+
+    for (i = s->nb_globals; i < s->nb_temps; i++) {
+        ts = &s->temps[i];
+        if (ts->temp_local) {
+            temp_save(s, i, allocated_regs);
+        } else {
+            if (ts->val_type == TEMP_VAL_REG) {
+                s->reg_to_temp[ts->reg] = -1;
+            }
+            ts->val_type = TEMP_VAL_DEAD;
+        }
+    }
+
+    sync_globals(s, allocated_regs);
+}
+
+/* At a branch, everything is stored to memory and the code after a
+   conditional branch keeps the register copies of the globals. A label
+   no later branch jumps to keeps the copies common to all the branches
+   to it and to the code falling through. */
+static void tcg_reg_alloc_branch(TCGContext *s, TCGOpcode opc, const TCGArg *args, TCGRegSet allocated_regs,
+                                 const uint8_t *dead_temps)
+{
+    TCGLabel *l;
+    int label_index, reg;
+
+    tcg_reg_alloc_dead_temps(s, dead_temps);
+    label_index = tcg_op_branch_label(opc, args);
+    if (label_index < 0) {
+        tcg_reg_alloc_bb_end(s, allocated_regs);
+        s->reg_state_unreachable = opc != INDEX_op_goto_tb;
+        return;
+    }
+    tcg_reg_sync_bb_end(s, allocated_regs);
+
+    l = &s->labels[label_index];
+    if (!l->back_ref) {
+        if (l->reg_state == NULL) {
+            l->reg_state = tcg_malloc(sizeof(int) * TCG_TARGET_NB_REGS);
+            memcpy(l->reg_state, s->reg_to_temp, sizeof(int) * TCG_TARGET_NB_REGS);
+        } else {
+            for (reg = 0; reg < TCG_TARGET_NB_REGS; reg++) {
+                if (l->reg_state[reg] != s->reg_to_temp[reg]) {
+                    l->reg_state[reg] = -1;
+                }
+            }
+        }
+    }
+
+    if (opc == INDEX_op_br) {
+        tcg_reg_alloc_bb_end(s, allocated_regs);
+        s->reg_state_unreachable = 1;
+    }
+}
+
+static void tcg_reg_alloc_label(TCGContext *s, int label_index, const uint8_t *dead_temps)
+{
+    TCGLabel *l;
+    TCGTemp *ts;
+    int reg, temp;
+
+    tcg_reg_alloc_dead_temps(s, dead_temps);
+    l = &s->labels[label_index];
+    if (l->back_ref) {
+        tcg_reg_alloc_bb_end(s, s->reserved_regs);
+    } else if (!s->reg_state_unreachable) {
+        tcg_reg_sync_bb_end(s, s->reserved_regs);
+        if (l->reg_state != NULL) {
+            for (reg = 0; reg < TCG_TARGET_NB_REGS; reg++) {
+                temp = s->reg_to_temp[reg];
+                if (temp != -1 && l->reg_state[reg] != temp) {
+                    s->temps[temp].val_type = TEMP_VAL_MEM;
+                    s->reg_to_temp[reg] = -1;
+                }
+            }
+        }
+    } else {
+        tcg_reg_alloc_bb_end(s, s->reserved_regs);
+        if (l->reg_state != NULL) {
+            for (reg = 0; reg < TCG_TARGET_NB_REGS; reg++) {
+                temp = l->reg_state[reg];
+                if (temp != -1 && (dead_temps == NULL || !dead_temps[temp])) {
+                    ts = &s->temps[temp];
+                    ts->val_type = TEMP_VAL_REG;
+                    ts->reg = reg;
+                    ts->mem_coherent = 1;
+                    s->reg_to_temp[reg] = temp;
+                }
+            }
+        }
+    }
+    s->reg_state_unreachable = 0;
+}
+
 #define IS_DEAD_ARG(n) ((dead_args >> (n)) & 1)
 
 static void tcg_reg_alloc_movi(TCGContext *s, const TCGArg *args)
@@ -1350,7 +1985,8 @@ static void tcg_reg_alloc_movi(TCGContext *s, const TCGArg *args)
     }
 }
 
-static void tcg_reg_alloc_mov(TCGContext *s, const TCGOpDef *def, const TCGArg *args, unsigned int dead_args)
+static void tcg_reg_alloc_mov(TCGContext *s, const TCGOpDef *def, const TCGArg *args, unsigned int dead_args,
+                              TCGRegSet output_pref)
 {
     TCGTemp *ts, *ots;
     int reg;
@@ -1374,7 +2010,7 @@ static void tcg_reg_alloc_mov(TCGContext *s, const TCGOpDef *def, const TCGArg *
             if (ots->val_type == TEMP_VAL_REG) {
                 reg = ots->reg;
             } else {
-                reg = tcg_reg_alloc(s, arg_ct->u.regs, s->reserved_regs);
+                reg = tcg_reg_alloc(s, arg_ct->u.regs, s->reserved_regs, output_pref);
             }
             if (ts->reg != reg) {
                 tcg_out_mov(s, ots->type, reg, ts->reg);
@@ -1384,9 +2020,9 @@ static void tcg_reg_alloc_mov(TCGContext *s, const TCGOpDef *def, const TCGArg *
         if (ots->val_type == TEMP_VAL_REG) {
             reg = ots->reg;
         } else {
-            reg = tcg_reg_alloc(s, arg_ct->u.regs, s->reserved_regs);
+            reg = tcg_reg_alloc(s, arg_ct->u.regs, s->reserved_regs, output_pref);
         }
-        tcg_out_ld(s, ts->type, reg, ts->mem_reg, ts->mem_offset);
+        temp_load(s, ts, reg);
     } else if (ts->val_type == TEMP_VAL_CONST) {
         if (ots->fixed_reg) {
             reg = ots->reg;
@@ -1409,9 +2045,10 @@ static void tcg_reg_alloc_mov(TCGContext *s, const TCGOpDef *def, const TCGArg *
     ots->mem_coherent = 0;
 }
 
-static void tcg_reg_alloc_op(TCGContext *s, const TCGOpDef *def, TCGOpcode opc, const TCGArg *args, unsigned int dead_args)
+static void tcg_reg_alloc_op(TCGContext *s, const TCGOpDef *def, TCGOpcode opc, const TCGArg *args, unsigned int dead_args,
+                             const TCGRegSet *output_pref, const uint8_t *dead_temps)
 {
-    TCGRegSet allocated_regs;
+    TCGRegSet allocated_regs, pref;
     int i, k, nb_iargs, nb_oargs, reg;
     TCGArg arg;
     const TCGArgConstraint *arg_ct;
@@ -1432,9 +2069,15 @@ static void tcg_reg_alloc_op(TCGContext *s, const TCGOpDef *def, TCGOpcode opc,
         arg = args[i];
         arg_ct = &def->args_ct[i];
         ts = &s->temps[arg];
+        /* an input that dies here and shares the register of an output
+           is best placed where the output is wanted */
+        tcg_regset_clear(pref);
+        if ((arg_ct->ct & TCG_CT_IALIAS) && IS_DEAD_ARG(i) && arg_ct->alias_index < TCG_MAX_OUTPUT_PREFS) {
+            pref = output_pref[arg_ct->alias_index];
+        }
         if (ts->val_type == TEMP_VAL_MEM) {
-            reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs);
-            tcg_out_ld(s, ts->type, reg, ts->mem_reg, ts->mem_offset);
+            reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs, pref);
+            temp_load(s, ts, reg);
             ts->val_type = TEMP_VAL_REG;
             ts->reg = reg;
             ts->mem_coherent = 1;
@@ -1447,7 +2090,7 @@ static void tcg_reg_alloc_op(TCGContext *s, const TCGOpDef *def, TCGOpcode opc,
                 goto iarg_end;
             } else {
                 /* need to move to a register */
-                reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs);
+                reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs, pref);
                 tcg_out_movi(s, ts->type, reg, ts->val);
                 ts->val_type = TEMP_VAL_REG;
                 ts->reg = reg;
@@ -1479,7 +2122,10 @@ static void tcg_reg_alloc_op(TCGContext *s, const TCGOpDef *def, TCGOpcode opc,
 allocate_in_reg:
             /* allocate a new register matching the constraint
                and move the temporary register into it */
-            reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs);
+            if (arg_ct->ct & TCG_CT_IALIAS && arg_ct->alias_index < TCG_MAX_OUTPUT_PREFS) {
+                pref = output_pref[arg_ct->alias_index];
+            }
+            reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs, pref);
             tcg_out_mov(s, ts->type, reg, ts->reg);
         }
         new_args[i] = reg;
@@ -1489,7 +2135,7 @@ iarg_end:;
     }
 
     if (def->flags & TCG_OPF_BB_END) {
-        tcg_reg_alloc_bb_end(s, allocated_regs);
+        tcg_reg_alloc_branch(s, opc, args, allocated_regs, dead_temps);
     } else {
         /* mark dead temporaries and free the associated registers */
         for (i = nb_oargs; i < nb_oargs + nb_iargs; i++) {
@@ -1535,7 +2181,7 @@ iarg_end:;
                 if (ts->fixed_reg && tcg_regset_test_reg(arg_ct->u.regs, reg)) {
                     goto oarg_end;
                 }
-                reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs);
+                reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs, i < TCG_MAX_OUTPUT_PREFS ? output_pref[i] : 0);
             }
             tcg_regset_set_reg(allocated_regs, reg);
             /* if a fixed register is used, then a move will be done afterwards */
@@ -1622,12 +2268,12 @@ static int tcg_reg_alloc_call(TCGContext *s, const TCGOpDef *def, TCGOpcode opc,
             if (ts->val_type == TEMP_VAL_REG) {
                 tcg_out_st(s, ts->type, ts->reg, TCG_REG_CALL_STACK, stack_offset);
             } else if (ts->val_type == TEMP_VAL_MEM) {
-                reg = tcg_reg_alloc(s, tcg_target_available_regs[ts->type], s->reserved_regs);
+                reg = tcg_reg_alloc(s, tcg_target_available_regs[ts->type], s->reserved_regs, 0);
                 /* XXX: not correct if reading values from the stack */
-                tcg_out_ld(s, ts->type, reg, ts->mem_reg, ts->mem_offset);
+                temp_load(s, ts, reg);
                 tcg_out_st(s, ts->type, reg, TCG_REG_CALL_STACK, stack_offset);
             } else if (ts->val_type == TEMP_VAL_CONST) {
-                reg = tcg_reg_alloc(s, tcg_target_available_regs[ts->type], s->reserved_regs);
+                reg = tcg_reg_alloc(s, tcg_target_available_regs[ts->type], s->reserved_regs, 0);
                 /* XXX: sign extend may be needed on some targets */
                 tcg_out_movi(s, ts->type, reg, ts->val);
                 tcg_out_st(s, ts->type, reg, TCG_REG_CALL_STACK, stack_offset);
@@ -1647,13 +2293,15 @@ static int tcg_reg_alloc_call(TCGContext *s, const TCGOpDef *def, TCGOpcode opc,
         if (arg != TCG_CALL_DUMMY_ARG) {
             ts = &s->temps[arg];
             reg = tcg_target_call_iarg_regs[i];
-            tcg_reg_free(s, reg);
+            if (ts->val_type != TEMP_VAL_REG || ts->reg != reg) {
+                tcg_reg_free(s, reg);
+            }
             if (ts->val_type == TEMP_VAL_REG) {
                 if (ts->reg != reg) {
                     tcg_out_mov(s, ts->type, reg, ts->reg);
                 }
             } else if (ts->val_type == TEMP_VAL_MEM) {
-                tcg_out_ld(s, ts->type, reg, ts->mem_reg, ts->mem_offset);
+                temp_load(s, ts, reg);
             } else if (ts->val_type == TEMP_VAL_CONST) {
                 /* XXX: sign extend ? */
                 tcg_out_movi(s, ts->type, reg, ts->val);
@@ -1671,14 +2319,14 @@ static int tcg_reg_alloc_call(TCGContext *s, const TCGOpDef *def, TCGOpcode opc,
     func_addr = ts->val;
     const_func_arg = 0;
     if (ts->val_type == TEMP_VAL_MEM) {
-        reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs);
-        tcg_out_ld(s, ts->type, reg, ts->mem_reg, ts->mem_offset);
+        reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs, 0);
+        temp_load(s, ts, reg);
         func_arg = reg;
         tcg_regset_set_reg(allocated_regs, reg);
     } else if (ts->val_type == TEMP_VAL_REG) {
         reg = ts->reg;
         if (!tcg_regset_test_reg(arg_ct->u.regs, reg)) {
-            reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs);
+            reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs, 0);
             tcg_out_mov(s, ts->type, reg, ts->reg);
         }
         func_arg = reg;
@@ -1688,7 +2336,7 @@ static int tcg_reg_alloc_call(TCGContext *s, const TCGOpDef *def, TCGOpcode opc,
             const_func_arg = 1;
             func_arg = func_addr;
         } else {
-            reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs);
+            reg = tcg_reg_alloc(s, arg_ct->u.regs, allocated_regs, 0);
             tcg_out_movi(s, ts->type, reg, func_addr);
             func_arg = reg;
             tcg_regset_set_reg(allocated_regs, reg);
@@ -1719,8 +2367,13 @@ static int tcg_reg_alloc_call(TCGContext *s, const TCGOpDef *def, TCGOpcode opc,
     }
 
     /* store globals and free associated registers (we assume the call
-       can modify any global. */
-    if (!(flags & TCG_CALL_CONST)) {
+       can modify any global), or only store them if the call cannot
+       modify them */
+    if (flags & TCG_CALL_NO_READ_GLOBALS) {
+        /* nothing to do */
+    } else if (flags & TCG_CALL_NO_WRITE_GLOBALS) {
+        sync_globals(s, allocated_regs);
+    } else {
         save_globals(s, allocated_regs);
     }
 
@@ -1754,6 +2407,25 @@ static int tcg_reg_alloc_call(TCGContext *s, const TCGOpDef *def, TCGOpcode opc,
     return nb_iargs + nb_oargs + def->nb_cargs + 1;
 }
 
+#ifdef TCG_TARGET_NEED_LDST_LABELS
+/* Emit the TLB miss paths of the block's guest memory accesses. A host
+   pc inside one of them belongs to the operation of its access. */
+static int tcg_out_ldst_finalize(TCGContext *s, uint8_t *gen_code_buf, uintptr_t search_pc)
+{
+    TCGLabelQemuLdst *l;
+    uint8_t *start = s->code_ptr;
+
+    for (l = s->ldst_labels; l != NULL; l = l->next) {
+        tcg_out_qemu_ldst_slow_path(s, l);
+        if (search_pc < s->code_ptr - gen_code_buf) {
+            return l->op_index;
+        }
+    }
+    s->code_slow_path_size = s->code_ptr - start;
+    return -1;
+}
+#endif
+
 static inline int tcg_gen_code_common(TCGContext *s, uint8_t *gen_code_buf, uintptr_t search_pc)
 {
     TCGOpcode opc;
@@ -1762,16 +2434,40 @@ static inline int tcg_gen_code_common(TCGContext *s, uint8_t *gen_code_buf, uint
     unsigned int dead_args;
     const TCGArg *args;
 
+    if (unlikely(s->dump_flags & TCG_DUMP_IR)) {
+        fprintf(s->dump_file, "IR:\n");
+        tcg_dump_ops(s, s->dump_file);
+    }
+
 #ifdef USE_TCG_OPTIMIZATIONS
     gen_opparam_ptr =
         tcg_optimize(s, gen_opc_ptr, tcg->gen_opparam_buf, tcg_op_defs);
+    if (unlikely(s->dump_flags & TCG_DUMP_IR_OPT)) {
+        fprintf(s->dump_file, "IR after optimization:\n");
+        tcg_dump_ops(s, s->dump_file);
+    }
 #endif
 
     tcg_liveness_analysis(s);
+    if (unlikely(s->dump_flags & TCG_DUMP_LIVENESS)) {
+        fprintf(s->dump_file, "IR after liveness analysis:\n");
+        tcg_dump_ops_common(s, s->dump_file, 1);
+    }
+    /* the flags are set for one block at a time, see tb_dump_begin */
+    s->dump_flags = 0;
 
     tcg_reg_alloc_start(s);
     s->code_buf = gen_code_buf;
     s->code_ptr = gen_code_buf;
+    s->code_slow_path_size = 0;
+    s->reg_spills = 0;
+    s->reg_reloads = 0;
+    s->reg_state_unreachable = 0;
+    s->vec_256_used = 0;
+#ifdef TCG_TARGET_NEED_LDST_LABELS
+    s->ldst_labels = NULL;
+    s->ldst_labels_tail = &s->ldst_labels;
+#endif
 
     args = tcg->gen_opparam_buf;
     op_index = 0;
@@ -1784,8 +2480,9 @@ static inline int tcg_gen_code_common(TCGContext *s, uint8_t *gen_code_buf, uint
 #if TCG_TARGET_REG_BITS == 64
         case INDEX_op_mov_i64:
 #endif
+        case INDEX_op_mov_vec:
             dead_args = s->op_dead_args[op_index];
-            tcg_reg_alloc_mov(s, def, args, dead_args);
+            tcg_reg_alloc_mov(s, def, args, dead_args, s->op_output_pref[op_index * TCG_MAX_OUTPUT_PREFS]);
             break;
         case INDEX_op_movi_i32:
 #if TCG_TARGET_REG_BITS == 64
@@ -1815,8 +2512,8 @@ static inline int tcg_gen_code_common(TCGContext *s, uint8_t *gen_code_buf, uint
         }
         break;
         case INDEX_op_set_label:
-            tcg_reg_alloc_bb_end(s, s->reserved_regs);
-            tcg_out_label(s, args[0], (uintptr_t)s->code_ptr);
+            tcg_reg_alloc_label(s, args[0], s->op_dead_temps[op_index]);
+            tcg_out_label(s, args[0], (uintptr_t)tcg_code_rx(s->code_ptr));
             break;
         case INDEX_op_call:
             dead_args = s->op_dead_args[op_index];
@@ -1833,7 +2530,11 @@ static inline int tcg_gen_code_common(TCGContext *s, uint8_t *gen_code_buf, uint
                faster to have specialized register allocator functions for
                some common argument patterns */
             dead_args = s->op_dead_args[op_index];
-            tcg_reg_alloc_op(s, def, opc, args, dead_args);
+#ifdef TCG_TARGET_NEED_LDST_LABELS
+            s->current_op_index = op_index;
+#endif
+            tcg_reg_alloc_op(s, def, opc, args, dead_args, &s->op_output_pref[op_index * TCG_MAX_OUTPUT_PREFS],
+                             def->flags & TCG_OPF_BB_END ? s->op_dead_temps[op_index] : NULL);
             break;
         }
         args += def->nb_args;
@@ -1844,7 +2545,11 @@ next:
         op_index++;
     }
 the_end:
+#ifdef TCG_TARGET_NEED_LDST_LABELS
+    return tcg_out_ldst_finalize(s, gen_code_buf, search_pc);
+#else
     return -1;
+#endif
 }
 
 int tcg_gen_code(TCGContext *s, uint8_t *gen_code_buf)
@@ -1852,7 +2557,7 @@ int tcg_gen_code(TCGContext *s, uint8_t *gen_code_buf)
     tcg_gen_code_common(s, gen_code_buf, -1);
 
     /* flush instruction cache */
-    flush_icache_range((uintptr_t)gen_code_buf, (uintptr_t)s->code_ptr);
+    flush_icache_range((uintptr_t)tcg_code_rx(gen_code_buf), (uintptr_t)tcg_code_rx(s->code_ptr));
     return s->code_ptr -  gen_code_buf;
 }
 
@@ -22,6 +22,9 @@
  * THE SOFTWARE.
  */
 
+#ifndef __TCG_H__
+#define __TCG_H__
+
 /// INSTEAD OF QEMU-COMMON
 #ifndef TARGET_PAGE_BITS
 extern int TARGET_PAGE_BITS;
@@ -121,10 +124,25 @@ typedef uint64_t TCGRegSet;
 #define TCG_TARGET_HAS_deposit_i64 0
 #define TCG_TARGET_HAS_mulu2_i64   0
 #define TCG_TARGET_HAS_muls2_i64   0
+#define TCG_TARGET_HAS_movcond_i64 0
+#define TCG_TARGET_HAS_clz_i64     0
+#define TCG_TARGET_HAS_ctz_i64     0
+#define TCG_TARGET_HAS_ctpop_i64   0
+#define TCG_TARGET_HAS_extract_i64 0
+#define TCG_TARGET_HAS_sextract_i64 0
 /* Turn some undef macros into true macros.  */
 #define TCG_TARGET_HAS_mulu2_i32   1
 #endif
 
+/* Hosts without vector registers expand the vector operations of
+   tcg-op-gvec.h into integer ones. */
+#ifndef TCG_TARGET_MAYBE_vec
+#define TCG_TARGET_MAYBE_vec       0
+#define TCG_TARGET_HAS_v64         0
+#define TCG_TARGET_HAS_v128        0
+#define TCG_TARGET_HAS_v256        0
+#endif
+
 #ifndef TCG_TARGET_deposit_i32_valid
 #define TCG_TARGET_deposit_i32_valid(ofs, len) 1
 #endif
@@ -175,8 +193,29 @@ typedef struct TCGLabel {
         tcg_target_ulong value;
         TCGRelocation *first_reloc;
     } u;
+    /* set by the liveness analysis if a branch to the label follows it */
+    int back_ref;
+    /* the temp each register held at all the branches to the label seen
+       so far, -1 where they differ; NULL before the first branch */
+    int *reg_state;
 } TCGLabel;
 
+#ifdef TCG_TARGET_NEED_LDST_LABELS
+/* A guest memory access whose TLB miss path is emitted after the block */
+typedef struct TCGLabelQemuLdst {
+    struct TCGLabelQemuLdst *next;
+    int is_ld;
+    int opc;                /* as passed to tcg_out_qemu_ld/st */
+    int datalo_reg;
+    int datahi_reg;
+    int addrhi_reg;
+    int mem_index;
+    uint8_t *label_ptr[2];  /* branches from the fast path to patch */
+    uint8_t *raddr;         /* where the miss path returns to */
+    int op_index;           /* of the access, for tcg_gen_code_search_pc */
+} TCGLabelQemuLdst;
+#endif
+
 typedef struct TCGPool {
     struct TCGPool *next;
     int size;
@@ -185,9 +224,14 @@ typedef struct TCGPool {
 
 #define TCG_POOL_CHUNK_SIZE       32768
 
-#define TCG_MAX_LABELS            512
+#define TCG_MAX_OUTPUT_PREFS      2
+
+/* labels and temps start with room for this many and grow on demand */
+#define TCG_INITIAL_LABELS        64
+#define TCG_INITIAL_TEMPS         512
 
-#define TCG_MAX_TEMPS             512
+/* the optimizer links copies of a temp with 16-bit indexes */
+#define TCG_MAX_TEMPS             0xffff
 
 /* when the size of the arguments of a called function is smaller than
    this value, they are statically allocated in the TB stack frame */
@@ -196,6 +240,10 @@ typedef struct TCGPool {
 typedef enum TCGType {
     TCG_TYPE_I32,
     TCG_TYPE_I64,
+    /* vectors of 8, 16 and 32 bytes, see the *_vec operations */
+    TCG_TYPE_V64,
+    TCG_TYPE_V128,
+    TCG_TYPE_V256,
     TCG_TYPE_COUNT, /* number of different types */
 
     /* An alias for the size of the host register.  */
@@ -219,6 +267,14 @@ typedef enum TCGType {
 
 typedef tcg_target_ulong TCGArg;
 
+/* Size of the elements of a vector operation, log2 of their bytes */
+typedef enum {
+    VECE_8,
+    VECE_16,
+    VECE_32,
+    VECE_64,
+} TCGVecElem;
+
 /* Define a type and accessor macros for variables.  Using a struct is
    nice because it gives some level of type safely.  Ideally the compiler
    be able to see through all this.  However in practice this is not true,
@@ -233,6 +289,7 @@ typedef tcg_target_ulong TCGArg;
 
 typedef int TCGv_i32;
 typedef int TCGv_i64;
+typedef int TCGv_vec;
 #if TCG_TARGET_REG_BITS == 32
 #define TCGv_ptr TCGv_i32
 #else
@@ -241,9 +298,11 @@ typedef int TCGv_i64;
 #define MAKE_TCGV_I32(x)     (x)
 #define MAKE_TCGV_I64(x)     (x)
 #define MAKE_TCGV_PTR(x)     (x)
+#define MAKE_TCGV_VEC(x)     (x)
 #define GET_TCGV_I32(t)      (t)
 #define GET_TCGV_I64(t)      (t)
 #define GET_TCGV_PTR(t)      (t)
+#define GET_TCGV_VEC(t)      (t)
 
 #if TCG_TARGET_REG_BITS == 32
 #define TCGV_LOW(t)          (t)
@@ -263,14 +322,27 @@ typedef int TCGv_i64;
 #define TCG_CALL_TYPE_REGPARM_1 0x0001 /* i386 style regparm call (1 reg) */
 #define TCG_CALL_TYPE_REGPARM_2 0x0002 /* i386 style regparm call (2 regs) */
 #define TCG_CALL_TYPE_REGPARM   0x0003 /* i386 style regparm call (3 regs) */
-/* A pure function only reads its arguments and TCG global variables
-   and cannot raise exceptions. Hence a call to a pure function can be
-   safely suppressed if the return value is not used. */
-#define TCG_CALL_PURE           0x0010
-/* A const function only reads its arguments and does not use TCG
-   global variables. Hence a call to such a function does not
-   save TCG global variables back to their canonical location. */
-#define TCG_CALL_CONST          0x0020
+/* Helper side effects. A helper that can raise an exception reads the
+   TCG globals through the CPU state restored by the exception, so it may
+   be declared TCG_CALL_NO_WRITE_GLOBALS at most. */
+/* The call can be suppressed if its return value is not used: it does
+   not write any state and cannot raise exceptions. */
+#define TCG_CALL_NO_SIDE_EFFECTS  0x0010
+/* The helper neither reads nor writes TCG globals, which hence are not
+   stored back to their canonical location before the call. */
+#define TCG_CALL_NO_READ_GLOBALS  0x0020
+/* The helper may read TCG globals but does not write them. The globals
+   are stored back before the call but stay in their registers. */
+#define TCG_CALL_NO_WRITE_GLOBALS 0x0040
+
+#define TCG_CALL_NO_RWG    TCG_CALL_NO_READ_GLOBALS
+#define TCG_CALL_NO_WG     TCG_CALL_NO_WRITE_GLOBALS
+#define TCG_CALL_NO_RWG_SE (TCG_CALL_NO_RWG | TCG_CALL_NO_SIDE_EFFECTS)
+#define TCG_CALL_NO_WG_SE  (TCG_CALL_NO_WG | TCG_CALL_NO_SIDE_EFFECTS)
+
+/* former names */
+#define TCG_CALL_PURE      TCG_CALL_NO_SIDE_EFFECTS
+#define TCG_CALL_CONST     TCG_CALL_NO_READ_GLOBALS
 
 /* used to align parameters */
 #define TCG_CALL_DUMMY_TCGV     MAKE_TCGV_I32(-1)
@@ -308,6 +380,16 @@ static inline TCGCond tcg_unsigned_cond(TCGCond c)
     return (c >= TCG_COND_LT && c <= TCG_COND_GT ? c + 4 : c);
 }
 
+/* Argument of the mb op: the pairs of guest accesses, earlier one first,
+   which must not be reordered across the barrier. */
+typedef enum {
+    TCG_MO_LD_LD = 0x01,
+    TCG_MO_ST_LD = 0x02,
+    TCG_MO_LD_ST = 0x04,
+    TCG_MO_ST_ST = 0x08,
+    TCG_MO_ALL   = 0x0f,
+} TCGBar;
+
 #define TEMP_VAL_DEAD  0
 #define TEMP_VAL_REG   1
 #define TEMP_VAL_MEM   2
@@ -339,28 +421,43 @@ typedef struct TCGHelperInfo {
     const char *name;
 } TCGHelperInfo;
 
+/* dump_flags of TCGContext */
+#define TCG_DUMP_IR       (1 << 0) /* the ops as generated by the front end */
+#define TCG_DUMP_IR_OPT   (1 << 1) /* the ops after tcg_optimize */
+#define TCG_DUMP_LIVENESS (1 << 2) /* the ops after tcg_liveness_analysis, with
+                                      its annotations */
+
 typedef struct TCGContext TCGContext;
 
 struct TCGContext {
     uint8_t *pool_cur, *pool_end;
-    TCGPool *pool_first, *pool_current;
+    TCGPool *pool_first, *pool_current, *pool_first_large;
     TCGLabel *labels;
     int nb_labels;
+    int allocated_labels;
     TCGTemp *temps; /* globals first, temps after */
     int nb_globals;
     int nb_temps;
+    int allocated_temps;
     /* index of free temps, -1 if none */
     int first_free_temp[TCG_TYPE_COUNT * 2];
 
     /* goto_tb support */
     uint8_t *code_buf;
     uintptr_t *tb_next;
-    uint16_t *tb_next_offset;
-    uint16_t *tb_jmp_offset;
+    uint32_t *tb_next_offset;
+    uint32_t *tb_jmp_offset;
 
     /* liveness analysis */
     uint16_t *op_dead_args; /* for each operation, each bit tells if the
                                corresponding argument is dead */
+    TCGRegSet *op_output_pref; /* for each operation, the registers its
+                                  first TCG_MAX_OUTPUT_PREFS outputs are
+                                  next used in, empty if any will do */
+    uint8_t **op_dead_temps; /* for each branch and label, the temps
+                                dead after it, NULL if all may be live */
+    /* the operation being allocated follows an unconditional jump */
+    int reg_state_unreachable;
 
     /* tells in which temporary a given register is. It does not take
        into account fixed registers */
@@ -372,7 +469,30 @@ struct TCGContext {
     int frame_reg;
 
     uint8_t *code_ptr;
-    TCGTemp static_temps[TCG_MAX_TEMPS];
+
+    /* bytes of the last generated block placed after its body */
+    int code_slow_path_size;
+    /* temps stored to and loaded from memory by the register allocator
+       in the last generated block */
+    int reg_spills;
+    int reg_reloads;
+
+    /* the CPU state, which the tcg_gen_gvec_* operations work on */
+    TCGv_ptr env;
+    /* set by the backend once it emitted a 256-bit vector operation in
+       the block being generated */
+    int vec_256_used;
+
+    /* TCG_DUMP_* parts of the block being generated to write to
+       dump_file, 0 for none */
+    int dump_flags;
+    FILE *dump_file;
+
+#ifdef TCG_TARGET_NEED_LDST_LABELS
+    TCGLabelQemuLdst *ldst_labels;
+    TCGLabelQemuLdst **ldst_labels_tail;
+    int current_op_index;
+#endif
 
     TCGHelperInfo *helpers;
     int nb_helpers;
@@ -409,7 +529,12 @@ typedef struct tcg_t {
     TCGContext *ctx;
     uint16_t *gen_opc_buf;
     TCGArg *gen_opparam_buf;
+    /* in ops, gen_opparam_buf has MAX_OPC_PARAM entries per op */
+    int gen_opc_buf_size;
     uint8_t *code_gen_prologue;
+    /* distance from the executable view of the code buffer to its
+       writable alias; 0 when the buffer is mapped only once */
+    intptr_t code_gen_rw_offset;
     target_ulong *gen_opc_pc;
     target_ulong *gen_opc_additional;
     uint8_t *gen_opc_instr_start;
@@ -427,6 +552,18 @@ extern tcg_t *tcg;
 
 void tcg_attach(tcg_t *con);
 
+/* Code is emitted through the writable view (s->code_ptr), branch
+   displacements and label values refer to the executable one. */
+static inline uint8_t *tcg_code_rx(const uint8_t *rw)
+{
+    return (uint8_t *)rw - tcg->code_gen_rw_offset;
+}
+
+static inline uint8_t *tcg_code_rw(const uint8_t *rx)
+{
+    return (uint8_t *)rx + tcg->code_gen_rw_offset;
+}
+
 static inline void *tcg_malloc(int size)
 {
     TCGContext *s = tcg->ctx;
@@ -446,6 +583,7 @@ void tcg_context_init();
 void tcg_dispose();
 void tcg_prologue_init();
 void tcg_func_start(TCGContext *s);
+int tcg_op_buf_reserve(int count, int max_ops);
 
 int tcg_gen_code(TCGContext *s, uint8_t *gen_code_buf);
 int tcg_gen_code_search_pc(TCGContext *s, uint8_t *gen_code_buf, uintptr_t offset);
@@ -480,6 +618,14 @@ static inline TCGv_i64 tcg_temp_local_new_i64(void)
 void tcg_temp_free_i64(TCGv_i64 arg);
 char *tcg_get_arg_str_i64(TCGContext *s, char *buf, int buf_size, TCGv_i64 arg);
 
+/* type is one of TCG_TYPE_V64, TCG_TYPE_V128 and TCG_TYPE_V256 */
+TCGv_vec tcg_temp_new_vec(TCGType type);
+void tcg_temp_free_vec(TCGv_vec arg);
+
+/* Whether the host implements vector operation 'opc' on elements of
+   size 'vece', see tcg-opc.h for the ones it may refuse */
+int tcg_can_emit_vec_op(TCGOpcode opc, TCGType type, unsigned vece);
+
 static inline bool tcg_arg_is_local(TCGContext *s, TCGArg arg)
 {
     return s->temps[arg].temp_local;
@@ -516,6 +662,8 @@ enum {
     TCG_OPF_64BIT        = 0x08,
     /* Instruction is optional and not implemented by the host.  */
     TCG_OPF_NOT_PRESENT  = 0x10,
+    /* Instruction operands are vectors, see tcg-opc.h for their type.  */
+    TCG_OPF_VECTOR       = 0x20,
 };
 
 typedef struct TCGOpDef {
@@ -598,3 +746,5 @@ static inline bool tcg_op_buf_full(void)
 # define tcg_tb_exec(env, tb_ptr) \
     ((uintptr_t REGPARM (*)(void *, void *))tcg->code_gen_prologue)(env, tb_ptr)
 #endif
+
+#endif